@@ -4,6 +4,30 @@
 //  Description; Toggle P1.1 and P1.2 in complemntary fashion to create a
 //  bipolar current ACLK = n/a, MCLK = SMCLK = default DCO
 //
+//  Two output modes, selected at build time (see the Makefile):
+//
+//  PULSE_MODE_TIMER: the phases come straight from the Timer0_A3 output
+//  units on TA0.1 (P1.1, cathodic) and TA0.2 (P1.2, anodic). The timer runs
+//  in up/down mode from ACLK = REFO = 32768Hz, so every edge lands on a
+//  timer clock edge with no ISR latency, and the CPU sleeps in LPM3 after
+//  a single start-up interrupt. One period, T = 2 * TA0CCR0:
+//
+//      TAR   0 ... CCR2 ... CCR1 ... CCR0 ... CCR1 ... CCR2 ... 0
+//      P1.1  ____________________/‾‾‾‾‾‾‾‾‾‾‾‾‾\___________________
+//      P1.2  ‾‾‾‾‾‾‾‾‾\___________________________________/‾‾‾‾‾‾‾‾‾
+//                      |  gap  |  cathodic     |  gap  |  anodic
+//
+//  CCR1 toggles TA0.1 on the way up and down (toggle/set), CCR2 does the
+//  same for TA0.2 (toggle/reset), so each phase width is twice a compare
+//  distance: widths resolve to 2 timer ticks, the gap to 1 tick. Both
+//  transitions get the same gap, which is never shorter than the dead time.
+//
+//  Otherwise the CPU drives P1.1 and P1.2 as GPIO from a Timer0_A3 CCR0
+//  state machine (ACLK, continuous mode): cathodic, gap, anodic, gap, each
+//  one compare, set by PULSE_FREQ_MILLIHZ and PULSE_DUTY_PERCENT. The CPU
+//  sleeps in LPM3 between edges. Building with PULSE_INSTRUMENT adds a
+//  cycle count of the time spent awake versus in LPM3 (g_pulse_report).
+//
 //                MSP430FR2433
 //             -----------------
 //         /|\|              XIN|-
@@ -11,37 +35,287 @@
 //          --|RST          XOUT|-
 //            |                 |
 //            |             P1.0|-->  LED, DRIVER_ENABLE
-//            |             P1.1|--> DRIVER_CHANNEL_1
-//            |             P1.2|--> DRIVER_CHANNEL_2
+//            |             P1.1|--> DRIVER_CHANNEL_1 (TA0.1)
+//            |             P1.2|--> DRIVER_CHANNEL_2 (TA0.2)
 //  Mohamed Elazab
 //  MetroHealth Research Institute
 //  Mar 2025
 //***************************************************************************************
 
 #include <msp430.h>
+#include <stdint.h>
+
+#ifdef PULSE_MODE_TIMER
+
+#ifdef PULSE_INSTRUMENT
+#error PULSE_INSTRUMENT needs the software mode; timer mode never wakes
+#endif
+
+// Phase timing in microseconds (adjust these values as needed)
+#define CATHODIC_US 500000UL     // DRIVER_CHANNEL_1 high
+#define ANODIC_US 500000UL       // DRIVER_CHANNEL_2 high
+#define INTERPHASE_GAP_US 0UL    // Both channels low between phases
+#define DEAD_TIME_US 100UL       // Shortest gap the H-bridge tolerates
+
+// Timer clock = ACLK / PULSE_CLOCK_DIV; 1, 2, 4, 8, 16, 32 or 64. Raise it
+// for phases longer than about 2 s in total.
+#define PULSE_CLOCK_DIV 1
+
+#define ACLK_HZ 32768ULL
+
+// ID (/1../8) and TAIDEX (/1../8) that make up PULSE_CLOCK_DIV
+#if PULSE_CLOCK_DIV == 1
+#define PULSE_ID ID_0
+#define PULSE_IDEX TAIDEX_0
+#elif PULSE_CLOCK_DIV == 2
+#define PULSE_ID ID_1
+#define PULSE_IDEX TAIDEX_0
+#elif PULSE_CLOCK_DIV == 4
+#define PULSE_ID ID_2
+#define PULSE_IDEX TAIDEX_0
+#elif PULSE_CLOCK_DIV == 8
+#define PULSE_ID ID_3
+#define PULSE_IDEX TAIDEX_0
+#elif PULSE_CLOCK_DIV == 16
+#define PULSE_ID ID_3
+#define PULSE_IDEX TAIDEX_1
+#elif PULSE_CLOCK_DIV == 32
+#define PULSE_ID ID_3
+#define PULSE_IDEX TAIDEX_3
+#elif PULSE_CLOCK_DIV == 64
+#define PULSE_ID ID_3
+#define PULSE_IDEX TAIDEX_7
+#else
+#error PULSE_CLOCK_DIV must be 1, 2, 4, 8, 16, 32 or 64
+#endif
+
+// Compare distances in timer ticks; phases are rounded to the nearest
+// 2 ticks, the dead time is rounded up
+#define TICK_HZ (ACLK_HZ / PULSE_CLOCK_DIV)
+#define HALF_TICKS(us) (((us) * TICK_HZ + 1000000ULL) / 2000000ULL)
+#define GAP_TICKS (((INTERPHASE_GAP_US) * TICK_HZ + 500000ULL) / 1000000ULL)
+#define DEAD_TICKS (((DEAD_TIME_US) * TICK_HZ + 999999ULL) / 1000000ULL)
+#define SPACE_TICKS (GAP_TICKS > DEAD_TICKS ? GAP_TICKS : DEAD_TICKS)
+
+#define ANODIC_CCR HALF_TICKS(ANODIC_US)                  // TA0CCR2
+#define CATHODIC_CCR (ANODIC_CCR + SPACE_TICKS)           // TA0CCR1
+#define PERIOD_CCR (CATHODIC_CCR + HALF_TICKS(CATHODIC_US)) // TA0CCR0
+
+#if HALF_TICKS(CATHODIC_US) < 1 || HALF_TICKS(ANODIC_US) < 1
+#error Phases must be at least 2 timer ticks
+#endif
+#if SPACE_TICKS < 1
+#error Set a dead time: coinciding edges would short the bridge
+#endif
+#if PERIOD_CCR > 0xFFFF
+#error Period does not fit TA0CCR0; raise PULSE_CLOCK_DIV
+#endif
 
 int main(void) {
   WDTCTL = WDTPW | WDTHOLD; // Stop watchdog timer
+  CSCTL4 = SELMS__DCOCLKDIV | SELA__REFOCLK; // ACLK = REFO, no crystal needed
+
+  // P1.0 => DRIVER_ENABLE, P1.1 => TA0.1, P1.2 => TA0.2
+  P1OUT = 0x01;            // DRIVER_ENABLE -> HIGH and light LED
+  P1DIR |= 0x07;           // P1DIR = xxxx x111
+  P1SEL1 |= BIT1 | BIT2;   // Timer outputs instead of GPIO
   PM5CTL0 &= ~LOCKLPM5; // Disable the GPIO power-on default high-impedance mode
                         // to activate previously configured port settings
-  P1DIR |= 0x07; //  Set P1.0, P1.1 & P1.2 as outputs         P1DIR = xxxx x111
-  // P1.0 => DRIVER_ENABLE
-  // P1.1 => DRIVER_CHANNEL_1
-  // P1.2 => DRIVER_CHANNEL_2
-  P1OUT = 0x03;
-  // DRIVER_ENABLE -> HIGH and light LED
-  // DRIVER_CHANNEL_1 -> HIGH
-  // DRIVER_CHANNEL_2 -> LOW
 
+  TA0CCR0 = PERIOD_CCR;
+  TA0CCR1 = CATHODIC_CCR;
+  TA0CCR2 = ANODIC_CCR;
+
+  // Both outputs start low. TA0.1 can take its mode now; TA0.2 would fire
+  // early on the first upward CCR2 match, so it stays on OUT until the first
+  // CCR0 match (TIMER0_A0_ISR).
+  TA0CCTL1 = OUTMOD_0;
+  TA0CCTL2 = OUTMOD_0;
+  TA0CCTL1 = OUTMOD_6; // Toggle/set
+  TA0CCTL0 = CCIE;
+
+  TA0EX0 = PULSE_IDEX;
+  TA0CTL = TASSEL__ACLK | PULSE_ID | MC__UPDOWN | TACLR;
+
+  __bis_SR_register(LPM3_bits | GIE); // Outputs run on their own from here
+  __no_operation();                   // For debugger
+}
+
+// Timer0_A3 CCR0: runs once, at the top of the first period
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector = TIMER0_A0_VECTOR
+__interrupt void TIMER0_A0_ISR(void)
+#elif defined(__GNUC__)
+void __attribute__((interrupt(TIMER0_A0_VECTOR))) TIMER0_A0_ISR(void)
+#else
+#error Compiler not supported!
+#endif
+{
+  TA0CCTL2 = OUTMOD_2; // Toggle/reset; next edge is the downward CCR2 match
+  TA0CCTL0 = 0;        // No further interrupts
+}
+
+#else
+
+// Pulse train (adjust these values as needed)
+#define PULSE_FREQ_MILLIHZ 1000UL // Biphasic pulses per 1000 s
+#define PULSE_DUTY_PERCENT 90UL   // Share of the period spent in the phases
+#define DEAD_TIME_US 100UL        // Shortest gap the H-bridge tolerates
+
+// Windows the instrumentation build averages over, in pulse periods
+#define PULSE_REPORT_PERIODS 10
+
+#define ACLK_HZ 32768ULL
+#define MCLK_HZ 1000000ULL // Default DCOCLKDIV, nominal
+
+// Shortest span the ISR can schedule: LPM3 wake-up plus the ISR itself
+#define MIN_TICKS 4
+
+// Each phase gets half the duty, the two gaps share the rest
+#define PERIOD_TICKS ((ACLK_HZ * 1000ULL + PULSE_FREQ_MILLIHZ / 2) /          \
+                      PULSE_FREQ_MILLIHZ)
+#define PHASE_TICKS (PERIOD_TICKS * PULSE_DUTY_PERCENT / 200ULL)
+#define GAP_TICKS ((PERIOD_TICKS - 2 * PHASE_TICKS) / 2)
+#define LAST_GAP_TICKS (PERIOD_TICKS - 2 * PHASE_TICKS - GAP_TICKS)
+#define DEAD_TICKS (((DEAD_TIME_US) * ACLK_HZ + 999999ULL) / 1000000ULL)
+
+#if PULSE_DUTY_PERCENT > 100
+#error PULSE_DUTY_PERCENT must be at most 100
+#endif
+#if PHASE_TICKS < MIN_TICKS || GAP_TICKS < MIN_TICKS
+#error Phases and gaps must be at least MIN_TICKS; lower the frequency
+#endif
+#if GAP_TICKS < DEAD_TICKS
+#error Gap shorter than the dead time; lower PULSE_DUTY_PERCENT
+#endif
+#if PHASE_TICKS > 0xFFFF || LAST_GAP_TICKS > 0xFFFF
+#error Phase or gap does not fit one TA0CCR0 step; raise the frequency
+#endif
+
+/**
+ * @brief Output state, advanced by one on every CCR0 compare
+ */
+typedef enum {
+  STATE_CATHODIC,
+  STATE_GAP,
+  STATE_ANODIC,
+  STATE_LAST_GAP,
+  STATE_COUNT
+} pulse_state_t;
+
+// Length of each state in ACLK ticks, and the channel it drives
+static const uint16_t g_state_ticks[STATE_COUNT] = {
+    PHASE_TICKS, GAP_TICKS, PHASE_TICKS, LAST_GAP_TICKS};
+static const uint8_t g_state_pins[STATE_COUNT] = {BIT1, 0, BIT2, 0};
+
+static uint8_t g_state = STATE_CATHODIC;
+
+#ifdef PULSE_INSTRUMENT
+
+// Interrupt entry and RETI, which the timestamps inside the ISR miss
+#define ISR_OVERHEAD_CYCLES 11
+
+#define WINDOW_CYCLES                                                          \
+  (PERIOD_TICKS * PULSE_REPORT_PERIODS * MCLK_HZ / ACLK_HZ)
+
+/**
+ * @brief Time the CPU spent awake over the last report window
+ *
+ * Updated every PULSE_REPORT_PERIODS periods; read it from the debugger.
+ * Cycles are counted on Timer1_A3 from SMCLK = MCLK and exclude the
+ * LPM3 wake-up time, so they are a lower bound.
+ */
+typedef struct {
+  uint32_t active_cycles;  // MCLK cycles spent awake in the window
+  uint32_t window_cycles;  // MCLK cycles in the window
+  uint16_t active_permille; // Awake share; the rest was spent in LPM3
+  uint16_t windows;        // Windows reported so far
+} pulse_report_t;
+
+volatile pulse_report_t g_pulse_report = {.window_cycles = WINDOW_CYCLES};
+
+static uint32_t g_active_cycles; // Awake cycles in the current window
+static uint16_t g_isr_cycles;    // Running ISR total, wraps; see main()
+static uint32_t g_window_active; // Last full window, handed to main
+static uint16_t g_window_periods = PULSE_REPORT_PERIODS;
+
+#endif
+
+int main(void) {
+  WDTCTL = WDTPW | WDTHOLD; // Stop watchdog timer
+  CSCTL4 = SELMS__DCOCLKDIV | SELA__REFOCLK; // ACLK = REFO, no crystal needed
+
+  // P1.0 => DRIVER_ENABLE, P1.1 => DRIVER_CHANNEL_1, P1.2 => DRIVER_CHANNEL_2
+  P1OUT = 0x01 | g_state_pins[STATE_CATHODIC]; // Enable, first phase on
+  P1DIR |= 0x07;                               // P1DIR = xxxx x111
+  PM5CTL0 &= ~LOCKLPM5; // Disable the GPIO power-on default high-impedance mode
+                        // to activate previously configured port settings
+
+#ifdef PULSE_INSTRUMENT
+  TA1CTL = TASSEL__SMCLK | MC__CONTINUOUS | TACLR; // Cycle counter
+#endif
+
+  // Every output change is one CCR0 compare, stepped forward from the last
+  // one so ISR latency never accumulates
+  TA0CCR0 = g_state_ticks[STATE_CATHODIC];
+  TA0CCTL0 = CCIE;
+  TA0CTL = TASSEL__ACLK | MC__CONTINUOUS | TACLR; // ACLK, continuous mode
+
+#ifdef PULSE_INSTRUMENT
   for (;;) {
-    volatile unsigned long i; // volatile to prevent optimization
+    __bis_SR_register(LPM3_bits | GIE); // Woken once per report window
+    // Edges keep coming while the report is worked out; their ISR time is
+    // subtracted here because the ISR counts it itself
+    uint16_t start = TA1R;
+    uint16_t isr_start = g_isr_cycles;
 
-    P1OUT ^= 0x06; // Toggle P1.1 & P1.2 using exclusive-OR
-    i = 100000;    // SW Delay
-    do
-      i--;
-    while (i != 0);
+    uint32_t active = g_window_active;
+    g_pulse_report.active_cycles = active;
+    g_pulse_report.active_permille =
+        (uint16_t)((uint64_t)active * 1000 / WINDOW_CYCLES);
+    g_pulse_report.windows++;
+
+    __disable_interrupt();
+    g_active_cycles += (uint16_t)(TA1R - start) -
+                       (uint16_t)(g_isr_cycles - isr_start) +
+                       ISR_OVERHEAD_CYCLES;
   }
+#else
+  __bis_SR_register(LPM3_bits | GIE); // Only the ISR runs from here
+  __no_operation();                   // For debugger
+#endif
+}
+
+// Timer0_A3 CCR0: one call per output change
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector = TIMER0_A0_VECTOR
+__interrupt void TIMER0_A0_ISR(void)
+#elif defined(__GNUC__)
+void __attribute__((interrupt(TIMER0_A0_VECTOR))) TIMER0_A0_ISR(void)
+#else
+#error Compiler not supported!
+#endif
+{
+#ifdef PULSE_INSTRUMENT
+  uint16_t start = TA1R;
+#endif
 
-  return 0;
+  g_state = (g_state + 1) & (STATE_COUNT - 1);
+  // Clear one channel and set the other in a single write
+  P1OUT = (P1OUT & ~(BIT1 | BIT2)) | g_state_pins[g_state];
+  TA0CCR0 += g_state_ticks[g_state];
+
+#ifdef PULSE_INSTRUMENT
+  if (g_state == STATE_CATHODIC && --g_window_periods == 0) {
+    g_window_periods = PULSE_REPORT_PERIODS;
+    g_window_active = g_active_cycles;
+    g_active_cycles = 0;
+    __bic_SR_register_on_exit(LPM3_bits); // Let main publish the window
+  }
+  uint16_t cycles = (uint16_t)(TA1R - start) + ISR_OVERHEAD_CYCLES;
+  g_active_cycles += cycles;
+  g_isr_cycles += cycles;
+#endif
 }
+
+#endif
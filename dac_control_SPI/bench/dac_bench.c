@@ -0,0 +1,206 @@
+/**
+ * @file dac_bench.c
+ * @brief Throughput and latency of the SPI/DAC path for every SPI divider
+ *
+ * For each divider the bus is re-initialised and three calls are timed:
+ *
+ * - msp_spi_transfer() of one 3-byte NOP frame (blocking, polled)
+ * - dac_init(), including its 1 ms reset wait
+ * - dac_write_voltage() on channel 0 with a new value every call, so the
+ *   register cache never elides it (data frame + LDAC frame)
+ * - dac_write_millivolts() with the same values, so the float and integer
+ *   conversions can be compared on call_cycles
+ *
+ * call_cycles is measured up to the return of the call, total_cycles up to
+ * the moment msp_spi_flush() returns, i.e. the queue is empty and CS is
+ * high. The rates are derived from total_cycles, so they are what a caller
+ * issuing back-to-back calls would sustain. Frame counts come from the
+ * driver's own counter (dac63004w_shadow_t.issued), not from assumptions.
+ */
+#include "dac_bench.h"
+#include "hardware/dac63004w.h"
+#include "msp_clock.h"
+#include "msp_delay.h"
+#include <msp430.h>
+#include <stddef.h> /* For NULL definition */
+
+#define BENCH_INIT_ITERATIONS 4 // dac_init() is dominated by its reset wait
+#define BENCH_FRAME_BYTES 3     // Address byte + 16-bit data
+
+// SPI clock dividers swept; one bit time is this many MCLK cycles
+static const uint8_t k_dividers[] = {1, 2, 4, 8, 16};
+
+// No-operation frame: clocks a full frame without changing the DAC
+static const uint8_t k_nop_frame[BENCH_FRAME_BYTES] = {DAC_REG_NOP, 0x00,
+                                                       0x00};
+
+static dac63004w_context_t g_bench_dac;
+
+/**
+ * @brief Fill in the averages and rates and hand the result on
+ */
+static void bench_finish(dac_bench_result_t *r, uint32_t frames,
+                         uint32_t call_total, uint32_t total,
+                         dac_bench_emit_t emit, void *arg) {
+  r->mclk_hz = MSP_MCLK_HZ;
+  r->frames = (uint16_t)(frames / r->iterations);
+  r->bytes = r->frames * BENCH_FRAME_BYTES;
+  r->call_cycles = call_total / r->iterations;
+  r->total_cycles = total / r->iterations;
+  r->frames_per_s = 0;
+  r->bytes_per_s = 0;
+  if (total) {
+    // At most 2 * DAC_BENCH_ITERATIONS frames, so frames * MCLK stays within 32 bits
+    r->frames_per_s = frames * MSP_MCLK_HZ / total;
+    r->bytes_per_s = r->frames_per_s * BENCH_FRAME_BYTES;
+  }
+  emit(r, arg);
+}
+
+static void bench_transfer(uint8_t divider, dac_bench_emit_t emit,
+                           void *arg) {
+  dac_bench_result_t r = {.call = "msp_spi_transfer",
+                          .divider = divider,
+                          .iterations = DAC_BENCH_ITERATIONS};
+  uint32_t total = 0;
+  uint32_t frames = 0;
+
+  for (uint16_t i = 0; i < DAC_BENCH_ITERATIONS; i++) {
+    uint16_t start = TA0R;
+    if (msp_spi_transfer(k_nop_frame, NULL, sizeof(k_nop_frame)) ==
+        SPI_SUCCESS) {
+      frames++;
+    }
+    total += (uint16_t)(TA0R - start);
+  }
+  // Blocking: the frame is complete when the call returns
+  bench_finish(&r, frames, total, total, emit, arg);
+}
+
+static void bench_init(uint8_t divider, dac_bench_emit_t emit, void *arg) {
+  dac_bench_result_t r = {.call = "dac_init",
+                          .divider = divider,
+                          .iterations = BENCH_INIT_ITERATIONS};
+  uint32_t call_total = 0;
+  uint32_t total = 0;
+  uint32_t frames = 0;
+
+  for (uint16_t i = 0; i < BENCH_INIT_ITERATIONS; i++) {
+    uint16_t start = TA0R;
+    dac_init(&g_bench_dac);
+    call_total += (uint16_t)(TA0R - start);
+    msp_spi_flush();
+    total += (uint16_t)(TA0R - start);
+    frames += g_bench_dac.shadow.issued; // dac_init() restarts the count
+  }
+  bench_finish(&r, frames, call_total, total, emit, arg);
+}
+
+static void bench_write_voltage(uint8_t divider, dac_bench_emit_t emit,
+                                void *arg) {
+  dac_bench_result_t r = {.call = "dac_write_voltage",
+                          .divider = divider,
+                          .iterations = DAC_BENCH_ITERATIONS};
+  uint32_t call_total = 0;
+  uint32_t total = 0;
+  uint32_t issued = g_bench_dac.shadow.issued;
+
+  for (uint16_t i = 0; i < DAC_BENCH_ITERATIONS; i++) {
+    // A different code every call so nothing is served from the cache
+    float volts = 0.5f + i * 0.05f;
+
+    uint16_t start = TA0R;
+    dac_write_voltage(&g_bench_dac, 0, volts);
+    call_total += (uint16_t)(TA0R - start);
+    msp_spi_flush();
+    total += (uint16_t)(TA0R - start);
+  }
+  bench_finish(&r, g_bench_dac.shadow.issued - issued, call_total, total,
+               emit, arg);
+}
+
+static void bench_write_millivolts(uint8_t divider, dac_bench_emit_t emit,
+                                   void *arg) {
+  dac_bench_result_t r = {.call = "dac_write_millivolts",
+                          .divider = divider,
+                          .iterations = DAC_BENCH_ITERATIONS};
+  uint32_t call_total = 0;
+  uint32_t total = 0;
+  uint32_t issued = g_bench_dac.shadow.issued;
+
+  for (uint16_t i = 0; i < DAC_BENCH_ITERATIONS; i++) {
+    // Same values as bench_write_voltage(), 0.5 V + 50 mV per call
+    uint16_t millivolts = 500 + i * 50;
+
+    uint16_t start = TA0R;
+    dac_write_millivolts(&g_bench_dac, 0, millivolts);
+    call_total += (uint16_t)(TA0R - start);
+    msp_spi_flush();
+    total += (uint16_t)(TA0R - start);
+  }
+  bench_finish(&r, g_bench_dac.shadow.issued - issued, call_total, total,
+               emit, arg);
+}
+
+void dac_bench_run(const spi_pin_config_t *pins, dac_bench_emit_t emit,
+                   void *arg) {
+  // SMCLK, continuous mode: one tick per CPU cycle. Keep SMCLK running
+  // through delay_ms() so the count includes dac_init()'s reset wait.
+  TA0CTL = TASSEL__SMCLK | MC__CONTINUOUS | TACLR;
+  delay_smclk_acquire();
+
+  g_bench_dac.spi = NULL;
+  g_bench_dac.vref_mv = 3300;
+  g_bench_dac.mode = DAC_MODE_VOLTAGE;
+
+  for (uint8_t d = 0; d < sizeof(k_dividers); d++) {
+    spi_config_t config = {
+        .clock_divider = k_dividers[d], .mode = 1, .bit_order = 0};
+    if (msp_spi_init(pins, &config) != SPI_SUCCESS) {
+      continue;
+    }
+    bench_transfer(k_dividers[d], emit, arg);
+    bench_init(k_dividers[d], emit, arg);
+    bench_write_voltage(k_dividers[d], emit, arg);
+    bench_write_millivolts(k_dividers[d], emit, arg);
+  }
+
+  delay_smclk_release();
+}
+
+/**
+ * @brief Append a decimal number and a separator
+ */
+static char *bench_put_u32(char *p, uint32_t value, char separator) {
+  char digits[10];
+  uint8_t n = 0;
+  do {
+    digits[n++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value);
+  while (n) {
+    *p++ = digits[--n];
+  }
+  *p++ = separator;
+  return p;
+}
+
+uint16_t dac_bench_format(const dac_bench_result_t *result, char *buf) {
+  char *p = buf;
+  // Call names are short literals from this file
+  for (const char *s = result->call; *s; s++) {
+    *p++ = *s;
+  }
+  *p++ = ',';
+  p = bench_put_u32(p, result->mclk_hz, ',');
+  p = bench_put_u32(p, result->divider, ',');
+  p = bench_put_u32(p, result->iterations, ',');
+  p = bench_put_u32(p, result->frames, ',');
+  p = bench_put_u32(p, result->bytes, ',');
+  p = bench_put_u32(p, result->call_cycles, ',');
+  p = bench_put_u32(p, result->total_cycles, ',');
+  p = bench_put_u32(p, result->frames_per_s, ',');
+  p = bench_put_u32(p, result->bytes_per_s, '\n');
+  *p = '\0';
+  return (uint16_t)(p - buf);
+}
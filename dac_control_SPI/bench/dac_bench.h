@@ -0,0 +1,77 @@
+/**
+ * @file dac_bench.h
+ * @brief Throughput and latency of the SPI/DAC path for every SPI divider
+ *
+ * Shared by the firmware bench image (spi_bench.c) and the host simulation
+ * build (host/bench). Cycles are counted with Timer_A0 from SMCLK = MCLK,
+ * so one tick is one CPU cycle at the MSP_MCLK_HZ the image was built for.
+ */
+#ifndef DAC_BENCH_H
+#define DAC_BENCH_H
+
+#include "msp_spi.h"
+#include <stdint.h>
+
+/**
+ * @brief Calls timed per call and divider
+ */
+#define DAC_BENCH_ITERATIONS 32
+
+/**
+ * @brief Longest report line dac_bench_format() produces, with newline
+ */
+#define DAC_BENCH_LINE_SIZE 128
+
+/**
+ * @brief Column names of the CSV report
+ */
+#define DAC_BENCH_CSV_HEADER                                                   \
+  "call,mclk_hz,divider,iterations,frames,bytes,call_cycles,total_cycles,"     \
+  "frames_per_s,bytes_per_s\n"
+
+/**
+ * @brief Averages for one call at one SPI divider
+ */
+typedef struct {
+    const char *call;       // API function measured
+    uint32_t mclk_hz;       // MCLK = SMCLK the image was built for
+    uint8_t divider;        // spi_config_t.clock_divider
+    uint16_t iterations;    // Calls averaged
+    uint16_t frames;        // CS frames per call
+    uint16_t bytes;         // Bytes clocked per call
+    uint32_t call_cycles;   // Cycles until the call returns
+    uint32_t total_cycles;  // Cycles until its last frame has left the bus
+    uint32_t frames_per_s;  // frames * MCLK / total_cycles
+    uint32_t bytes_per_s;   // bytes * MCLK / total_cycles
+} dac_bench_result_t;
+
+/**
+ * @brief Receives each result as soon as it is measured
+ */
+typedef void (*dac_bench_emit_t)(const dac_bench_result_t *result, void *arg);
+
+/**
+ * @brief Time msp_spi_transfer(), dac_write_voltage() and dac_init()
+ *
+ * Re-initialises the bus for every divider and leaves it at the last one.
+ * Starts Timer_A0 in continuous mode and holds SMCLK (delay_smclk_acquire())
+ * while running so the counter keeps going through delay_ms(). Needs GIE.
+ *
+ * @param pins Bus pins, as passed to msp_spi_init()
+ * @param emit Called once per call and divider
+ * @param arg Passed to emit
+ */
+void dac_bench_run(const spi_pin_config_t *pins, dac_bench_emit_t emit, void *arg);
+
+/**
+ * @brief Format a result as one CSV line matching DAC_BENCH_CSV_HEADER
+ *
+ * Avoids printf so the firmware image stays small.
+ *
+ * @param result Result to format
+ * @param buf Output, at least DAC_BENCH_LINE_SIZE bytes
+ * @return uint16_t Characters written, excluding the terminating NUL
+ */
+uint16_t dac_bench_format(const dac_bench_result_t *result, char *buf);
+
+#endif /* DAC_BENCH_H */
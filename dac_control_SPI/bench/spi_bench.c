@@ -0,0 +1,334 @@
+/**
+ * @file spi_bench.c
+ * @brief CPU-busy cycles per DAC update: blocking SPI path vs. queued ISR path
+ *
+ * Build with `make bench`, flash, and read `g_spi_bench` from the debugger
+ * once the LED turns on (or break on bench_done()).
+ *
+ * Timer_A0 runs from SMCLK (= MCLK) so one tick is one CPU cycle. The
+ * blocking path is timed directly. For the queued path the CPU spins in an
+ * idle loop until the last completion callback fires; the loop's cost per
+ * iteration is calibrated against Timer_A0 beforehand, so
+ * busy = elapsed - idle_iterations * cycles_per_iteration.
+ *
+ * The four-channel figures compare bus time for updating every output with
+ * dac_write_voltage() (data + LDAC per channel) against one dac_write_batch().
+ *
+ * The conversion figures are CPU cycles spent inside one call, up to the
+ * point where both frames are queued: float volts vs. integer millivolts.
+ *
+ * The polled frame figure is one msp_spi_write_polled() call, which is
+ * mostly bit time plus two CS edges. Build the image twice to compare CS
+ * dispatch: `make clean bench` (SPI_STATIC_PINS, constant port) against
+ * `make clean bench SPI_PINS=runtime` (port/mask loaded from RAM).
+ * `static_pins` records which variant produced the numbers.
+ *
+ * The sample ISR figures are the CPU time the playback and DDS timer ISRs
+ * take from the idle loop, per sample. They are what
+ * DAC_PLAYBACK_ISR_OVERHEAD_CYCLES (playback_isr_cycles less the 24 bit
+ * clocks at divider 8) and DAC_DDS_SYNTH_CYCLES (dds_isr_cycles less
+ * playback_isr_cycles) bound from above.
+ *
+ * Finally dac_bench_run() sweeps the SPI dividers and writes its CSV report
+ * to `g_bench_report` (dump it as a string from the debugger). Rebuild with
+ * `make clean bench MCLK_HZ=...` for each clock setting; every line carries
+ * the MCLK it was measured at.
+ */
+#include "dac_bench.h"
+#include "hardware/dac63004w.h"
+#include "hardware/dac63004w_dds.h"
+#include "hardware/dac63004w_playback.h"
+#include "msp_clock.h"
+#include "msp_gpio.h"
+#include "msp_spi.h"
+#include "msp_spi_eusci.h"
+#include <msp430.h>
+#include <stddef.h> /* For NULL definition */
+
+#define BENCH_ITERATIONS 64
+#define BENCH_CAL_TICKS 20000
+
+// Sample period for timing the playback and DDS ISRs: long enough for both
+// at every MCLK and SPI divider setting
+#define BENCH_ISR_PERIOD 2000
+
+// Header plus one line per call and divider
+#define BENCH_REPORT_SIZE 1536
+
+/**
+ * @brief Benchmark results, averaged over BENCH_ITERATIONS DAC updates
+ */
+typedef struct {
+  uint16_t idle_loop_cycles_q8;   // Idle loop cost per iteration (Q8.8)
+  uint16_t blocking_busy_cycles;  // Old path: CPU cycles per update
+  uint16_t async_elapsed_cycles;  // New path: wall-clock cycles per update
+  uint16_t async_busy_cycles;     // New path: CPU cycles per update
+  uint16_t quad_single_cycles;    // 4 x dac_write_voltage(), wall clock
+  uint16_t quad_batch_cycles;     // 1 x dac_write_batch() of 4, wall clock
+  uint16_t float_call_cycles;     // dac_write_voltage(), CPU
+  uint16_t fixed_call_cycles;     // dac_write_millivolts(), CPU
+  uint16_t polled_frame_cycles;   // msp_spi_write_polled() of 3 bytes
+  uint16_t playback_isr_cycles;   // Timer1_A playback ISR, entry to RETI
+  uint16_t dds_isr_cycles;        // Timer3_A DDS ISR while sweeping
+  uint16_t static_pins;           // 1 if built with SPI_STATIC_PINS
+} spi_bench_result_t;
+
+volatile spi_bench_result_t g_spi_bench;
+
+// CSV report from dac_bench_run(), NUL-terminated
+char g_bench_report[BENCH_REPORT_SIZE];
+static uint16_t g_report_length;
+
+static volatile uint8_t g_pending;
+
+// One DAC update as issued by dac_write_voltage(): data frame then LDAC
+static const uint8_t k_data_frame[3] = {0x19, 0x80, 0x00};
+static const uint8_t k_ldac_frame[3] = {0x20, 0x00, 0x80};
+
+static void bench_done(void) { LED_ON(); }
+
+/**
+ * @brief Append a dac_bench_run() result to g_bench_report
+ */
+static void report_line(const dac_bench_result_t *result, void *arg) {
+  (void)arg;
+  char line[DAC_BENCH_LINE_SIZE];
+  uint16_t length = dac_bench_format(result, line);
+  if (g_report_length + length >= BENCH_REPORT_SIZE) {
+    return; // Truncate rather than overflow
+  }
+  for (uint16_t i = 0; i <= length; i++) {
+    g_bench_report[g_report_length + i] = line[i];
+  }
+  g_report_length += length;
+}
+
+static void report_start(void) {
+  static const char header[] = DAC_BENCH_CSV_HEADER;
+  for (uint16_t i = 0; i < sizeof(header); i++) {
+    g_bench_report[i] = header[i];
+  }
+  g_report_length = sizeof(header) - 1;
+}
+
+static void on_frame_done(spi_status_t status, void *arg) {
+  (void)status;
+  (void)arg;
+  g_pending--;
+}
+
+/**
+ * @brief Count iterations until g_pending drops to zero
+ */
+static uint16_t __attribute__((noinline)) idle_spin(void) {
+  uint16_t n = 0;
+  while (g_pending) {
+    n++;
+  }
+  return n;
+}
+
+/**
+ * @brief Measure idle_spin() cost per iteration using a CCR0 timeout
+ */
+static uint16_t calibrate_idle_loop(void) {
+  g_pending = 1;
+  uint16_t start = TA0R;
+  TA0CCR0 = start + BENCH_CAL_TICKS;
+  TA0CCTL0 = CCIE;
+  uint16_t n = idle_spin();
+  uint16_t elapsed = TA0R - start;
+  TA0CCTL0 = 0;
+
+  return (uint16_t)(((uint32_t)elapsed << 8) / n);
+}
+
+static uint16_t bench_blocking(void) {
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < BENCH_ITERATIONS; i++) {
+    uint16_t start = TA0R;
+    msp_spi_transfer(k_data_frame, NULL, sizeof(k_data_frame));
+    msp_spi_transfer(k_ldac_frame, NULL, sizeof(k_ldac_frame));
+    total += (uint16_t)(TA0R - start);
+  }
+  return (uint16_t)(total / BENCH_ITERATIONS);
+}
+
+static uint16_t bench_polled(void) {
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < BENCH_ITERATIONS; i++) {
+    uint16_t start = TA0R;
+    msp_spi_write_polled(k_data_frame, sizeof(k_data_frame));
+    total += (uint16_t)(TA0R - start);
+  }
+  return (uint16_t)(total / BENCH_ITERATIONS);
+}
+
+/**
+ * @brief CPU cycles per call of a timer ISR running every BENCH_ISR_PERIOD
+ *
+ * Counts idle loop iterations over a fixed window; whatever the loop did
+ * not get went to the ISR, entry and RETI included.
+ */
+static uint16_t bench_isr_load(uint16_t idle_q8) {
+  g_pending = 1;
+  uint16_t start = TA0R;
+  TA0CCR0 = start + BENCH_CAL_TICKS;
+  TA0CCTL0 = CCIE;
+  uint16_t n = idle_spin();
+  uint16_t elapsed = TA0R - start;
+  TA0CCTL0 = 0;
+
+  uint32_t busy = elapsed - (((uint32_t)n * idle_q8) >> 8);
+  return (uint16_t)(busy * BENCH_ISR_PERIOD / elapsed);
+}
+
+static void bench_sample_isrs(dac63004w_context_t *ctx, uint16_t idle_q8) {
+  static dac_frame_t frames[4];
+  static const uint16_t codes[4] = {0x400, 0x800, 0xC00, 0xFFF};
+  dac_playback_encode(frames, codes, 4, 0);
+  dac_playback_start(ctx, 0, frames, 4, MSP_SMCLK_HZ / BENCH_ISR_PERIOD,
+                     true);
+  g_spi_bench.playback_isr_cycles = bench_isr_load(idle_q8);
+  dac_playback_stop(ctx);
+
+  // A repeating sweep, so the ISR takes its longest path every tick
+  dac_dds_config_t sweep = {.sample_rate_hz = MSP_SMCLK_HZ / BENCH_ISR_PERIOD,
+                            .start_mhz = 10000,
+                            .stop_mhz = 100000,
+                            .sweep_ms = 1000,
+                            .sweep_repeat = true,
+                            .amplitude = 2000,
+                            .offset = 2048};
+  dac_dds_start(ctx, 0, &sweep);
+  g_spi_bench.dds_isr_cycles = bench_isr_load(idle_q8);
+  dac_dds_stop(ctx);
+}
+
+static void bench_async(uint16_t idle_q8) {
+  uint32_t elapsed = 0;
+  uint32_t idle = 0;
+  for (uint8_t i = 0; i < BENCH_ITERATIONS; i++) {
+    g_pending = 2;
+    uint16_t start = TA0R;
+    msp_spi_submit(k_data_frame, NULL, sizeof(k_data_frame), on_frame_done,
+                   NULL);
+    msp_spi_submit(k_ldac_frame, NULL, sizeof(k_ldac_frame), on_frame_done,
+                   NULL);
+    uint16_t n = idle_spin();
+    elapsed += (uint16_t)(TA0R - start);
+    idle += ((uint32_t)n * idle_q8) >> 8;
+  }
+  g_spi_bench.async_elapsed_cycles = (uint16_t)(elapsed / BENCH_ITERATIONS);
+  g_spi_bench.async_busy_cycles =
+      (uint16_t)((elapsed - idle) / BENCH_ITERATIONS);
+}
+
+static void bench_quad_update(dac63004w_context_t *ctx) {
+  static const dac63004w_update_t updates[DAC_NUM_CHANNELS] = {
+      {0, 0x400}, {1, 0x800}, {2, 0xC00}, {3, 0xFFF}};
+  uint32_t single = 0;
+  uint32_t batch = 0;
+
+  for (uint8_t i = 0; i < BENCH_ITERATIONS; i++) {
+    // Defeat the register cache so every update reaches the bus
+    dac_shadow_invalidate(ctx, DAC_REG_COUNT);
+    uint16_t start = TA0R;
+    for (uint8_t channel = 0; channel < DAC_NUM_CHANNELS; channel++) {
+      dac_write_voltage(ctx, channel, 1.0f);
+    }
+    msp_spi_flush();
+    single += (uint16_t)(TA0R - start);
+
+    dac_shadow_invalidate(ctx, DAC_REG_COUNT);
+    start = TA0R;
+    dac_write_batch(ctx, updates, DAC_NUM_CHANNELS);
+    msp_spi_flush();
+    batch += (uint16_t)(TA0R - start);
+  }
+  g_spi_bench.quad_single_cycles = (uint16_t)(single / BENCH_ITERATIONS);
+  g_spi_bench.quad_batch_cycles = (uint16_t)(batch / BENCH_ITERATIONS);
+}
+
+static void bench_conversion(dac63004w_context_t *ctx) {
+  uint32_t float_total = 0;
+  uint32_t fixed_total = 0;
+
+  for (uint8_t i = 0; i < BENCH_ITERATIONS; i++) {
+    // Vary the input so nothing is folded at compile time
+    uint16_t millivolts = 1000 + i;
+    float volts = millivolts / 1000.0f;
+
+    dac_shadow_invalidate(ctx, DAC_REG_COUNT);
+    uint16_t start = TA0R;
+    dac_write_voltage(ctx, 0, volts);
+    float_total += (uint16_t)(TA0R - start);
+    msp_spi_flush();
+
+    dac_shadow_invalidate(ctx, DAC_REG_COUNT);
+    start = TA0R;
+    dac_write_millivolts(ctx, 0, millivolts);
+    fixed_total += (uint16_t)(TA0R - start);
+    msp_spi_flush();
+  }
+  g_spi_bench.float_call_cycles = (uint16_t)(float_total / BENCH_ITERATIONS);
+  g_spi_bench.fixed_call_cycles = (uint16_t)(fixed_total / BENCH_ITERATIONS);
+}
+
+int main(void) {
+  WDTCTL = WDTPW | WDTHOLD; // Stop watchdog timer
+
+  init_clock();
+  PM5CTL0 &= ~LOCKLPM5;
+  init_gpio();
+
+  spi_pin_config_t spi_pins = {.mosi_port = SPI_DATA_PORT,
+                               .mosi_pin = SPI_SIMO_PIN,
+                               .miso_port = SPI_DATA_PORT,
+                               .miso_pin = SPI_SOMI_PIN,
+                               .sclk_port = SPI_DATA_PORT,
+                               .sclk_pin = SPI_CLK_PIN,
+                               .cs_port = 1,
+                               .cs_pin = 7};
+  spi_config_t spi_config = {.clock_divider = 8, .mode = 1, .bit_order = 0};
+  msp_spi_init(&spi_pins, &spi_config);
+
+  // SMCLK, continuous mode: one tick per CPU cycle
+  TA0CTL = TASSEL__SMCLK | MC__CONTINUOUS | TACLR;
+  __enable_interrupt();
+
+  g_spi_bench.idle_loop_cycles_q8 = calibrate_idle_loop();
+  g_spi_bench.blocking_busy_cycles = bench_blocking();
+  bench_async(g_spi_bench.idle_loop_cycles_q8);
+  g_spi_bench.polled_frame_cycles = bench_polled();
+#ifdef SPI_STATIC_PINS
+  g_spi_bench.static_pins = 1;
+#endif
+
+  static dac63004w_context_t dac = {.vref_mv = 3300, .mode = DAC_MODE_VOLTAGE};
+  dac_init(&dac);
+  bench_quad_update(&dac);
+  bench_conversion(&dac);
+  bench_sample_isrs(&dac, g_spi_bench.idle_loop_cycles_q8);
+
+  report_start();
+  dac_bench_run(&spi_pins, report_line, NULL);
+
+  bench_done();
+  while (1) {
+    __bis_SR_register(LPM3_bits | GIE);
+  }
+}
+
+// Calibration timeout
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector = TIMER0_A0_VECTOR
+__interrupt void TIMER0_A0_ISR(void)
+#elif defined(__GNUC__)
+void __attribute__((interrupt(TIMER0_A0_VECTOR))) TIMER0_A0_ISR(void)
+#else
+#error Compiler not supported!
+#endif
+{
+  g_pending = 0;
+}
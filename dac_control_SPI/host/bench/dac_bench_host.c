@@ -0,0 +1,71 @@
+/**
+ * @file dac_bench_host.c
+ * @brief Run the dac_bench.c suite against the simulated MCU
+ *
+ * Prints the CSV report on stdout. Cycle counts are virtual: every register
+ * access costs SIM_ACCESS_CYCLES and ISR entry/exit are charged as on the
+ * CPU, but compiled host code between accesses is free, so the figures are
+ * a lower bound for CPU-bound calls and exact for bus-bound ones.
+ *
+ * Usage: dac_bench [--no-header]
+ */
+#include "dac63004w_model.h"
+#include "dac_bench.h"
+#include "msp430_sim.h"
+#include "msp_clock.h"
+#include "msp_spi.h"
+#include "msp_spi_eusci.h"
+#include <stdio.h>
+#include <string.h>
+
+static uint32_t g_reported_frames;
+
+static void print_line(const dac_bench_result_t *result, void *arg) {
+  (void)arg;
+  char line[DAC_BENCH_LINE_SIZE];
+  dac_bench_format(result, line);
+  fputs(line, stdout);
+  g_reported_frames += (uint32_t)result->frames * result->iterations;
+}
+
+int main(int argc, char **argv) {
+  bool header = !(argc > 1 && strcmp(argv[1], "--no-header") == 0);
+  dac63004w_model_t model;
+
+  sim_reset();
+  dac63004w_model_init(&model, 1, 7);
+  sim_set_miso(dac63004w_model_miso, &model);
+
+  init_clock();
+  __enable_interrupt();
+
+  spi_pin_config_t pins = {.mosi_port = SPI_DATA_PORT,
+                           .mosi_pin = SPI_SIMO_PIN,
+                           .miso_port = SPI_DATA_PORT,
+                           .miso_pin = SPI_SOMI_PIN,
+                           .sclk_port = SPI_DATA_PORT,
+                           .sclk_pin = SPI_CLK_PIN,
+                           .cs_port = 1,
+                           .cs_pin = 7};
+  if (header) {
+    fputs(DAC_BENCH_CSV_HEADER, stdout);
+  }
+  sim_log_clear();
+  dac_bench_run(&pins, print_line, NULL);
+
+  // The frame counts in the report must agree with what reached the bus
+  const sim_stats_t *stats = sim_stats();
+  if (stats->frames != g_reported_frames || stats->stray_bytes ||
+      stats->truncated || stats->tx_overwrites || stats->smclk_stalls) {
+    fprintf(stderr,
+            "dac_bench: bus saw %lu frames, report claims %lu "
+            "(stray %lu, truncated %lu, overwrites %lu, stalls %lu)\n",
+            (unsigned long)stats->frames, (unsigned long)g_reported_frames,
+            (unsigned long)stats->stray_bytes,
+            (unsigned long)stats->truncated,
+            (unsigned long)stats->tx_overwrites,
+            (unsigned long)stats->smclk_stalls);
+    return 1;
+  }
+  return 0;
+}
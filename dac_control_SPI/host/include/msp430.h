@@ -0,0 +1,290 @@
+/**
+ * @file msp430.h
+ * @brief Host stand-in for the MSP430FR2433 device header
+ *
+ * Every peripheral register used by the drivers is a field of sim_regs, and
+ * every access goes through sim_reg8()/sim_reg16(), which first lets the
+ * simulator catch up (see sim/msp430_sim.c). Intrinsics map onto simulator
+ * calls. Only the registers and bits the drivers touch are provided; bit
+ * values match the real header.
+ */
+#ifndef HOST_MSP430_H
+#define HOST_MSP430_H
+
+#include <stdint.h>
+
+/**
+ * @brief Simulated Timer_A instance
+ */
+typedef struct {
+    uint16_t ctl;
+    uint16_t cctl0;
+    uint16_t ccr0;
+    uint16_t r;
+    uint16_t ex0;
+} sim_timer_regs_t;
+
+/**
+ * @brief Simulated eUSCI instance (SPI mode)
+ */
+typedef struct {
+    uint16_t ctlw0;
+    uint16_t brw;
+    uint16_t mctlw; // eUSCI_A only
+    uint16_t statw;
+    uint16_t rxbuf;
+    uint16_t txbuf;
+    uint16_t ie;
+    uint16_t ifg;
+    uint16_t iv;
+} sim_eusci_regs_t;
+
+// Index into sim_regs_t.eusci
+#define SIM_EUSCI_A0 0
+#define SIM_EUSCI_A1 1
+#define SIM_EUSCI_B0 2
+
+/**
+ * @brief Simulated register file
+ */
+typedef struct {
+    // eUSCI_A0, eUSCI_A1, eUSCI_B0
+    sim_eusci_regs_t eusci[3];
+
+    // Digital I/O, index 0 = P1
+    uint8_t pout[3];
+    uint8_t pdir[3];
+    uint8_t psel0[3];
+    uint8_t psel1[3];
+    uint8_t pin[3];
+    uint8_t pren[3];
+
+    // Timer0_A3 .. Timer3_A2
+    sim_timer_regs_t ta[4];
+
+    // Clock system and miscellaneous
+    uint16_t csctl0;
+    uint16_t csctl1;
+    uint16_t csctl2;
+    uint16_t csctl3;
+    uint16_t csctl4;
+    uint16_t csctl5;
+    uint16_t csctl6;
+    uint16_t csctl7;
+    uint16_t csctl8;
+    uint16_t frctl0;
+    uint16_t syscfg0;
+    uint16_t pm5ctl0;
+    uint16_t wdtctl;
+} sim_regs_t;
+
+extern volatile sim_regs_t sim_regs;
+
+volatile uint8_t *sim_reg8(volatile uint8_t *reg);
+volatile uint16_t *sim_reg16(volatile uint16_t *reg);
+
+void sim_bis_sr(uint16_t bits);
+void sim_bic_sr(uint16_t bits);
+void sim_bis_sr_on_exit(uint16_t bits);
+void sim_bic_sr_on_exit(uint16_t bits);
+uint16_t sim_get_interrupt_state(void);
+void sim_set_interrupt_state(uint16_t state);
+void sim_delay_cycles(uint32_t cycles);
+
+#define SIM_R16(field) (*sim_reg16(&sim_regs.field))
+#define SIM_R8(field) (*sim_reg8(&sim_regs.field))
+
+// eUSCI registers
+#define UCA0CTLW0 SIM_R16(eusci[SIM_EUSCI_A0].ctlw0)
+#define UCA0BRW SIM_R16(eusci[SIM_EUSCI_A0].brw)
+#define UCA0MCTLW SIM_R16(eusci[SIM_EUSCI_A0].mctlw)
+#define UCA0STATW SIM_R16(eusci[SIM_EUSCI_A0].statw)
+#define UCA0RXBUF SIM_R16(eusci[SIM_EUSCI_A0].rxbuf)
+#define UCA0TXBUF SIM_R16(eusci[SIM_EUSCI_A0].txbuf)
+#define UCA0IE SIM_R16(eusci[SIM_EUSCI_A0].ie)
+#define UCA0IFG SIM_R16(eusci[SIM_EUSCI_A0].ifg)
+#define UCA0IV SIM_R16(eusci[SIM_EUSCI_A0].iv)
+#define UCA1CTLW0 SIM_R16(eusci[SIM_EUSCI_A1].ctlw0)
+#define UCA1BRW SIM_R16(eusci[SIM_EUSCI_A1].brw)
+#define UCA1MCTLW SIM_R16(eusci[SIM_EUSCI_A1].mctlw)
+#define UCA1STATW SIM_R16(eusci[SIM_EUSCI_A1].statw)
+#define UCA1RXBUF SIM_R16(eusci[SIM_EUSCI_A1].rxbuf)
+#define UCA1TXBUF SIM_R16(eusci[SIM_EUSCI_A1].txbuf)
+#define UCA1IE SIM_R16(eusci[SIM_EUSCI_A1].ie)
+#define UCA1IFG SIM_R16(eusci[SIM_EUSCI_A1].ifg)
+#define UCA1IV SIM_R16(eusci[SIM_EUSCI_A1].iv)
+#define UCB0CTLW0 SIM_R16(eusci[SIM_EUSCI_B0].ctlw0)
+#define UCB0BRW SIM_R16(eusci[SIM_EUSCI_B0].brw)
+#define UCB0STATW SIM_R16(eusci[SIM_EUSCI_B0].statw)
+#define UCB0RXBUF SIM_R16(eusci[SIM_EUSCI_B0].rxbuf)
+#define UCB0TXBUF SIM_R16(eusci[SIM_EUSCI_B0].txbuf)
+#define UCB0IE SIM_R16(eusci[SIM_EUSCI_B0].ie)
+#define UCB0IFG SIM_R16(eusci[SIM_EUSCI_B0].ifg)
+#define UCB0IV SIM_R16(eusci[SIM_EUSCI_B0].iv)
+
+// UCxCTLW0 bits (same positions on eUSCI_A and eUSCI_B)
+#define UCSWRST 0x0001
+#define UCSTEM 0x0002
+#define UCSSEL__ACLK 0x0040
+#define UCSSEL__SMCLK 0x0080
+#define UCSYNC 0x0100
+#define UCMODE_0 0x0000
+#define UCMST 0x0800
+#define UC7BIT 0x1000
+#define UCMSB 0x2000
+#define UCCKPL 0x4000
+#define UCCKPH 0x8000
+
+// UCxSTATW, UCxIE, UCxIFG and UCxIV values in SPI mode
+#define UCBUSY 0x0001
+#define UCOE 0x0020
+#define UCRXIE 0x0001
+#define UCTXIE 0x0002
+#define UCRXIFG 0x0001
+#define UCTXIFG 0x0002
+#define USCI_NONE 0x0000
+#define USCI_SPI_UCRXIFG 0x0002
+#define USCI_SPI_UCTXIFG 0x0004
+
+// Digital I/O
+#define P1OUT SIM_R8(pout[0])
+#define P2OUT SIM_R8(pout[1])
+#define P3OUT SIM_R8(pout[2])
+#define P1DIR SIM_R8(pdir[0])
+#define P2DIR SIM_R8(pdir[1])
+#define P3DIR SIM_R8(pdir[2])
+#define P1SEL0 SIM_R8(psel0[0])
+#define P2SEL0 SIM_R8(psel0[1])
+#define P3SEL0 SIM_R8(psel0[2])
+#define P1SEL1 SIM_R8(psel1[0])
+#define P2SEL1 SIM_R8(psel1[1])
+#define P3SEL1 SIM_R8(psel1[2])
+#define P1IN SIM_R8(pin[0])
+#define P2IN SIM_R8(pin[1])
+#define P3IN SIM_R8(pin[2])
+#define P1REN SIM_R8(pren[0])
+#define P2REN SIM_R8(pren[1])
+#define P3REN SIM_R8(pren[2])
+
+// Timer_A registers
+#define TA0CTL SIM_R16(ta[0].ctl)
+#define TA0CCTL0 SIM_R16(ta[0].cctl0)
+#define TA0CCR0 SIM_R16(ta[0].ccr0)
+#define TA0R SIM_R16(ta[0].r)
+#define TA0EX0 SIM_R16(ta[0].ex0)
+#define TA1CTL SIM_R16(ta[1].ctl)
+#define TA1CCTL0 SIM_R16(ta[1].cctl0)
+#define TA1CCR0 SIM_R16(ta[1].ccr0)
+#define TA1R SIM_R16(ta[1].r)
+#define TA1EX0 SIM_R16(ta[1].ex0)
+#define TA2CTL SIM_R16(ta[2].ctl)
+#define TA2CCTL0 SIM_R16(ta[2].cctl0)
+#define TA2CCR0 SIM_R16(ta[2].ccr0)
+#define TA2R SIM_R16(ta[2].r)
+#define TA2EX0 SIM_R16(ta[2].ex0)
+#define TA3CTL SIM_R16(ta[3].ctl)
+#define TA3CCTL0 SIM_R16(ta[3].cctl0)
+#define TA3CCR0 SIM_R16(ta[3].ccr0)
+#define TA3R SIM_R16(ta[3].r)
+#define TA3EX0 SIM_R16(ta[3].ex0)
+
+// Timer_A bits
+#define TAIFG 0x0001
+#define TAIE 0x0002
+#define TACLR 0x0004
+#define MC__STOP 0x0000
+#define MC__UP 0x0010
+#define MC__CONTINUOUS 0x0020
+#define MC__UPDOWN 0x0030
+#define MC_3 0x0030
+#define ID_0 0x0000
+#define ID_1 0x0040
+#define ID_2 0x0080
+#define ID_3 0x00C0
+#define TASSEL__TACLK 0x0000
+#define TASSEL__ACLK 0x0100
+#define TASSEL__SMCLK 0x0200
+#define TASSEL_3 0x0300
+#define CCIFG 0x0001
+#define COV 0x0002
+#define OUT 0x0004
+#define CCIE 0x0010
+#define OUTMOD_0 0x0000
+#define OUTMOD_7 0x00E0
+
+// Clock system
+#define CSCTL0 SIM_R16(csctl0)
+#define CSCTL1 SIM_R16(csctl1)
+#define CSCTL2 SIM_R16(csctl2)
+#define CSCTL3 SIM_R16(csctl3)
+#define CSCTL4 SIM_R16(csctl4)
+#define CSCTL5 SIM_R16(csctl5)
+#define CSCTL6 SIM_R16(csctl6)
+#define CSCTL7 SIM_R16(csctl7)
+#define CSCTL8 SIM_R16(csctl8)
+#define SELREF__REFOCLK 0x0010
+#define DCORSEL_1 0x0002
+#define DCORSEL_2 0x0004
+#define DCORSEL_3 0x0006
+#define DCORSEL_5 0x000A
+#define DCORSEL_7 0x000E
+#define FLLD_0 0x0000
+#define FLLD_1 0x1000
+#define FLLUNLOCK0 0x0100
+#define FLLUNLOCK1 0x0200
+#define SELMS__DCOCLKDIV 0x0000
+#define SELA__REFOCLK 0x0100
+#define DIVM0 0x0001
+#define DIVS0 0x0010
+
+// FRAM controller
+#define FRCTL0 SIM_R16(frctl0)
+#define FRCTLPW 0xA500
+#define NWAITS_1 0x0010
+
+// System
+#define SYSCFG0 SIM_R16(syscfg0)
+#define PFWP 0x0001
+#define DFWP 0x0002
+#define FRWPPW 0xA500
+#define PM5CTL0 SIM_R16(pm5ctl0)
+#define LOCKLPM5 0x0001
+#define WDTCTL SIM_R16(wdtctl)
+#define WDTPW 0x5A00
+#define WDTHOLD 0x0080
+
+// Status register
+#define GIE 0x0008
+#define CPUOFF 0x0010
+#define OSCOFF 0x0020
+#define SCG0 0x0040
+#define SCG1 0x0080
+#define LPM0_bits (CPUOFF)
+#define LPM3_bits (SCG1 | SCG0 | CPUOFF)
+
+// Interrupt vectors; only their names matter on the host
+#define TIMER3_A0_VECTOR 0
+#define TIMER2_A0_VECTOR 1
+#define TIMER1_A0_VECTOR 2
+#define TIMER0_A0_VECTOR 3
+#define USCI_A0_VECTOR 4
+#define USCI_A1_VECTOR 5
+#define USCI_B0_VECTOR 6
+
+// ISRs are ordinary functions the simulator calls
+#define interrupt(vector) used
+
+// Intrinsics
+#define __bis_SR_register(bits) sim_bis_sr(bits)
+#define __bic_SR_register(bits) sim_bic_sr(bits)
+#define __bis_SR_register_on_exit(bits) sim_bis_sr_on_exit(bits)
+#define __bic_SR_register_on_exit(bits) sim_bic_sr_on_exit(bits)
+#define __get_interrupt_state() sim_get_interrupt_state()
+#define __set_interrupt_state(state) sim_set_interrupt_state(state)
+#define __disable_interrupt() sim_bic_sr(GIE)
+#define __enable_interrupt() sim_bis_sr(GIE)
+#define __delay_cycles(cycles) sim_delay_cycles(cycles)
+#define __even_in_range(value, range) (value)
+#define __no_operation() sim_delay_cycles(1)
+
+#endif /* HOST_MSP430_H */
@@ -0,0 +1,104 @@
+/**
+ * @file dac63004w_model.c
+ * @brief Behavioural DAC63004W slave for the simulated SPI bus
+ */
+#include "dac63004w_model.h"
+#include "hardware/dac63004w_regs.h"
+#include <string.h>
+
+static void model_power_on(dac63004w_model_t *model) {
+  memset(model->regs, 0, sizeof(model->regs));
+  memset(model->output, 0, sizeof(model->output));
+  model->regs[DAC_REG_GENERAL_STATUS] = DAC_MODEL_STATUS_DEFAULT;
+  model->read_pending = false;
+}
+
+void dac63004w_model_init(dac63004w_model_t *model, uint8_t cs_port,
+                          uint8_t cs_pin) {
+  memset(model, 0, sizeof(*model));
+  model->cs_port = cs_port;
+  model->cs_mask = (1 << cs_pin);
+  model->stuck_reg = -1;
+  model_power_on(model);
+}
+
+static void model_latch(dac63004w_model_t *model, bool ldac) {
+  for (uint8_t channel = 0; channel < 4; channel++) {
+    uint16_t func = model->regs[DAC_REG_DAC0_FUNC_CONFIG + channel * 6];
+    if (ldac || !(func & DAC_FUNC_CONFIG_SYNC_LDAC)) {
+      model->output[channel] = model->regs[DAC_REG_X_DATA + channel];
+    }
+  }
+}
+
+static void model_frame_done(dac63004w_model_t *model) {
+  uint8_t reg = model->cmd & 0x7F;
+
+  if (model->cmd & DAC_SPI_READ) {
+    model->read_pending = true;
+    model->read_addr = reg;
+    model->reads++;
+    return;
+  }
+
+  if (reg == DAC_REG_NOP) {
+    return;
+  }
+
+  if (reg == DAC_REG_COMMON_TRIGGER) {
+    if ((model->data & 0x0F00) == DAC_RESET_TRIGGER) {
+      model_power_on(model);
+      model->resets++;
+    } else if (model->data & DAC_LDAC_TRIGGER) {
+      model_latch(model, true);
+      model->ldacs++;
+    }
+    return;
+  }
+
+  model->writes++;
+  if (reg >= DAC_MODEL_REG_COUNT || reg == DAC_REG_GENERAL_STATUS ||
+      reg == model->stuck_reg) {
+    return;
+  }
+  model->regs[reg] = model->data;
+  if (reg >= DAC_REG_X_DATA && reg < DAC_REG_X_DATA + 4) {
+    model_latch(model, false);
+  }
+}
+
+static uint8_t model_byte(dac63004w_model_t *model, uint16_t index,
+                          uint8_t mosi) {
+  switch (index) {
+  case 0:
+    // Data requested by the previous frame comes out during this one
+    model->sdo = model->read_pending ? model->regs[model->read_addr] : 0;
+    model->read_pending = false;
+    model->cmd = mosi;
+    return 0x00;
+  case 1:
+    model->data = (uint16_t)mosi << 8;
+    return model->sdo >> 8;
+  case 2:
+    model->data |= mosi;
+    model_frame_done(model);
+    return model->sdo & 0xFF;
+  default:
+    return 0xFF; // Extra bytes are ignored
+  }
+}
+
+uint8_t dac63004w_model_miso(const sim_spi_frame_t *frame, uint16_t index,
+                             uint8_t mosi, void *arg) {
+  uint8_t miso = 0xFF;
+  if (!frame) {
+    return miso;
+  }
+
+  for (dac63004w_model_t *model = arg; model; model = model->next) {
+    if (frame->cs_port == model->cs_port && (frame->cs_mask & model->cs_mask)) {
+      miso &= model_byte(model, index, mosi);
+    }
+  }
+  return miso;
+}
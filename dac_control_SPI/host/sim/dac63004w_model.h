@@ -0,0 +1,56 @@
+/**
+ * @file dac63004w_model.h
+ * @brief Behavioural DAC63004W slave for the simulated SPI bus
+ *
+ * Decodes 24-bit write frames into a register file, answers read commands
+ * on the following frame, and latches data registers into the outputs on
+ * LDAC (or immediately for channels without LDAC sync). Several models can
+ * share the bus by chaining them through `next`.
+ */
+#ifndef DAC63004W_MODEL_H
+#define DAC63004W_MODEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "msp430_sim.h"
+
+#define DAC_MODEL_REG_COUNT 0x40
+
+/**
+ * @brief Default GENERAL_STATUS contents: no faults, a non-zero device ID
+ */
+#define DAC_MODEL_STATUS_DEFAULT 0x0030
+
+typedef struct dac63004w_model {
+    uint8_t cs_port;                       // CS port that selects this DAC
+    uint8_t cs_mask;                       // CS pin that selects this DAC
+    uint16_t regs[DAC_MODEL_REG_COUNT];    // Register file
+    uint16_t output[4];                    // Latched channel codes
+    int16_t stuck_reg;                     // Register that ignores writes, -1 for none
+    uint32_t writes;                       // Register writes decoded
+    uint32_t reads;                        // Read commands decoded
+    uint32_t ldacs;                        // LDAC triggers seen
+    uint32_t resets;                       // Software resets seen
+    struct dac63004w_model *next;          // Next DAC on the same bus
+
+    // Frame decoder
+    uint8_t cmd;
+    uint16_t data;
+    uint16_t sdo;
+    bool read_pending;
+    uint8_t read_addr;
+} dac63004w_model_t;
+
+/**
+ * @brief Put a model into its power-on state
+ */
+void dac63004w_model_init(dac63004w_model_t *model, uint8_t cs_port, uint8_t cs_pin);
+
+/**
+ * @brief sim_miso_fn for a chain of models; pass the first one as arg
+ *
+ * Selected devices drive MISO together, which is modelled as wired-AND.
+ */
+uint8_t dac63004w_model_miso(const sim_spi_frame_t *frame, uint16_t index, uint8_t mosi, void *arg);
+
+#endif /* DAC63004W_MODEL_H */
@@ -0,0 +1,587 @@
+/**
+ * @file msp430_sim.c
+ * @brief Simulated MSP430FR2433 peripherals for host builds of the drivers
+ *
+ * The drivers write registers as plain memory, so the simulator catches up
+ * lazily: every register access first advances virtual time, completes any
+ * SPI bytes whose shift time has passed, looks for CS edges and TXBUF
+ * writes made since the previous access, and then runs any interrupt that
+ * has become pending. Byte writes to TXBUF are detected by parking the
+ * register at an out-of-range value once the byte has been taken.
+ */
+#include "msp430_sim.h"
+#include "msp_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// TXBUF contents once the shifter has taken the byte
+#define SIM_TXBUF_EMPTY 0xFFFF
+
+#define SIM_NO_EVENT UINT64_MAX
+
+// Cycles for interrupt entry and RETI
+#define SIM_ISR_ENTRY_CYCLES 6
+#define SIM_ISR_EXIT_CYCLES 5
+
+#define SIM_NUM_PORTS 3
+#define SIM_NUM_TIMERS 4
+
+// The eUSCI the drivers were built to use (see msp_spi_eusci.h); the
+// others stay in reset
+#if defined(SPI_EUSCI_B0)
+#define SIM_SPI_INDEX SIM_EUSCI_B0
+#define SIM_SPI_ISR USCI_B0_ISR
+#elif defined(SPI_EUSCI_A1)
+#define SIM_SPI_INDEX SIM_EUSCI_A1
+#define SIM_SPI_ISR USCI_A1_ISR
+#else
+#define SIM_SPI_INDEX SIM_EUSCI_A0
+#define SIM_SPI_ISR USCI_A0_ISR
+#endif
+#define SIM_SPI (sim_regs.eusci[SIM_SPI_INDEX])
+
+volatile sim_regs_t sim_regs;
+
+// ISRs come from whichever driver sources are linked in
+void TIMER0_A0_ISR(void) __attribute__((weak));
+void TIMER1_A0_ISR(void) __attribute__((weak));
+void TIMER2_A0_ISR(void) __attribute__((weak));
+void TIMER3_A0_ISR(void) __attribute__((weak));
+void SIM_SPI_ISR(void) __attribute__((weak));
+
+/**
+ * @brief Timer_A counter state behind the registers
+ */
+typedef struct {
+  bool running;
+  uint16_t seen_ctl;
+  uint16_t seen_ex0;
+  uint16_t seen_ccr0;
+  uint64_t origin;     // Time at which the count was base_ticks
+  uint64_t base_ticks; // Count at origin, unwrapped since TACLR
+  uint64_t match_tick; // Unwrapped count of the next CCR0 match
+} sim_timer_t;
+
+static struct {
+  uint64_t now;
+  uint64_t deadline;
+  uint16_t sr;
+  uint16_t exit_set;
+  uint16_t exit_clear;
+  bool in_isr;
+
+  // eUSCI shifter
+  bool in_reset;
+  bool shifting;
+  uint64_t shift_end;
+  uint8_t shift_miso;
+  bool txbuf_full;
+  uint8_t txbuf;
+
+  // Chip selects and the frame being clocked
+  uint8_t seen_out[SIM_NUM_PORTS];
+  bool frame_open;
+  sim_spi_frame_t frame;
+
+  sim_timer_t timers[SIM_NUM_TIMERS];
+
+  sim_miso_fn miso;
+  void *miso_arg;
+
+  sim_spi_frame_t log[SIM_MAX_FRAMES];
+  uint16_t log_count;
+  sim_stats_t stats;
+} g_sim;
+
+static void (*const k_timer_isr[SIM_NUM_TIMERS])(void) = {
+    TIMER0_A0_ISR, TIMER1_A0_ISR, TIMER2_A0_ISR, TIMER3_A0_ISR};
+
+static void sim_fail(const char *message) {
+  fprintf(stderr, "sim: %s at cycle %llu\n", message,
+          (unsigned long long)g_sim.now);
+  abort();
+}
+
+/* Timer_A ---------------------------------------------------------------- */
+
+static uint32_t timer_clock_hz(uint16_t ctl) {
+  switch (ctl & TASSEL_3) {
+  case TASSEL__ACLK:
+    return MSP_ACLK_HZ;
+  case TASSEL__SMCLK:
+    return MSP_SMCLK_HZ;
+  default:
+    return 0; // External TACLK is not modelled
+  }
+}
+
+static uint32_t timer_divider(const volatile sim_timer_regs_t *regs) {
+  return (1u << ((regs->ctl >> 6) & 3)) * ((regs->ex0 & 7) + 1);
+}
+
+/**
+ * @brief Cycles for a number of timer ticks, rounded up
+ */
+static uint64_t timer_ticks_to_cycles(const volatile sim_timer_regs_t *regs,
+                                      uint64_t ticks) {
+  uint64_t scale = (uint64_t)MSP_MCLK_HZ * timer_divider(regs);
+  uint32_t hz = timer_clock_hz(regs->ctl);
+  return (ticks * scale + hz - 1) / hz;
+}
+
+static uint64_t timer_count(int index) {
+  const volatile sim_timer_regs_t *regs = &sim_regs.ta[index];
+  const sim_timer_t *t = &g_sim.timers[index];
+  if (!t->running) {
+    return t->base_ticks;
+  }
+  uint64_t scale = (uint64_t)MSP_MCLK_HZ * timer_divider(regs);
+  return t->base_ticks +
+         (g_sim.now - t->origin) * timer_clock_hz(regs->ctl) / scale;
+}
+
+static uint32_t timer_modulus(int index) {
+  const volatile sim_timer_regs_t *regs = &sim_regs.ta[index];
+  return ((regs->ctl & MC_3) == MC__UP) ? (uint32_t)regs->ccr0 + 1 : 0x10000;
+}
+
+/**
+ * @brief First CCR0 match strictly after the given count
+ */
+static uint64_t timer_next_match(int index, uint64_t count) {
+  uint32_t modulus = timer_modulus(index);
+  uint64_t target = sim_regs.ta[index].ccr0 % modulus;
+  uint64_t match = count - (count % modulus) + target;
+  if (match <= count) {
+    match += modulus;
+  }
+  return match;
+}
+
+static uint64_t timer_event_time(int index) {
+  const sim_timer_t *t = &g_sim.timers[index];
+  if (!t->running || !(sim_regs.ta[index].cctl0 & CCIE)) {
+    return SIM_NO_EVENT;
+  }
+  return t->origin +
+         timer_ticks_to_cycles(&sim_regs.ta[index], t->match_tick -
+                                                        t->base_ticks);
+}
+
+static void timer_service(int index) {
+  volatile sim_timer_regs_t *regs = &sim_regs.ta[index];
+  sim_timer_t *t = &g_sim.timers[index];
+
+  if (regs->ctl & TACLR) {
+    regs->ctl &= ~TACLR; // Self-clearing
+    t->base_ticks = 0;
+    t->origin = g_sim.now;
+    t->seen_ctl = (uint16_t)~regs->ctl; // Force a rebase below
+  }
+
+  if (regs->ctl != t->seen_ctl || regs->ex0 != t->seen_ex0 ||
+      regs->ccr0 != t->seen_ccr0) {
+    // Rebase on the old settings, then continue with the new ones
+    t->base_ticks = timer_count(index);
+    t->origin = g_sim.now;
+    t->seen_ctl = regs->ctl;
+    t->seen_ex0 = regs->ex0;
+    t->seen_ccr0 = regs->ccr0;
+    uint16_t mode = regs->ctl & MC_3;
+    t->running = (mode == MC__UP || mode == MC__CONTINUOUS) &&
+                 timer_clock_hz(regs->ctl);
+    t->match_tick = timer_next_match(index, t->base_ticks);
+  }
+
+  if (!t->running) {
+    return;
+  }
+
+  uint64_t count = timer_count(index);
+  if (count >= t->match_tick) {
+    regs->cctl0 |= CCIFG;
+    t->match_tick = timer_next_match(index, count);
+  }
+}
+
+/* eUSCI ------------------------------------------------------------------ */
+
+static void spi_start_shift(uint8_t mosi, uint64_t start) {
+  sim_spi_frame_t *frame = g_sim.frame_open ? &g_sim.frame : NULL;
+  uint16_t index = frame ? frame->length : 0;
+  uint8_t miso =
+      g_sim.miso ? g_sim.miso(frame, index, mosi, g_sim.miso_arg) : 0xFF;
+
+  if (frame) {
+    if (index < SIM_FRAME_BYTES) {
+      frame->mosi[index] = mosi;
+      frame->miso[index] = miso;
+    }
+    frame->length++;
+    g_sim.stats.bytes++;
+  } else {
+    g_sim.stats.stray_bytes++;
+  }
+
+  uint32_t divider = SIM_SPI.brw ? SIM_SPI.brw : 1;
+  g_sim.shifting = true;
+  g_sim.shift_end =
+      start + (uint64_t)8 * divider * MSP_MCLK_HZ / MSP_SMCLK_HZ;
+  g_sim.shift_miso = miso;
+}
+
+/**
+ * @brief Handle UCSWRST and complete every byte whose shift time has passed
+ */
+static void spi_advance(void) {
+  if (SIM_SPI.ctlw0 & UCSWRST) {
+    if (!g_sim.in_reset) {
+      g_sim.stats.reconfigs++;
+    }
+    g_sim.in_reset = true;
+    g_sim.shifting = false;
+    g_sim.txbuf_full = false;
+    SIM_SPI.ie &= ~(UCRXIE | UCTXIE);
+    SIM_SPI.ifg = UCTXIFG;
+    SIM_SPI.statw &= ~(UCBUSY | UCOE);
+    SIM_SPI.txbuf = SIM_TXBUF_EMPTY;
+    return;
+  }
+  g_sim.in_reset = false;
+
+  while (g_sim.shifting && g_sim.shift_end <= g_sim.now) {
+    if (SIM_SPI.ifg & UCRXIFG) {
+      SIM_SPI.statw |= UCOE;
+      g_sim.stats.overruns++;
+    }
+    SIM_SPI.rxbuf = g_sim.shift_miso;
+    SIM_SPI.ifg |= UCRXIFG;
+    g_sim.shifting = false;
+
+    if (g_sim.txbuf_full) {
+      g_sim.txbuf_full = false;
+      SIM_SPI.ifg |= UCTXIFG;
+      spi_start_shift(g_sim.txbuf, g_sim.shift_end);
+    }
+  }
+}
+
+/**
+ * @brief Pick up a byte written to TXBUF since the last access
+ */
+static void spi_take_txbuf(void) {
+  if (!g_sim.in_reset && SIM_SPI.txbuf != SIM_TXBUF_EMPTY) {
+    uint8_t mosi = (uint8_t)SIM_SPI.txbuf;
+    SIM_SPI.txbuf = SIM_TXBUF_EMPTY;
+
+    if (!g_sim.shifting) {
+      spi_start_shift(mosi, g_sim.now);
+    } else if (!g_sim.txbuf_full) {
+      g_sim.txbuf_full = true;
+      g_sim.txbuf = mosi;
+      SIM_SPI.ifg &= ~UCTXIFG;
+    } else {
+      g_sim.txbuf = mosi;
+      g_sim.stats.tx_overwrites++;
+    }
+  }
+
+  if (g_sim.shifting || g_sim.txbuf_full) {
+    SIM_SPI.statw |= UCBUSY;
+  } else {
+    SIM_SPI.statw &= ~UCBUSY;
+  }
+}
+
+/* Chip selects ----------------------------------------------------------- */
+
+static void frame_close(void) {
+  if (g_sim.shifting) {
+    g_sim.stats.truncated++;
+  }
+
+  g_sim.frame.end = g_sim.now;
+  if (g_sim.log_count < SIM_MAX_FRAMES) {
+    g_sim.log[g_sim.log_count++] = g_sim.frame;
+  }
+  g_sim.stats.frames++;
+  g_sim.frame_open = false;
+}
+
+static void gpio_service(void) {
+  for (int port = 0; port < SIM_NUM_PORTS; port++) {
+    uint8_t out = sim_regs.pout[port];
+    uint8_t cs_pins =
+        sim_regs.pdir[port] & ~sim_regs.psel0[port] & ~sim_regs.psel1[port];
+    uint8_t changed = (out ^ g_sim.seen_out[port]) & cs_pins;
+    g_sim.seen_out[port] = out;
+    if (!changed) {
+      continue;
+    }
+
+    g_sim.stats.cs_edges += __builtin_popcount(changed);
+
+    uint8_t rose = changed & out;
+    uint8_t fell = changed & ~out;
+
+    if (rose && g_sim.frame_open && g_sim.frame.cs_port == port + 1 &&
+        (out & g_sim.frame.cs_mask) == g_sim.frame.cs_mask) {
+      frame_close();
+    }
+
+    if (fell) {
+      if (!g_sim.frame_open) {
+        memset(&g_sim.frame, 0, sizeof(g_sim.frame));
+        g_sim.frame.start = g_sim.now;
+        g_sim.frame.cs_port = port + 1;
+        g_sim.frame_open = true;
+      }
+      g_sim.frame.cs_mask |= fell;
+    }
+  }
+}
+
+/* Core ------------------------------------------------------------------- */
+
+static void sim_service(void) {
+  if (g_sim.now > g_sim.deadline) {
+    sim_fail("time limit exceeded, driver looks hung");
+  }
+
+  for (int i = 0; i < SIM_NUM_TIMERS; i++) {
+    timer_service(i);
+  }
+  spi_advance();
+  gpio_service();
+  spi_take_txbuf();
+}
+
+static void sim_call_isr(void (*isr)(void)) {
+  if (!isr) {
+    sim_fail("interrupt enabled with no ISR linked");
+  }
+
+  // Entry clears GIE and the LPM bits; RETI restores the stacked SR
+  uint16_t saved = g_sim.sr;
+  uint64_t start = g_sim.now;
+  g_sim.sr = 0;
+  g_sim.exit_set = 0;
+  g_sim.exit_clear = 0;
+  g_sim.in_isr = true;
+  g_sim.now += SIM_ISR_ENTRY_CYCLES;
+
+  isr();
+
+  g_sim.now += SIM_ISR_EXIT_CYCLES;
+  g_sim.in_isr = false;
+  g_sim.stats.isr_calls++;
+  g_sim.stats.isr_cycles += g_sim.now - start;
+  g_sim.sr = (saved | g_sim.exit_set) & ~g_sim.exit_clear;
+}
+
+static void sim_dispatch(void) {
+  while ((g_sim.sr & GIE) && !g_sim.in_isr) {
+    void (*isr)(void) = NULL;
+    bool pending = false;
+
+    // Timer vectors rank above the eUSCIs
+    for (int i = 0; i < SIM_NUM_TIMERS && !pending; i++) {
+      volatile uint16_t *cctl0 = &sim_regs.ta[i].cctl0;
+      if ((*cctl0 & (CCIE | CCIFG)) == (CCIE | CCIFG)) {
+        *cctl0 &= ~CCIFG; // CCR0 flags clear on entry
+        isr = k_timer_isr[i];
+        pending = true;
+      }
+    }
+    if (!pending &&
+        (SIM_SPI.ie & SIM_SPI.ifg & (UCRXIFG | UCTXIFG))) {
+      isr = SIM_SPI_ISR;
+      pending = true;
+    }
+    if (!pending) {
+      return;
+    }
+
+    sim_call_isr(isr);
+    sim_service();
+  }
+}
+
+static void sim_step(uint64_t cycles) {
+  g_sim.now += cycles;
+  sim_service();
+  sim_dispatch();
+}
+
+static uint64_t sim_next_event(void) {
+  uint64_t next = SIM_NO_EVENT;
+  if (g_sim.shifting && g_sim.shift_end < next) {
+    next = g_sim.shift_end;
+  }
+  for (int i = 0; i < SIM_NUM_TIMERS; i++) {
+    uint64_t t = timer_event_time(i);
+    if (t < next) {
+      next = t;
+    }
+  }
+  return next;
+}
+
+/**
+ * @brief Check for work that needs SMCLK while LPM3 switches it off
+ */
+static bool sim_smclk_busy(void) {
+  if (g_sim.shifting || g_sim.txbuf_full) {
+    return true;
+  }
+  for (int i = 0; i < SIM_NUM_TIMERS; i++) {
+    if (g_sim.timers[i].running &&
+        (sim_regs.ta[i].ctl & TASSEL_3) == TASSEL__SMCLK) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void sim_sleep(void) {
+  if (g_sim.in_isr) {
+    sim_fail("low-power mode entered from an ISR");
+  }
+  if ((g_sim.sr & SCG1) && sim_smclk_busy()) {
+    g_sim.stats.smclk_stalls++;
+  }
+
+  while (g_sim.sr & CPUOFF) {
+    sim_service();
+    sim_dispatch();
+    if (!(g_sim.sr & CPUOFF)) {
+      break;
+    }
+
+    uint64_t next = sim_next_event();
+    if (next == SIM_NO_EVENT || !(g_sim.sr & GIE)) {
+      sim_fail("CPU asleep with nothing to wake it");
+    }
+    if (next > g_sim.now) {
+      g_sim.now = next;
+    }
+  }
+}
+
+/* Register access and intrinsics ----------------------------------------- */
+
+volatile uint8_t *sim_reg8(volatile uint8_t *reg) {
+  sim_step(SIM_ACCESS_CYCLES);
+  return reg;
+}
+
+volatile uint16_t *sim_reg16(volatile uint16_t *reg) {
+  sim_step(SIM_ACCESS_CYCLES);
+
+  if (reg == &SIM_SPI.iv) {
+    // Reading IV clears the highest pending enabled flag
+    uint16_t pending = SIM_SPI.ie & SIM_SPI.ifg;
+    if (pending & UCRXIFG) {
+      SIM_SPI.iv = USCI_SPI_UCRXIFG;
+      SIM_SPI.ifg &= ~UCRXIFG;
+    } else if (pending & UCTXIFG) {
+      SIM_SPI.iv = USCI_SPI_UCTXIFG;
+      SIM_SPI.ifg &= ~UCTXIFG;
+    } else {
+      SIM_SPI.iv = USCI_NONE;
+    }
+  } else if (reg == &SIM_SPI.rxbuf) {
+    // Drivers only ever read RXBUF, which clears RXIFG and UCOE
+    SIM_SPI.ifg &= ~UCRXIFG;
+    SIM_SPI.statw &= ~UCOE;
+  } else {
+    for (int i = 0; i < SIM_NUM_TIMERS; i++) {
+      if (reg == &sim_regs.ta[i].r) {
+        uint64_t count = timer_count(i);
+        sim_regs.ta[i].r = (uint16_t)(count % timer_modulus(i));
+      }
+    }
+  }
+
+  return reg;
+}
+
+void sim_bis_sr(uint16_t bits) {
+  g_sim.sr |= bits;
+  if (g_sim.sr & CPUOFF) {
+    sim_sleep();
+  } else {
+    sim_step(1);
+  }
+}
+
+void sim_bic_sr(uint16_t bits) {
+  g_sim.sr &= ~bits;
+  sim_step(1);
+}
+
+void sim_bis_sr_on_exit(uint16_t bits) { g_sim.exit_set |= bits; }
+
+void sim_bic_sr_on_exit(uint16_t bits) { g_sim.exit_clear |= bits; }
+
+uint16_t sim_get_interrupt_state(void) { return g_sim.sr & GIE; }
+
+void sim_set_interrupt_state(uint16_t state) {
+  g_sim.sr = (g_sim.sr & ~GIE) | (state & GIE);
+  sim_step(1);
+}
+
+void sim_delay_cycles(uint32_t cycles) { sim_step(cycles); }
+
+/* Test API --------------------------------------------------------------- */
+
+void sim_reset(void) {
+  memset((void *)&sim_regs, 0, sizeof(sim_regs));
+  memset(&g_sim, 0, sizeof(g_sim));
+
+  for (int i = 0; i < 3; i++) {
+    sim_regs.eusci[i].ctlw0 = UCSWRST;
+    sim_regs.eusci[i].ifg = UCTXIFG;
+    sim_regs.eusci[i].txbuf = SIM_TXBUF_EMPTY;
+  }
+  g_sim.in_reset = true;
+  g_sim.deadline = SIM_TIME_LIMIT_CYCLES;
+}
+
+void sim_log_clear(void) {
+  g_sim.log_count = 0;
+  memset(&g_sim.stats, 0, sizeof(g_sim.stats));
+  g_sim.deadline = g_sim.now + SIM_TIME_LIMIT_CYCLES;
+}
+
+void sim_set_miso(sim_miso_fn fn, void *arg) {
+  g_sim.miso = fn;
+  g_sim.miso_arg = arg;
+}
+
+uint64_t sim_cycles(void) { return g_sim.now; }
+
+void sim_run(uint64_t cycles) {
+  uint64_t target = g_sim.now + cycles;
+  uint16_t saved = g_sim.sr;
+
+  g_sim.sr |= GIE;
+  while (g_sim.now < target) {
+    sim_service();
+    sim_dispatch();
+    uint64_t next = sim_next_event();
+    g_sim.now = (next > g_sim.now && next < target) ? next : target;
+  }
+  sim_service();
+  sim_dispatch();
+  g_sim.sr = saved;
+}
+
+const sim_stats_t *sim_stats(void) { return &g_sim.stats; }
+
+uint16_t sim_frame_count(void) { return g_sim.log_count; }
+
+const sim_spi_frame_t *sim_frame(uint16_t index) {
+  return (index < g_sim.log_count) ? &g_sim.log[index] : NULL;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file msp430_sim.h
+ * @brief Simulated MSP430FR2433 peripherals for host builds of the drivers
+ *
+ * Models the eUSCI selected with SPI_EUSCI_* in SPI master mode
+ * (double-buffered TXBUF, RXIFG per byte, UCBUSY, overrun), GPIO chip
+ * selects on P1-P3, Timer_A CCR0 compare and the status register (GIE,
+ * LPM). Time is virtual and counted in MCLK cycles:
+ * each register access costs SIM_ACCESS_CYCLES, __delay_cycles() costs its
+ * argument, and a low-power sleep jumps to the next peripheral event.
+ *
+ * Every CS-low to CS-high span is logged as one frame with its bytes and
+ * timestamps. A CS is any GPIO configured as an output with no peripheral
+ * function selected.
+ */
+#ifndef MSP430_SIM_H
+#define MSP430_SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "msp_clock.h"
+#include <msp430.h>
+
+/**
+ * @brief Virtual cycles charged per register access
+ */
+#define SIM_ACCESS_CYCLES 2
+
+/**
+ * @brief Frames kept in the log; later frames are counted but not stored
+ */
+#define SIM_MAX_FRAMES 256
+
+/**
+ * @brief Bytes stored per logged frame; longer frames keep their length
+ */
+#define SIM_FRAME_BYTES 16
+
+/**
+ * @brief Virtual time after which the simulation aborts as hung (10 s)
+ */
+#define SIM_TIME_LIMIT_CYCLES (10ULL * MSP_MCLK_HZ)
+
+/**
+ * @brief One CS-framed SPI transaction
+ */
+typedef struct {
+    uint64_t start;   // CS falling edge (cycles)
+    uint64_t end;     // CS rising edge (cycles), 0 while still selected
+    uint8_t cs_port;  // Port of the CS pin(s), 1-3
+    uint8_t cs_mask;  // CS pins low during the frame
+    uint16_t length;  // Bytes clocked while selected
+    uint8_t mosi[SIM_FRAME_BYTES];
+    uint8_t miso[SIM_FRAME_BYTES];
+} sim_spi_frame_t;
+
+/**
+ * @brief Bus counters since the last sim_reset() or sim_log_clear()
+ */
+typedef struct {
+    uint32_t frames;        // Completed CS frames
+    uint32_t bytes;         // Bytes clocked inside frames
+    uint32_t cs_edges;      // CS transitions, both directions
+    uint32_t reconfigs;     // SPI eUSCI taken through UCSWRST
+    uint32_t stray_bytes;   // Bytes clocked with no CS asserted
+    uint32_t truncated;     // Frames whose CS rose mid-byte
+    uint32_t overruns;      // RXBUF overwritten before it was read
+    uint32_t tx_overwrites; // TXBUF written while still full
+    uint32_t smclk_stalls;  // Sleeps in LPM3 with SMCLK work pending
+    uint32_t isr_calls;     // Interrupts serviced
+    uint64_t isr_cycles;    // Cycles inside ISRs, entry and RETI included
+} sim_stats_t;
+
+/**
+ * @brief Supplies the byte a slave shifts out on MISO
+ *
+ * Called when a byte enters the shift register.
+ *
+ * @param frame Frame being clocked (NULL if no CS is low)
+ * @param index Byte index within the frame
+ * @param mosi Byte the master is sending
+ * @param arg Argument given to sim_set_miso()
+ * @return uint8_t Byte returned on MISO
+ */
+typedef uint8_t (*sim_miso_fn)(const sim_spi_frame_t *frame, uint16_t index,
+                               uint8_t mosi, void *arg);
+
+/**
+ * @brief Power-on reset of registers, time, log and counters
+ */
+void sim_reset(void);
+
+/**
+ * @brief Clear the frame log and counters; time and registers are kept
+ */
+void sim_log_clear(void);
+
+/**
+ * @brief Install the MISO model (NULL returns 0xFF, an idle pulled-up line)
+ */
+void sim_set_miso(sim_miso_fn fn, void *arg);
+
+/**
+ * @brief Current virtual time in MCLK cycles
+ */
+uint64_t sim_cycles(void);
+
+/**
+ * @brief Let time pass with the CPU idle, servicing interrupts
+ */
+void sim_run(uint64_t cycles);
+
+/**
+ * @brief Bus counters
+ */
+const sim_stats_t *sim_stats(void);
+
+/**
+ * @brief Number of frames stored in the log
+ */
+uint16_t sim_frame_count(void);
+
+/**
+ * @brief Logged frame by index, NULL if out of range
+ */
+const sim_spi_frame_t *sim_frame(uint16_t index);
+
+#endif /* MSP430_SIM_H */
@@ -0,0 +1,854 @@
+/**
+ * @file test_dac63004w.c
+ * @brief Host regression tests for msp_spi.c, dac63004w.c,
+ *        dac63004w_dds.c and dac63004w_playback.c
+ *
+ * Runs the drivers against the simulated register file with a DAC63004W
+ * model on the bus, checks the frames each API call puts on the wire, and
+ * prints the bus cost of each call.
+ */
+#include "dac63004w_model.h"
+#include "hardware/dac63004w.h"
+#include "hardware/dac63004w_dds.h"
+#include "hardware/dac63004w_playback.h"
+#include "msp430_sim.h"
+#include "msp_clock.h"
+#include "msp_delay.h"
+#include "msp_spi.h"
+#include "msp_spi_eusci.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int g_checks;
+static int g_failures;
+
+#define CHECK(cond)                                                            \
+  do {                                                                         \
+    g_checks++;                                                                \
+    if (!(cond)) {                                                             \
+      g_failures++;                                                            \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,         \
+              #cond);                                                          \
+    }                                                                          \
+  } while (0)
+
+#define CHECK_FRAME(index, ...)                                                \
+  check_frame(__FILE__, __LINE__, index, (const uint8_t[]){__VA_ARGS__},       \
+              sizeof((const uint8_t[]){__VA_ARGS__}))
+
+// CS of the second DAC: a port 1 pin the selected eUSCI leaves free
+#ifdef SPI_EUSCI_B0
+#define SECOND_CS_PIN 4
+#else
+#define SECOND_CS_PIN 3
+#endif
+
+static dac63004w_model_t g_model;
+static dac63004w_context_t g_dac;
+
+static void check_frame(const char *file, int line, uint16_t index,
+                        const uint8_t *bytes, uint16_t length) {
+  const sim_spi_frame_t *frame = sim_frame(index);
+  g_checks++;
+  if (!frame || frame->length != length ||
+      memcmp(frame->mosi, bytes, length) != 0) {
+    g_failures++;
+    fprintf(stderr, "%s:%d: frame %u:", file, line, index);
+    if (frame) {
+      for (uint16_t i = 0; i < frame->length && i < SIM_FRAME_BYTES; i++) {
+        fprintf(stderr, " %02X", frame->mosi[i]);
+      }
+    } else {
+      fprintf(stderr, " missing");
+    }
+    fprintf(stderr, ", expected");
+    for (uint16_t i = 0; i < length; i++) {
+      fprintf(stderr, " %02X", bytes[i]);
+    }
+    fprintf(stderr, "\n");
+  }
+}
+
+/**
+ * @brief Print the bus cost of the calls since the last sim_log_clear()
+ */
+static void report(const char *call, uint64_t start) {
+  const sim_stats_t *stats = sim_stats();
+  printf("  %-36s %6lu %6lu %6lu %9.1f\n", call, (unsigned long)stats->frames,
+         (unsigned long)stats->bytes, (unsigned long)stats->cs_edges,
+         (sim_cycles() - start) * 1e6 / MSP_MCLK_HZ);
+}
+
+/**
+ * @brief Fresh MCU and DAC, drivers initialised as in main.c
+ */
+static void setup(void) {
+  sim_reset();
+  dac63004w_model_init(&g_model, 1, 7);
+  sim_set_miso(dac63004w_model_miso, &g_model);
+
+  init_clock();
+  spi_pin_config_t pins = {.mosi_port = SPI_DATA_PORT,
+                           .mosi_pin = SPI_SIMO_PIN,
+                           .miso_port = SPI_DATA_PORT,
+                           .miso_pin = SPI_SOMI_PIN,
+                           .sclk_port = SPI_DATA_PORT,
+                           .sclk_pin = SPI_CLK_PIN,
+                           .cs_port = 1,
+                           .cs_pin = 7};
+  spi_config_t config = {.clock_divider = 8, .mode = 1, .bit_order = 0};
+  CHECK(msp_spi_init(&pins, &config) == SPI_SUCCESS);
+  __enable_interrupt();
+
+  memset(&g_dac, 0, sizeof(g_dac));
+  g_dac.vref_mv = 3300;
+  g_dac.mode = DAC_MODE_VOLTAGE;
+  sim_log_clear();
+}
+
+/**
+ * @brief Checks every test ends with
+ */
+static void teardown(void) {
+  const sim_stats_t *stats = sim_stats();
+  CHECK(!msp_spi_busy());
+  CHECK(stats->stray_bytes == 0);
+  CHECK(stats->truncated == 0);
+  CHECK(stats->tx_overwrites == 0);
+  CHECK(stats->smclk_stalls == 0);
+}
+
+static void test_blocking_transfer(void) {
+  setup();
+  static const uint8_t tx[3] = {0x19, 0x80, 0x00};
+  uint8_t rx[3];
+
+  uint64_t start = sim_cycles();
+  CHECK(msp_spi_transfer(tx, rx, sizeof(tx)) == SPI_SUCCESS);
+  report("msp_spi_transfer (3 bytes)", start);
+
+  CHECK(sim_stats()->frames == 1);
+  CHECK(sim_stats()->cs_edges == 2);
+  CHECK_FRAME(0, 0x19, 0x80, 0x00);
+  const sim_spi_frame_t *frame = sim_frame(0);
+  CHECK(frame->cs_port == 1 && frame->cs_mask == (1 << 7));
+  CHECK(frame->end - frame->start >= 3 * 8 * 8); // 24 bits at SMCLK / 8
+  teardown();
+}
+
+static void test_async_queue(void) {
+  setup();
+  static const uint8_t frames[4][3] = {
+      {0x19, 0x10, 0x00}, {0x1A, 0x20, 0x00}, {0x1B, 0x30, 0x00},
+      {0x20, 0x00, 0x80}};
+
+  uint64_t start = sim_cycles();
+  for (int i = 0; i < 4; i++) {
+    CHECK(msp_spi_submit(frames[i], NULL, 3, NULL, NULL) == SPI_SUCCESS);
+  }
+  uint64_t queued = sim_cycles();
+  msp_spi_flush();
+  report("msp_spi_submit x4 + flush", start);
+
+  CHECK(sim_stats()->frames == 4);
+  CHECK(sim_stats()->cs_edges == 8);
+  CHECK_FRAME(0, 0x19, 0x10, 0x00);
+  CHECK_FRAME(3, 0x20, 0x00, 0x80);
+  // Submitting returns long before the bus is done
+  CHECK(queued < sim_frame(0)->end);
+  for (uint16_t i = 1; i < 4; i++) {
+    CHECK(sim_frame(i)->start >= sim_frame(i - 1)->end);
+  }
+  teardown();
+}
+
+static void test_init_sequence(void) {
+  setup();
+  uint64_t start = sim_cycles();
+  CHECK(dac_init(&g_dac) == DAC_SUCCESS);
+  report("dac_init", start);
+
+  // Reset, SDO enable, 4 x gain, 4 x LDAC sync, common config, LDAC
+  CHECK(sim_stats()->frames == 12);
+  CHECK_FRAME(0, DAC_REG_COMMON_TRIGGER, 0x0A, 0x00);
+  CHECK_FRAME(1, DAC_REG_INTERFACE, 0x00, DAC_INTERFACE_SDO_EN);
+  CHECK_FRAME(11, DAC_REG_COMMON_TRIGGER, 0x00, 0x80);
+  CHECK(g_model.resets == 1);
+  CHECK(g_model.ldacs == 1);
+  CHECK(g_model.regs[DAC_REG_COMMON_CONFIG] == 0x1249);
+  for (uint8_t channel = 0; channel < DAC_NUM_CHANNELS; channel++) {
+    CHECK(g_model.regs[DAC_REG_X_VOUT_CONFIG + channel * 6] ==
+          DAC_VOUT_GAIN_1P5X_INT_REFERENCE);
+    CHECK(g_model.regs[DAC_REG_DAC0_FUNC_CONFIG + channel * 6] ==
+          DAC_FUNC_CONFIG_SYNC_LDAC);
+  }
+  // The reset wait is a real 1 ms sleep
+  CHECK(sim_frame(1)->start - sim_frame(0)->end >= MSP_MCLK_HZ / 1000);
+  teardown();
+}
+
+static void test_write_millivolts(void) {
+  setup();
+  CHECK(dac_init(&g_dac) == DAC_SUCCESS);
+  sim_log_clear();
+
+  uint64_t start = sim_cycles();
+  CHECK(dac_write_millivolts(&g_dac, 0, 2000) == DAC_SUCCESS);
+  msp_spi_flush();
+  report("dac_write_millivolts", start);
+
+  // 2000 mV of 3300 mV full scale = code 2482 (0x9B2), left-justified
+  CHECK(sim_stats()->frames == 2);
+  CHECK(sim_stats()->bytes == 6);
+  CHECK_FRAME(0, 0x19, 0x9B, 0x20);
+  CHECK_FRAME(1, DAC_REG_COMMON_TRIGGER, 0x00, 0x80);
+  CHECK(g_model.output[0] == 0x9B20);
+
+  // Writing the same value again is elided by the register cache
+  sim_log_clear();
+  start = sim_cycles();
+  CHECK(dac_write_millivolts(&g_dac, 0, 2000) == DAC_SUCCESS);
+  msp_spi_flush();
+  report("dac_write_millivolts (unchanged)", start);
+  CHECK(sim_stats()->frames == 0);
+  teardown();
+}
+
+static void test_millivolt_sweep(void) {
+  setup();
+  uint16_t worst = 0;
+  uint16_t init_failures = 0;
+  uint32_t conversions = 0;
+
+  // Every full scale from DAC_VREF_MV_MIN to 6 V and every millivolt below
+  // it against the float conversion in dac_write_voltage()
+  for (uint16_t vref = DAC_VREF_MV_MIN; vref <= 6000; vref++) {
+    g_dac.vref_mv = vref;
+    if (dac_init(&g_dac) != DAC_SUCCESS) {
+      init_failures++;
+    }
+    sim_log_clear();
+
+    float vref_v = vref / 1000.0f;
+    for (uint16_t mv = 0; mv <= vref; mv++) {
+      float volts = mv / 1000.0f;
+      uint16_t expected = (uint16_t)(((volts / vref_v) * 0xFFF) + 0.5f);
+      uint16_t code = dac_millivolts_to_code(&g_dac, mv);
+      uint16_t error = code > expected ? code - expected : expected - code;
+      worst = error > worst ? error : worst;
+      conversions++;
+    }
+  }
+  printf("  %-36s %lu conversions, worst %u LSB\n", "dac_millivolts_to_code",
+         (unsigned long)conversions, worst);
+  CHECK(init_failures == 0);
+  CHECK(worst <= 1);
+
+  g_dac.vref_mv = 3300;
+  teardown();
+}
+
+static void test_write_batch(void) {
+  setup();
+  CHECK(dac_init(&g_dac) == DAC_SUCCESS);
+  sim_log_clear();
+
+  static const dac63004w_update_t updates[DAC_NUM_CHANNELS] = {
+      {0, 0x400}, {1, 0x800}, {2, 0xC00}, {3, 0xFFF}};
+  uint64_t start = sim_cycles();
+  CHECK(dac_write_batch(&g_dac, updates, DAC_NUM_CHANNELS) == DAC_SUCCESS);
+  msp_spi_flush();
+  report("dac_write_batch (4 channels)", start);
+
+  CHECK(sim_stats()->frames == 5);
+  CHECK(g_model.ldacs == 2);
+  CHECK(g_model.output[0] == DAC_DATA_12BIT(0x400));
+  CHECK(g_model.output[3] == DAC_DATA_12BIT(0xFFF));
+  teardown();
+}
+
+static void test_unlatched_data(void) {
+  setup();
+  CHECK(dac_init(&g_dac) == DAC_SUCCESS);
+
+  // A flushed DATA register holds the code but the output waits for LDAC,
+  // so writing the same code still has to latch it
+  CHECK(dac_shadow_stage(&g_dac, DAC_REG_X_DATA, DAC_DATA_12BIT(0x800)) ==
+        DAC_SUCCESS);
+  CHECK(dac_shadow_flush(&g_dac) == DAC_SUCCESS);
+  msp_spi_flush();
+  CHECK(g_model.output[0] != DAC_DATA_12BIT(0x800));
+  sim_log_clear();
+  CHECK(dac_write_code(&g_dac, 0, 0x800) == DAC_SUCCESS);
+  msp_spi_flush();
+  CHECK(sim_stats()->frames == 1);
+  CHECK_FRAME(0, DAC_REG_COMMON_TRIGGER, 0x00, 0x80);
+  CHECK(g_model.output[0] == DAC_DATA_12BIT(0x800));
+
+  // Once latched, the same code is elided again
+  sim_log_clear();
+  CHECK(dac_write_code(&g_dac, 0, 0x800) == DAC_SUCCESS);
+  msp_spi_flush();
+  CHECK(sim_stats()->frames == 0);
+
+  // A batch failing after its first entry leaves that code unlatched
+  static const dac63004w_update_t updates[2] = {{1, 0x123}, {2, 0x456}};
+  CHECK(dac_set_write_verify(&g_dac, true) == DAC_SUCCESS);
+  g_model.stuck_reg = DAC_REG_X_DATA + 2;
+  CHECK(dac_write_batch(&g_dac, updates, 2) == DAC_ERROR_VERIFY);
+  msp_spi_flush();
+  g_model.stuck_reg = -1;
+  CHECK(dac_set_write_verify(&g_dac, false) == DAC_SUCCESS);
+  CHECK(g_model.output[1] != DAC_DATA_12BIT(0x123));
+  sim_log_clear();
+  CHECK(dac_write_code(&g_dac, 1, 0x123) == DAC_SUCCESS);
+  msp_spi_flush();
+  CHECK(sim_stats()->frames == 1);
+  CHECK(g_model.output[1] == DAC_DATA_12BIT(0x123));
+  teardown();
+}
+
+static void test_current_mode(void) {
+  setup();
+  CHECK(dac_init(&g_dac) == DAC_SUCCESS);
+
+  // Range ends in µA, indexed by dac63004w_iout_range_t
+  static const int16_t k_min[] = {0,    0,    0,   0,   -24,  -48,
+                                  -120, -240, -25, -50, -125, -250};
+  static const int16_t k_max[] = {25, 50, 125, 250, 0,   0,
+                                  0,  0,  25,  50,  125, 250};
+  const uint8_t channel = 2;
+  const uint8_t data_reg = DAC_REG_X_DATA + channel;
+  const uint8_t iout_reg = DAC_REG_X_IOUT_MISC_CONFIG + channel * 6;
+  uint16_t config_failures = 0;
+  uint16_t mismatches = 0;
+  uint16_t writes = 0;
+
+  // Every code over every range matches round-to-nearest of offset * 255 /
+  // span, where the offset counts from 0 µA on sink-only ranges and from
+  // the low end on the others
+  for (uint8_t range = 0; range <= DAC_IOUT_RANGE_PM250UA; range++) {
+    if (dac_configure_current_mode(&g_dac, channel, range) != DAC_SUCCESS) {
+      config_failures++;
+      continue;
+    }
+    msp_spi_flush();
+    if ((g_model.regs[iout_reg] & DAC_IOUT_RANGE_MASK) !=
+        (uint16_t)range << DAC_IOUT_RANGE_SHIFT) {
+      config_failures++;
+    }
+
+    uint16_t span = k_max[range] - k_min[range];
+    for (int16_t ua = k_min[range]; ua <= k_max[range]; ua++) {
+      uint16_t offset = k_max[range] == 0 ? -ua : ua - k_min[range];
+      uint16_t expected = (offset * 510U + span) / (2U * span);
+      if (dac_write_current(&g_dac, channel, ua) != DAC_SUCCESS) {
+        mismatches++;
+        continue;
+      }
+      msp_spi_flush();
+      writes++;
+      if (g_model.regs[data_reg] != DAC_DATA_8BIT(expected) ||
+          g_model.output[channel] != DAC_DATA_8BIT(expected)) {
+        mismatches++;
+      }
+    }
+    if (dac_write_current(&g_dac, channel, k_min[range] - 1) !=
+            DAC_ERROR_PARAM ||
+        dac_write_current(&g_dac, channel, k_max[range] + 1) !=
+            DAC_ERROR_PARAM) {
+      mismatches++;
+    }
+  }
+  printf("  %u current writes over 12 ranges, %u mismatched\n", writes,
+         mismatches);
+  CHECK(config_failures == 0);
+  CHECK(mismatches == 0);
+  CHECK(writes == 1794);
+  CHECK(g_dac.mode == DAC_MODE_CURRENT);
+  CHECK((g_model.regs[DAC_REG_COMMON_CONFIG] & DAC_IOUT_PDN(channel)) == 0);
+  CHECK(g_dac.iout_channels == 1 << channel);
+
+  // A batch with a current-mode channel hands it back to VOUT first
+  static const dac63004w_update_t updates[2] = {{0, 0x100}, {channel, 0x800}};
+  CHECK(dac_write_batch(&g_dac, updates, 2) == DAC_SUCCESS);
+  msp_spi_flush();
+  CHECK(g_dac.iout_channels == 0);
+  CHECK(g_dac.mode == DAC_MODE_VOLTAGE);
+  CHECK(g_model.regs[DAC_REG_COMMON_CONFIG] & DAC_IOUT_PDN(channel));
+  CHECK((g_model.regs[DAC_REG_COMMON_CONFIG] &
+         DAC_VOUT_PDN(channel, DAC_VOUT_PDN_HIZ)) == 0);
+  CHECK(g_model.output[channel] == DAC_DATA_12BIT(0x800));
+  CHECK(g_model.output[0] == DAC_DATA_12BIT(0x100));
+  teardown();
+}
+
+static void test_readback(void) {
+  setup();
+  CHECK(dac_init(&g_dac) == DAC_SUCCESS);
+  sim_log_clear();
+
+  uint16_t value = 0;
+  uint64_t start = sim_cycles();
+  CHECK(dac_read_register(&g_dac, DAC_REG_COMMON_CONFIG, &value) ==
+        DAC_SUCCESS);
+  report("dac_read_register", start);
+  CHECK(value == 0x1249);
+  CHECK_FRAME(0, DAC_SPI_READ | DAC_REG_COMMON_CONFIG, 0x00, 0x00);
+
+  uint16_t status = 0;
+  CHECK(dac_check_status(&g_dac, &status) == DAC_SUCCESS);
+  CHECK(status == DAC_MODEL_STATUS_DEFAULT);
+  g_model.regs[DAC_REG_GENERAL_STATUS] |= DAC_STATUS_NVM_CRC_FAIL_USER;
+  CHECK(dac_check_status(&g_dac, &status) == DAC_ERROR_CRC);
+
+  uint8_t mismatches = 0xFF;
+  sim_log_clear();
+  start = sim_cycles();
+  CHECK(dac_verify_config(&g_dac, &mismatches) == DAC_SUCCESS);
+  report("dac_verify_config", start);
+  CHECK(mismatches == 0);
+
+  g_model.regs[DAC_REG_COMMON_CONFIG] = 0;
+  CHECK(dac_verify_config(&g_dac, &mismatches) == DAC_ERROR_VERIFY);
+  CHECK(mismatches == 1);
+  teardown();
+}
+
+static void test_verified_write(void) {
+  setup();
+  CHECK(dac_init(&g_dac) == DAC_SUCCESS);
+  CHECK(dac_set_write_verify(&g_dac, true) == DAC_SUCCESS);
+  sim_log_clear();
+
+  uint64_t start = sim_cycles();
+  CHECK(dac_write_code(&g_dac, 1, 0x123) == DAC_SUCCESS);
+  msp_spi_flush();
+  report("dac_write_code (verified)", start);
+  // Data, read command, NOP carrying the data back, LDAC
+  CHECK(sim_stats()->frames == 4);
+
+  g_model.stuck_reg = DAC_REG_X_DATA + 1;
+  CHECK(dac_write_code(&g_dac, 1, 0x456) == DAC_ERROR_VERIFY);
+  msp_spi_flush();
+  teardown();
+}
+
+static void test_funcgen(void) {
+  setup();
+  CHECK(dac_init(&g_dac) == DAC_SUCCESS);
+
+  static const dac63004w_funcgen_config_t config = {
+      .shape = DAC_FUNC_CONFIG_TRIANGLE,
+      .phase = DAC_PHASE_SEL_0,
+      .slew = DAC_SLEW_RATE_4_US,
+      .code_step = DAC_CODE_STEP_32_LSB,
+      .margin_low = 0x100,
+      .margin_high = 0xF00};
+  CHECK(dac_funcgen_configure(&g_dac, 1, &config) == DAC_SUCCESS);
+  msp_spi_flush();
+  CHECK(g_model.regs[DAC_REG_DAC0_MARGIN_HIGH + 6] == DAC_DATA_12BIT(0xF00));
+  CHECK(g_model.regs[DAC_REG_DAC0_MARGIN_LOW + 6] == DAC_DATA_12BIT(0x100));
+  CHECK(g_model.regs[DAC_REG_DAC1_FUNC_CONFIG] ==
+        (DAC_CODE_STEP_32_LSB | DAC_SLEW_RATE_4_US));
+
+  // START-FUNC-0 is the top nibble of COMMON-DAC-TRIG, START-FUNC-3 the bottom
+  sim_log_clear();
+  CHECK(dac_funcgen_start(&g_dac, 1 << 1) == DAC_SUCCESS);
+  msp_spi_flush();
+  CHECK_FRAME(0, DAC_REG_COMMON_DAC_TRIG, 0x01, 0x00);
+  CHECK(dac_funcgen_start(&g_dac, (1 << 0) | (1 << 3)) == DAC_SUCCESS);
+  msp_spi_flush();
+  CHECK(g_model.regs[DAC_REG_COMMON_DAC_TRIG] == 0x1101);
+
+  CHECK(dac_funcgen_stop(&g_dac, 1 << 0) == DAC_SUCCESS);
+  msp_spi_flush();
+  CHECK(g_model.regs[DAC_REG_COMMON_DAC_TRIG] == 0x0101);
+  CHECK(dac_funcgen_stop(&g_dac, (1 << 1) | (1 << 3)) == DAC_SUCCESS);
+  msp_spi_flush();
+  CHECK(g_model.regs[DAC_REG_COMMON_DAC_TRIG] == 0);
+
+  // Stopped channels are LDAC-synchronised with no slew again: a data write
+  // waits, and a batch changes both channels on its one LDAC frame
+  CHECK(g_model.regs[DAC_REG_DAC1_FUNC_CONFIG] == DAC_FUNC_CONFIG_SYNC_LDAC);
+  uint16_t held = g_model.output[1];
+  CHECK(dac_shadow_stage(&g_dac, DAC_REG_X_DATA + 1, DAC_DATA_12BIT(0x234)) ==
+        DAC_SUCCESS);
+  CHECK(dac_shadow_flush(&g_dac) == DAC_SUCCESS);
+  msp_spi_flush();
+  CHECK(g_model.output[1] == held);
+  static const dac63004w_update_t updates[2] = {{1, 0x345}, {3, 0x456}};
+  CHECK(dac_write_batch(&g_dac, updates, 2) == DAC_SUCCESS);
+  msp_spi_flush();
+  CHECK(g_model.output[1] == DAC_DATA_12BIT(0x345));
+  CHECK(g_model.output[3] == DAC_DATA_12BIT(0x456));
+  teardown();
+}
+
+static void test_multi_device(void) {
+  setup();
+  dac63004w_model_t second;
+  dac63004w_model_init(&second, 1, SECOND_CS_PIN);
+  g_model.next = &second;
+
+  spi_config_t config = {.clock_divider = 8, .mode = 1, .bit_order = 0};
+  spi_device_t device;
+  CHECK(msp_spi_device_init(&device, 1, SECOND_CS_PIN, &config) == SPI_SUCCESS);
+
+  dac63004w_context_t dac2 = g_dac;
+  dac2.spi = &device;
+  CHECK(dac_init(&g_dac) == DAC_SUCCESS);
+  CHECK(dac_init(&dac2) == DAC_SUCCESS);
+  CHECK(g_model.resets == 1 && second.resets == 1);
+
+  // Stage new codes on both DACs, then update them with one frame
+  CHECK(dac_shadow_stage(&g_dac, DAC_REG_X_DATA, DAC_DATA_12BIT(0x100)) ==
+        DAC_SUCCESS);
+  CHECK(dac_shadow_stage(&dac2, DAC_REG_X_DATA, DAC_DATA_12BIT(0x200)) ==
+        DAC_SUCCESS);
+  CHECK(dac_shadow_flush(&g_dac) == DAC_SUCCESS);
+  CHECK(dac_shadow_flush(&dac2) == DAC_SUCCESS);
+  msp_spi_flush();
+  CHECK(g_model.output[0] == 0 && second.output[0] == 0);
+
+  const spi_device_t *members[2] = {NULL, &device};
+  spi_device_t group;
+  CHECK(msp_spi_group_init(&group, members, 2) == SPI_SUCCESS);
+
+  sim_log_clear();
+  uint64_t start = sim_cycles();
+  CHECK(dac_broadcast_ldac(&group) == DAC_SUCCESS);
+  msp_spi_flush();
+  report("dac_broadcast_ldac (2 DACs)", start);
+  CHECK(sim_stats()->frames == 1);
+  CHECK(sim_frame(0)->cs_mask == ((1 << 7) | (1 << SECOND_CS_PIN)));
+  CHECK(g_model.output[0] == DAC_DATA_12BIT(0x100));
+  CHECK(second.output[0] == DAC_DATA_12BIT(0x200));
+
+  // LDAC and reset reach only the context's own device
+  CHECK(dac_shadow_stage(&dac2, DAC_REG_X_DATA, DAC_DATA_12BIT(0x300)) ==
+        DAC_SUCCESS);
+  CHECK(dac_shadow_flush(&dac2) == DAC_SUCCESS);
+  msp_spi_flush();
+  sim_log_clear();
+  CHECK(dac_trigger_ldac(&dac2) == DAC_SUCCESS);
+  msp_spi_flush();
+  CHECK(sim_stats()->frames == 1);
+  CHECK(sim_frame(0)->cs_mask == (1 << SECOND_CS_PIN));
+  CHECK(second.output[0] == DAC_DATA_12BIT(0x300));
+  CHECK(g_model.output[0] == DAC_DATA_12BIT(0x100));
+  CHECK(dac_reset(&dac2) == DAC_SUCCESS);
+  msp_spi_flush();
+  CHECK(g_model.resets == 1 && second.resets == 2);
+
+  // A device in another mode reprograms the eUSCI only when the bus changes hands
+  spi_config_t mode0 = {.clock_divider = 4, .mode = 0, .bit_order = 0};
+  spi_device_t other;
+  CHECK(msp_spi_device_init(&other, 2, 0, &mode0) == SPI_SUCCESS);
+  static const uint8_t tx[2] = {0xAA, 0x55};
+  sim_log_clear();
+  CHECK(msp_spi_transfer_to(&other, tx, NULL, 2) == SPI_SUCCESS);
+  CHECK(msp_spi_transfer_to(&other, tx, NULL, 2) == SPI_SUCCESS);
+  CHECK(sim_stats()->reconfigs == 1);
+  CHECK(msp_spi_transfer(tx, NULL, 2) == SPI_SUCCESS);
+  CHECK(sim_stats()->reconfigs == 2);
+  CHECK(sim_frame(0)->cs_port == 2);
+
+  CHECK(msp_spi_group_init(&group, (const spi_device_t *[]){NULL, &other},
+                           2) == SPI_ERROR_PARAM);
+  teardown();
+}
+
+static void test_delay(void) {
+  setup();
+  uint64_t start = sim_cycles();
+  delay_ms(50);
+  uint64_t elapsed = sim_cycles() - start;
+  report("delay_ms(50)", start);
+
+  // Never short, and late by no more than an ACLK tick plus overhead
+  CHECK(elapsed >= 50 * (MSP_MCLK_HZ / 1000));
+  CHECK(elapsed < 50 * (MSP_MCLK_HZ / 1000) + 2 * MSP_MCLK_HZ / MSP_ACLK_HZ);
+
+  // Frames still queued keep SMCLK alive through the delay
+  static const uint8_t tx[3] = {0x19, 0x80, 0x00};
+  CHECK(msp_spi_submit(tx, NULL, sizeof(tx), NULL, NULL) == SPI_SUCCESS);
+  delay_ms(1);
+  CHECK(sim_stats()->frames == 1);
+  teardown();
+}
+
+static void test_dds(void) {
+  setup();
+  CHECK(dac_init(&g_dac) == DAC_SUCCESS);
+
+  // Nothing to report before the first start
+  CHECK(dac_dds_frequency_mhz() == 0);
+
+  // Interpolated quarter-wave table against the real sine, whole cycle
+  int max_error = 0;
+  for (uint32_t i = 0; i < 4096; i++) {
+    uint32_t phase = i * (0x100000000ULL / 4096) + i * 97;
+    double ideal = 2048 + 2047 * sin(phase * (2 * M_PI / 4294967296.0));
+    int error = abs(dac_dds_sample(phase, 2047, 2048) - (int)lround(ideal));
+    max_error = error > max_error ? error : max_error;
+  }
+  CHECK(max_error <= 1);
+  CHECK(dac_dds_sample(0, 2047, 2048) == 2048);
+  CHECK(dac_dds_sample(0x40000000, 2047, 2048) == 4095);
+  CHECK(dac_dds_sample(0xC0000000, 2047, 2048) == 1);
+
+  // 1 mHz steps at 1 kHz move the tuning word by 2^32 / 10^6. 1 kHz leaves
+  // the ISR enough cycles at every MCLK setting.
+  uint32_t period = MSP_SMCLK_HZ / 1000;
+  CHECK(dac_dds_tuning_word(200000, period) == 858993459);
+  uint32_t step = dac_dds_tuning_word(200001, period) -
+                  dac_dds_tuning_word(200000, period);
+  CHECK(step == 4294 || step == 4295);
+
+  // 200 Hz at 1 kHz: one frame per sample period, exactly on the tick
+  dac_dds_config_t tone = {.sample_rate_hz = 1000,
+                           .start_mhz = 200000,
+                           .amplitude = 2000,
+                           .offset = 2048};
+  CHECK(dac_dds_start(&g_dac, 0, &tone) == DAC_SUCCESS);
+  CHECK(g_model.regs[DAC_REG_DAC0_FUNC_CONFIG] == 0);
+  sim_log_clear();
+  uint64_t start = sim_cycles();
+  sim_run(20 * period);
+  report("dac_dds (20 samples)", start);
+  CHECK(sim_stats()->frames == 20);
+  uint32_t word = dac_dds_tuning_word(tone.start_mhz, period);
+  for (uint16_t i = 0; i < 20 && i < sim_frame_count(); i++) {
+    uint16_t data = DAC_DATA_12BIT(dac_dds_sample(i * word, 2000, 2048));
+    CHECK_FRAME(i, 0x19, data >> 8, data & 0xFF);
+    if (i) {
+      CHECK(sim_frame(i)->start - sim_frame(i - 1)->start == period);
+    }
+  }
+  CHECK(g_model.output[0] == DAC_DATA_12BIT(dac_dds_sample(19 * word, 2000,
+                                                           2048)));
+  CHECK(dac_dds_frequency_mhz() == 200000);
+  CHECK(dac_dds_dropped() == 0);
+  CHECK(dac_dds_stop(&g_dac) == DAC_SUCCESS);
+  CHECK(!dac_dds_active());
+  msp_spi_flush();
+  CHECK(g_model.regs[DAC_REG_DAC0_FUNC_CONFIG] == DAC_FUNC_CONFIG_SYNC_LDAC);
+
+  // 20 Hz to 40 Hz over 50 ms (50 samples), then hold
+  dac_dds_config_t sweep = {.sample_rate_hz = 1000,
+                            .start_mhz = 20000,
+                            .stop_mhz = 40000,
+                            .sweep_ms = 50,
+                            .amplitude = 1000,
+                            .offset = 2048};
+  CHECK(dac_dds_start(&g_dac, 1, &sweep) == DAC_SUCCESS);
+  sim_run(25 * period + period / 2);
+  uint32_t mid = dac_dds_frequency_mhz();
+  CHECK(mid >= 29999 && mid <= 30001);
+  sim_run(30 * period);
+  CHECK(dac_dds_frequency_mhz() == 40000);
+  CHECK(dac_dds_stop(&g_dac) == DAC_SUCCESS);
+
+  // A period shorter than the frame plus the synthesis is refused
+  uint32_t min_period =
+      dac_playback_frame_cycles(g_dac.spi) + DAC_DDS_SYNTH_CYCLES;
+  tone.sample_rate_hz = MSP_SMCLK_HZ / (min_period - 10);
+  CHECK(dac_dds_start(&g_dac, 0, &tone) == DAC_ERROR_PARAM);
+  CHECK(!dac_dds_active());
+  tone.sample_rate_hz = MSP_SMCLK_HZ / min_period;
+  CHECK(dac_dds_start(&g_dac, 0, &tone) == DAC_SUCCESS);
+  CHECK(dac_dds_stop(&g_dac) == DAC_SUCCESS);
+  tone.sample_rate_hz = 1000;
+
+  // Nyquist and code range
+  tone.start_mhz = 1000000;
+  CHECK(dac_dds_start(&g_dac, 0, &tone) == DAC_ERROR_PARAM);
+  tone.start_mhz = 1000;
+  tone.offset = 4000;
+  CHECK(dac_dds_start(&g_dac, 0, &tone) == DAC_ERROR_PARAM);
+  msp_spi_flush();
+  teardown();
+}
+
+static void test_playback(void) {
+  setup();
+  CHECK(dac_init(&g_dac) == DAC_SUCCESS);
+
+  // A 16-step ramp, one frame per sample at 2 kHz
+  static dac_frame_t frames[16];
+  uint16_t codes[16];
+  for (uint16_t i = 0; i < 16; i++) {
+    codes[i] = i * 0x111;
+  }
+  CHECK(dac_playback_encode(frames, codes, 16, 2) == DAC_SUCCESS);
+  uint32_t period = MSP_SMCLK_HZ / 2000;
+
+  CHECK(dac_playback_start(&g_dac, 2, frames, 16, 2000, false) ==
+        DAC_SUCCESS);
+  CHECK(g_model.regs[DAC_REG_DAC2_FUNC_CONFIG] == 0);
+  sim_log_clear();
+  uint64_t start = sim_cycles();
+  sim_run(20 * period);
+  report("dac_playback (16 samples)", start);
+
+  CHECK(sim_stats()->frames == 16);
+  CHECK(!dac_playback_active());
+  CHECK(dac_playback_dropped() == 0);
+  for (uint16_t i = 0; i < 16 && i < sim_frame_count(); i++) {
+    uint16_t data = DAC_DATA_12BIT(codes[i]);
+    CHECK_FRAME(i, 0x1B, data >> 8, data & 0xFF);
+    if (i) {
+      CHECK(sim_frame(i)->start - sim_frame(i - 1)->start == period);
+    }
+  }
+  CHECK(g_model.output[2] == DAC_DATA_12BIT(codes[15]));
+
+  // The simulated bus only charges register accesses, so the ISR cost it
+  // measures can only be held against the reported bound from below
+  uint32_t isr_cycles =
+      (uint32_t)(sim_stats()->isr_cycles / sim_stats()->isr_calls);
+  spi_config_t config = {.clock_divider = 8, .mode = 1, .bit_order = 0};
+  dac_playback_timing_t timing;
+  dac_playback_timing(&config, &timing);
+  printf("  %-36s %6lu cycles/sample, %u reported\n", "dac_playback ISR",
+         (unsigned long)isr_cycles, timing.frame_cycles);
+  CHECK(isr_cycles <= timing.frame_cycles);
+  CHECK(timing.max_rate_hz == MSP_SMCLK_HZ / timing.frame_cycles);
+  CHECK(dac_playback_frame_cycles(g_dac.spi) == timing.frame_cycles);
+
+  // Anything faster than the reported maximum is refused up front
+  CHECK(dac_playback_start(&g_dac, 2, frames, 16, timing.max_rate_hz + 1,
+                           true) == DAC_ERROR_PARAM);
+  CHECK(!dac_playback_active());
+
+  // Looping at 90% of the reported maximum keeps exact pacing and drops
+  // nothing. At 100% the ISR would leave the main loop no time at all.
+  uint32_t rate = timing.max_rate_hz / 10 * 9;
+  uint32_t fast = (MSP_SMCLK_HZ + rate / 2) / rate;
+  CHECK(dac_playback_start(&g_dac, 2, frames, 16, rate, true) == DAC_SUCCESS);
+  sim_log_clear();
+  sim_run(40 * fast);
+  CHECK(dac_playback_active());
+  CHECK(dac_playback_dropped() == 0);
+  CHECK(sim_stats()->frames >= 39);
+  for (uint16_t i = 1; i < sim_frame_count(); i++) {
+    uint16_t data = DAC_DATA_12BIT(codes[i % 16]);
+    CHECK_FRAME(i, 0x1B, data >> 8, data & 0xFF);
+    CHECK(sim_frame(i)->start - sim_frame(i - 1)->start == fast);
+  }
+
+  CHECK(dac_playback_stop(&g_dac) == DAC_SUCCESS);
+  CHECK(!dac_playback_active());
+  msp_spi_flush();
+  CHECK(g_model.regs[DAC_REG_DAC2_FUNC_CONFIG] == DAC_FUNC_CONFIG_SYNC_LDAC);
+  teardown();
+}
+
+/**
+ * @brief Read COMMON-CONFIG over and over with a timer ISR sending frames
+ *
+ * @return Number of the 50 reads that returned the value dac_init() wrote
+ */
+static uint16_t read_config_repeatedly(void) {
+  uint16_t reads_ok = 0;
+  for (uint16_t i = 0; i < 50; i++) {
+    uint16_t value = 0;
+    if (dac_read_register(&g_dac, DAC_REG_COMMON_CONFIG, &value) ==
+            DAC_SUCCESS &&
+        value == 0x1249) {
+      reads_ok++;
+    }
+  }
+  return reads_ok;
+}
+
+/**
+ * @brief Count frames that are not a whole 3-byte frame on CS P1.7, or
+ *        that overlap the frame before
+ */
+static uint16_t count_bad_frames(void) {
+  uint16_t bad_frames = 0;
+  for (uint16_t i = 0; i < sim_frame_count(); i++) {
+    if (sim_frame(i)->length != 3 || sim_frame(i)->cs_mask != (1 << 7) ||
+        (i && sim_frame(i)->start < sim_frame(i - 1)->end)) {
+      bad_frames++;
+    }
+  }
+  return bad_frames;
+}
+
+static void test_playback_vs_blocking(void) {
+  setup();
+  CHECK(dac_init(&g_dac) == DAC_SUCCESS);
+
+  // Samples due while a blocking transfer owns the bus are dropped; the
+  // transfer's bytes and CS frame stay intact
+  static dac_frame_t frames[4];
+  static const uint16_t codes[4] = {0x100, 0x200, 0x300, 0x400};
+  CHECK(dac_playback_encode(frames, codes, 4, 1) == DAC_SUCCESS);
+  uint32_t rate = MSP_SMCLK_HZ / 600; // A frame due every few reads
+  CHECK(dac_playback_start(&g_dac, 1, frames, 4, rate, true) == DAC_SUCCESS);
+  sim_log_clear();
+
+  CHECK(read_config_repeatedly() == 50);
+  CHECK(dac_playback_dropped() > 0);
+  CHECK(count_bad_frames() == 0);
+  CHECK(sim_stats()->overruns == 0);
+
+  CHECK(dac_playback_stop(&g_dac) == DAC_SUCCESS);
+  msp_spi_flush();
+  teardown();
+}
+
+static void test_dds_vs_blocking(void) {
+  setup();
+  CHECK(dac_init(&g_dac) == DAC_SUCCESS);
+
+  // As for playback: ticks during a blocking transfer drop their sample.
+  // The shortest period dac_dds_start() accepts is still due every few reads.
+  uint32_t period =
+      dac_playback_frame_cycles(g_dac.spi) + DAC_DDS_SYNTH_CYCLES;
+  dac_dds_config_t tone = {.sample_rate_hz = MSP_SMCLK_HZ / period,
+                           .start_mhz = 100000,
+                           .amplitude = 1000,
+                           .offset = 2048};
+  CHECK(dac_dds_start(&g_dac, 2, &tone) == DAC_SUCCESS);
+  sim_log_clear();
+
+  CHECK(read_config_repeatedly() == 50);
+  CHECK(dac_dds_dropped() > 0);
+  CHECK(count_bad_frames() == 0);
+  CHECK(sim_stats()->overruns == 0);
+
+  CHECK(dac_dds_stop(&g_dac) == DAC_SUCCESS);
+  msp_spi_flush();
+  teardown();
+}
+
+int main(void) {
+  printf("  %-36s %6s %6s %6s %9s\n", "call", "frames", "bytes", "cs", "us");
+
+  test_blocking_transfer();
+  test_async_queue();
+  test_init_sequence();
+  test_write_millivolts();
+  test_millivolt_sweep();
+  test_write_batch();
+  test_unlatched_data();
+  test_current_mode();
+  test_readback();
+  test_verified_write();
+  test_funcgen();
+  test_multi_device();
+  test_delay();
+  test_dds();
+  test_playback();
+  test_playback_vs_blocking();
+  test_dds_vs_blocking();
+
+  printf("%d checks, %d failed\n", g_checks, g_failures);
+  return g_failures ? 1 : 0;
+}
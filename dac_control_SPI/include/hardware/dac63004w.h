@@ -1,14 +1,18 @@
 #ifndef DAC63004W_H
 #define DAC63004W_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "hardware/dac63004w_regs.h"
+#include "msp_spi.h"
 
 typedef enum {
     DAC_SUCCESS = 0,
     DAC_ERROR_INIT = -1,
     DAC_ERROR_PARAM = -2,
-    DAC_ERROR_COMM = -3
+    DAC_ERROR_COMM = -3,
+    DAC_ERROR_VERIFY = -4,
+    DAC_ERROR_CRC = -5
 } dac63004w_status_t;
 
 typedef enum {
@@ -16,19 +20,286 @@ typedef enum {
     DAC_MODE_CURRENT = 1
 } dac63004w_mode_t;
 
+/**
+ * @brief Current output ranges (DAC-X-IOUT-MISC-CONFIG IOUT-RANGE-X)
+ */
+typedef enum {
+    DAC_IOUT_RANGE_0_25UA = 0x0,        // 0 to +25 µA
+    DAC_IOUT_RANGE_0_50UA = 0x1,        // 0 to +50 µA
+    DAC_IOUT_RANGE_0_125UA = 0x2,       // 0 to +125 µA
+    DAC_IOUT_RANGE_0_250UA = 0x3,       // 0 to +250 µA
+    DAC_IOUT_RANGE_0_N24UA = 0x4,       // 0 to -24 µA
+    DAC_IOUT_RANGE_0_N48UA = 0x5,       // 0 to -48 µA
+    DAC_IOUT_RANGE_0_N120UA = 0x6,      // 0 to -120 µA
+    DAC_IOUT_RANGE_0_N240UA = 0x7,      // 0 to -240 µA
+    DAC_IOUT_RANGE_PM25UA = 0x8,        // -25 to +25 µA
+    DAC_IOUT_RANGE_PM50UA = 0x9,        // -50 to +50 µA
+    DAC_IOUT_RANGE_PM125UA = 0xA,       // -125 to +125 µA
+    DAC_IOUT_RANGE_PM250UA = 0xB        // -250 to +250 µA
+} dac63004w_iout_range_t;
+
+/**
+ * @brief Fractional bits of the precomputed microamp-to-code scale
+ */
+#define DAC_IOUT_SCALE_Q    12
+
+/**
+ * @brief Number of output channels on the DAC63004W
+ */
+#define DAC_NUM_CHANNELS 4
+
+/**
+ * @brief One entry of a batched channel update
+ */
+typedef struct {
+    uint8_t channel;            // Output channel (0-3)
+    uint16_t code;              // 12-bit DAC code, right aligned
+} dac63004w_update_t;
+
+/**
+ * @brief Fractional bits of the precomputed millivolt-to-code scale
+ *
+ * With Q14 the scale fits 16 bits for any full-scale voltage of at least
+ * DAC_VREF_MV_MIN, so conversion is one 16x16 hardware multiply and a
+ * constant shift.
+ */
+#define DAC_SCALE_Q         14
+#define DAC_VREF_MV_MIN     1024
+
+/**
+ * @brief Built-in function generator setup for one channel
+ *
+ * Triangle and sawtooth waves sweep between the two margins in code_step
+ * increments, one step per slew period. The sine shape uses the device's
+ * fixed 24-point table.
+ */
+typedef struct {
+    uint16_t shape;             // DAC_FUNC_CONFIG_TRIANGLE, _SAWTOOTH, ...
+    uint16_t phase;             // DAC_PHASE_SEL_*
+    slew_rate_t slew;           // Time per step
+    uint16_t code_step;         // DAC_CODE_STEP_*
+    uint16_t margin_low;        // 12-bit lower limit
+    uint16_t margin_high;       // 12-bit upper limit
+} dac63004w_funcgen_config_t;
+
+/**
+ * @brief Number of register addresses covered by the shadow cache
+ */
+#define DAC_REG_COUNT 0x27
+
+/**
+ * @brief Copy of the device registers kept by the driver
+ *
+ * A write whose value matches a valid, clean entry is skipped. Staged
+ * values are marked dirty and go out on the next dac_shadow_flush().
+ * COMMON-TRIGGER is never cached since every write to it is an action.
+ * DATA registers written since the last LDAC are tracked separately, as a
+ * matching code there is in the device but not yet on the output.
+ */
+typedef struct {
+    uint16_t value[DAC_REG_COUNT];          // Last value written or staged
+    uint8_t valid[(DAC_REG_COUNT + 7) / 8]; // Entry is known
+    uint8_t dirty[(DAC_REG_COUNT + 7) / 8]; // Entry staged, not yet written
+    uint8_t unlatched;                      // Bit n: channel n DATA awaits LDAC
+    uint32_t issued;                        // Frames sent to the device
+    uint32_t skipped;                       // Redundant frames elided
+} dac63004w_shadow_t;
+
 /**
  * @brief DAC device context
  */
 typedef struct {
-    float vref;                 // Reference voltage (V)
+    const spi_device_t *spi;    // Bus device, NULL for the msp_spi_init() one
+    uint16_t vref_mv;           // Full-scale output voltage (mV)
     dac63004w_mode_t mode;      // Operating mode (voltage or current)
+    uint16_t mv_scale;          // Code per mV in Q14, set by dac_init()
+    dac63004w_shadow_t shadow;  // Register cache, reset by dac_init()
+    uint8_t iout_channels;      // Bit n set while channel n is in IOUT mode
+    int16_t iout_min_ua[DAC_NUM_CHANNELS];  // Low end of each IOUT range
+    int16_t iout_max_ua[DAC_NUM_CHANNELS];  // High end of each IOUT range
+    uint16_t iout_scale[DAC_NUM_CHANNELS];  // Code per µA in Q12
+    bool verify_writes;         // Read back every register write
 } dac63004w_context_t;
 
 dac63004w_status_t dac_init(dac63004w_context_t *ctx);
+
+/**
+ * @brief Write a raw 12-bit code to a channel and latch it
+ */
+dac63004w_status_t dac_write_code(dac63004w_context_t *ctx, uint8_t channel, uint16_t code);
+
+/**
+ * @brief Write an output voltage in millivolts without floating point
+ */
+dac63004w_status_t dac_write_millivolts(dac63004w_context_t *ctx, uint8_t channel, uint16_t millivolts);
+
+/**
+ * @brief Code that dac_write_millivolts() sends for a voltage
+ *
+ * Uses the scale precomputed by dac_init(). Within 1 LSB of the float
+ * conversion in dac_write_voltage() for any full scale from
+ * DAC_VREF_MV_MIN to 6000 mV.
+ */
+uint16_t dac_millivolts_to_code(const dac63004w_context_t *ctx, uint16_t millivolts);
+
+/**
+ * @brief Write an output voltage in volts
+ *
+ * Kept for compatibility; pulls in the soft-float library. Prefer
+ * dac_write_millivolts() on the update path.
+ */
 dac63004w_status_t dac_write_voltage(dac63004w_context_t *ctx, uint8_t channel, float voltage);
+
+/**
+ * @brief Write several channel codes and latch them with a single LDAC
+ *
+ * All entries are validated before anything is queued. Channels in current
+ * mode go back to voltage mode with their last gain first.
+ * The data frames are queued back to back and followed by one LDAC frame,
+ * so every listed channel changes on the same edge.
+ */
+dac63004w_status_t dac_write_batch(dac63004w_context_t *ctx, const dac63004w_update_t *updates, uint8_t count);
+/**
+ * @brief Select whether a channel's data writes wait for LDAC
+ *
+ * dac_init() enables LDAC sync on every channel. Streaming a single channel
+ * is cheaper with sync off, since each data frame then updates the output
+ * on its own.
+ */
+dac63004w_status_t dac_set_channel_sync(dac63004w_context_t *ctx, uint8_t channel, bool ldac_sync);
+/**
+ * @brief Program the function generator of one channel
+ *
+ * Stops the channel's generator first; start it with dac_funcgen_start().
+ */
+dac63004w_status_t dac_funcgen_configure(dac63004w_context_t *ctx, uint8_t channel, const dac63004w_funcgen_config_t *config);
+
+/**
+ * @brief Start the function generator on every channel in the mask
+ *
+ * Channels started together share one COMMON-DAC-TRIG frame, so their
+ * phase selections are relative to the same instant. Once running, the
+ * waveform needs no SPI traffic and the MCU may stay in LPM3.
+ *
+ * @param channel_mask Bit n selects channel n
+ */
+dac63004w_status_t dac_funcgen_start(dac63004w_context_t *ctx, uint8_t channel_mask);
+
+/**
+ * @brief Stop the function generator on every channel in the mask
+ *
+ * Restores LDAC sync with no slew on each channel, so the configuration is
+ * gone; call dac_funcgen_configure() again before restarting.
+ */
+dac63004w_status_t dac_funcgen_stop(dac63004w_context_t *ctx, uint8_t channel_mask);
+
+/**
+ * @brief Waveform period in microseconds for a configuration
+ *
+ * @return Period, or 0 if the configuration cannot generate a waveform
+ */
+uint32_t dac_funcgen_period_us(const dac63004w_funcgen_config_t *config);
+
+/**
+ * @brief Stage a register value without sending it
+ *
+ * Nothing is sent if the value matches what the device already holds.
+ */
+dac63004w_status_t dac_shadow_stage(dac63004w_context_t *ctx, uint8_t reg, uint16_t value);
+
+/**
+ * @brief Send every staged register in address order
+ */
+dac63004w_status_t dac_shadow_flush(dac63004w_context_t *ctx);
+
+/**
+ * @brief Forget the cached value of a register so the next write is sent
+ *
+ * Use when something other than the driver changed the register, e.g. raw
+ * frames from the playback engine.
+ *
+ * @param reg Register address, or DAC_REG_COUNT to forget all of them
+ */
+void dac_shadow_invalidate(dac63004w_context_t *ctx, uint8_t reg);
+
+/**
+ * @brief Switch a channel to current output with the given range
+ *
+ * Powers the channel's VOUT stage down to Hi-Z and its IOUT stage up, and
+ * precomputes the µA-to-code scale for the range.
+ */
+dac63004w_status_t dac_configure_current_mode(dac63004w_context_t *ctx, uint8_t channel, dac63004w_iout_range_t range);
+
+/**
+ * @brief Source or sink a current in microamps
+ *
+ * The channel must be in current mode. The current must lie within the
+ * configured range; bipolar ranges use offset binary (code 0 is the
+ * negative end, 0xFF the positive end).
+ */
+dac63004w_status_t dac_write_current(dac63004w_context_t *ctx, uint8_t channel, int16_t microamps);
+
+/**
+ * @brief Read a register back over SDO
+ *
+ * Sends the read command, then a NOP frame that clocks the data out.
+ * Blocks until both frames are done.
+ */
+dac63004w_status_t dac_read_register(dac63004w_context_t *ctx, uint8_t reg, uint16_t *value);
+
+/**
+ * @brief Enable or disable read-back verification of register writes
+ *
+ * When enabled, every register write that reaches the bus is read back
+ * and a mismatch returns DAC_ERROR_VERIFY. This makes each write blocking.
+ */
+dac63004w_status_t dac_set_write_verify(dac63004w_context_t *ctx, bool enable);
+
+/**
+ * @brief Read GENERAL-STATUS in one transaction and check it
+ *
+ * @param status Raw register value (can be NULL)
+ * @return DAC_ERROR_CRC if either NVM CRC flag is set, DAC_ERROR_COMM if
+ *         SDO reads as all zeros or all ones
+ */
+dac63004w_status_t dac_check_status(dac63004w_context_t *ctx, uint16_t *status);
+
+/**
+ * @brief Compare every cached configuration register against the device
+ *
+ * Reads are pipelined, so N registers cost N + 1 frames.
+ *
+ * @param mismatches Number of registers that differ (can be NULL)
+ * @return DAC_ERROR_VERIFY if any register differs
+ */
+dac63004w_status_t dac_verify_config(dac63004w_context_t *ctx, uint8_t *mismatches);
+
 dac63004w_status_t dac_configure_voltage_mode(dac63004w_context_t *ctx, uint16_t gain, uint8_t channel);
 dac63004w_status_t dac_set_mode(dac63004w_context_t *ctx, dac63004w_mode_t mode);
-dac63004w_status_t dac_trigger_ldac(void);
-dac63004w_status_t dac_reset(void);
+
+/**
+ * @brief Latch every channel's DATA register into its output
+ */
+dac63004w_status_t dac_trigger_ldac(dac63004w_context_t *ctx);
+
+/**
+ * @brief Send a software reset and forget the cached registers
+ *
+ * Returns once the frame is queued; the device needs 1 ms before it takes
+ * new frames (see dac_init()).
+ */
+dac63004w_status_t dac_reset(dac63004w_context_t *ctx);
+
+/**
+ * @brief Trigger LDAC on several DACs with one frame
+ *
+ * Stage data on each device first (dac_shadow_stage() + dac_shadow_flush()
+ * on channels with LDAC sync enabled), then call this so every output
+ * updates on the same CS edge.
+ *
+ * @param group CS group built with msp_spi_group_init() from the DACs' devices
+ * @return dac63004w_status_t Status code
+ */
+dac63004w_status_t dac_broadcast_ldac(const spi_device_t *group);
 
 #endif /* DAC63004W_H */
@@ -0,0 +1,124 @@
+/**
+ * @file dac63004w_dds.h
+ * @brief Direct digital synthesis of sine tones and sweeps on a DAC63004W
+ *
+ * A 32-bit phase accumulator advances by a tuning word on every Timer3_A
+ * CCR0 tick. Its top bits pick a quadrant and an entry of a quarter-wave
+ * sine table that the compiler builds into FRAM; the next 16 bits
+ * interpolate linearly between neighbouring entries on MPY32. The sample
+ * is scaled to a 12-bit code and shifted out as one data frame, with the
+ * channel streaming (no LDAC sync) as during playback.
+ *
+ * Frequencies are given in millihertz and only change the tuning word, so
+ * any frequency below half the sample rate is reached without rebuilding
+ * the table. A sweep changes the tuning word linearly on every tick.
+ */
+#ifndef DAC63004W_DDS_H
+#define DAC63004W_DDS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "hardware/dac63004w.h"
+
+/**
+ * @brief Quarter-wave table entries, as a power of two
+ */
+#define DAC_DDS_TABLE_BITS 8
+
+/**
+ * @brief Largest sine table value (the peak, at a quarter period)
+ */
+#define DAC_DDS_PEAK 32767
+
+/**
+ * @brief CPU cycles the ISR spends on synthesis besides sending the frame:
+ *        accumulator and sweep update, table lookup and two multiplies
+ *
+ * A conservative bound counted from CPUX instruction timings at -Os: about
+ * 60 for the accumulator and sweep step, 50 for the two guarded MPY32
+ * multiplies, 90 for the 32-bit shifts that locate the table entry (libgcc
+ * helpers shifting a bit per loop) and 30 for the call and frame encoding;
+ * rounded up. spi_bench measures the real figure as dds_isr_cycles minus
+ * playback_isr_cycles; define this from it to run closer to the limit.
+ */
+#ifndef DAC_DDS_SYNTH_CYCLES
+#define DAC_DDS_SYNTH_CYCLES 320
+#endif
+
+/**
+ * @brief DDS output settings
+ *
+ * The sample period must cover the frame cost reported by
+ * dac_playback_frame_cycles() plus DAC_DDS_SYNTH_CYCLES, or the ISR would
+ * take the whole CPU; dac_dds_start() refuses a shorter one.
+ */
+typedef struct {
+    uint32_t sample_rate_hz;    // Output updates per second
+    uint32_t start_mhz;         // Frequency at start (millihertz)
+    uint32_t stop_mhz;          // Sweep end; ignored without a sweep
+    uint32_t sweep_ms;          // Sweep duration, 0 for a fixed tone
+    bool sweep_repeat;          // Restart the sweep instead of holding stop_mhz
+    uint16_t amplitude;         // Peak deviation from offset, in codes
+    uint16_t offset;            // Code at zero phase
+} dac_dds_config_t;
+
+/**
+ * @brief Tuning word for a frequency at a timer period
+ *
+ * @param freq_mhz Frequency in millihertz
+ * @param period_cycles SMCLK cycles per sample
+ * @return uint32_t Phase increment per sample, rounded to nearest
+ */
+uint32_t dac_dds_tuning_word(uint32_t freq_mhz, uint32_t period_cycles);
+
+/**
+ * @brief Code for a phase: offset + amplitude * sin(phase)
+ *
+ * This is what the ISR computes on every tick.
+ *
+ * @param phase Phase, a full turn is 2^32
+ * @param amplitude Peak deviation in codes
+ * @param offset Code at zero phase
+ */
+uint16_t dac_dds_sample(uint32_t phase, uint16_t amplitude, uint16_t offset);
+
+/**
+ * @brief Start generating on a channel
+ *
+ * Stops any previous DDS output, turns off LDAC sync on the channel and
+ * starts Timer3_A in up mode from SMCLK. The first sample is the offset.
+ * A tick that finds the bus busy with a queued frame or a blocking
+ * transfer drops its sample; drops are counted.
+ *
+ * @return dac63004w_status_t DAC_ERROR_PARAM if the sample rate does not
+ *         fit the timer or leaves the ISR too few cycles, a frequency is at
+ *         or above half the sample rate, or offset +/- amplitude leaves the
+ *         12-bit range
+ */
+dac63004w_status_t dac_dds_start(dac63004w_context_t *ctx, uint8_t channel, const dac_dds_config_t *config);
+
+/**
+ * @brief Stop generating and restore LDAC sync on the channel
+ *
+ * The output keeps the last code written.
+ */
+dac63004w_status_t dac_dds_stop(dac63004w_context_t *ctx);
+
+/**
+ * @brief Check whether the DDS is running
+ */
+bool dac_dds_active(void);
+
+/**
+ * @brief Number of samples dropped because the SPI bus was busy
+ */
+uint16_t dac_dds_dropped(void);
+
+/**
+ * @brief Frequency being generated, in millihertz; follows a sweep
+ *
+ * 0 before the first dac_dds_start().
+ */
+uint32_t dac_dds_frequency_mhz(void);
+
+#endif /* DAC63004W_DDS_H */
@@ -0,0 +1,136 @@
+/**
+ * @file dac63004w_playback.h
+ * @brief Timer-paced waveform playback from FRAM tables to a DAC63004W channel
+ *
+ * Samples are stored as pre-encoded 3-byte SPI frames, so the Timer1_A CCR0
+ * ISR does nothing but shift bytes out. The channel is switched to streaming
+ * (no LDAC sync) while playing, so each frame updates the output on the
+ * rising CS edge.
+ */
+#ifndef DAC63004W_PLAYBACK_H
+#define DAC63004W_PLAYBACK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "hardware/dac63004w.h"
+#include "msp_spi.h"
+
+/**
+ * @brief Bytes per DAC data frame
+ */
+#define DAC_FRAME_SIZE 3
+
+/**
+ * @brief CPU cycles spent in the playback ISR besides shifting bits:
+ *        interrupt entry/exit, register saves, CS toggles, polling and
+ *        table bookkeeping
+ *
+ * A conservative bound counted from CPUX instruction timings: 11 for entry
+ * and RETI, about 20 for saving and restoring the scratch registers, about
+ * 120 for the call into msp_spi_write_polled_to(), its checks, the CS
+ * edges, the TXBUF loop and the table step, and up to 24 more at divider 1,
+ * where loading TXBUF is slower than the bit clock. The host simulator only
+ * charges register accesses and sees 23, so it can check that the ISR stays
+ * under this figure but cannot produce it. To use a measured one, run
+ * spi_bench on the target and define this as playback_isr_cycles minus the
+ * 24 x 8 bit clocks of its divider 8 bus.
+ */
+#ifndef DAC_PLAYBACK_ISR_OVERHEAD_CYCLES
+#define DAC_PLAYBACK_ISR_OVERHEAD_CYCLES 192
+#endif
+
+/**
+ * @brief Interrupt latency variation: the longest MSP430X instruction that
+ *        may be executing when CCR0 fires
+ */
+#define DAC_PLAYBACK_IRQ_JITTER_CYCLES 6
+
+/**
+ * @brief Granularity of one TXIFG/UCBUSY polling loop iteration
+ */
+#define DAC_PLAYBACK_POLL_CYCLES 5
+
+/**
+ * @brief One pre-encoded DAC data frame
+ */
+typedef struct {
+    uint8_t bytes[DAC_FRAME_SIZE];
+} dac_frame_t;
+
+/**
+ * @brief Encode a data frame at compile time, e.g. for a const FRAM table
+ *
+ * @code
+ * static const dac_frame_t ramp[] = { DAC_FRAME(0, 0), DAC_FRAME(0, 0x800) };
+ * @endcode
+ */
+#define DAC_FRAME(channel, code)                                              \
+    {{ (uint8_t)((DAC_REG_X_DATA + (channel)) & 0x7F),                        \
+       (uint8_t)((DAC_DATA_12BIT(code) >> 8) & 0xFF),                         \
+       (uint8_t)(DAC_DATA_12BIT(code) & 0xFF) }}
+
+/**
+ * @brief Playback timing limits for a given SPI configuration
+ */
+typedef struct {
+    uint16_t frame_cycles;      // SMCLK cycles per sample spent in the ISR
+    uint32_t max_rate_hz;       // Highest sample rate the ISR can sustain
+    uint16_t jitter_cycles;     // Worst-case CS edge jitter (SMCLK cycles)
+} dac_playback_timing_t;
+
+/**
+ * @brief Encode 12-bit codes into data frames for one channel
+ *
+ * The destination may be a persistent FRAM buffer; program FRAM write
+ * protection is lifted for the duration of the copy.
+ */
+dac63004w_status_t dac_playback_encode(dac_frame_t *frames, const uint16_t *codes, uint16_t count, uint8_t channel);
+
+/**
+ * @brief Start clocking frames out at a fixed sample rate
+ *
+ * Drains the SPI queue, turns off LDAC sync on the channel and starts
+ * Timer1_A in up mode from SMCLK. Queued SPI traffic submitted while playing
+ * causes dropped samples, which are counted.
+ *
+ * @param ctx DAC context
+ * @param channel Channel the frames were encoded for
+ * @param frames Pre-encoded frames, typically a const FRAM table
+ * @param count Number of frames
+ * @param sample_rate_hz Sample rate, at most the rate reported by
+ *        dac_playback_timing(); DAC_ERROR_PARAM above it
+ * @param loop Restart from the first frame after the last one
+ */
+dac63004w_status_t dac_playback_start(dac63004w_context_t *ctx, uint8_t channel, const dac_frame_t *frames, uint16_t count, uint32_t sample_rate_hz, bool loop);
+
+/**
+ * @brief Stop playback and restore LDAC sync on the channel
+ */
+dac63004w_status_t dac_playback_stop(dac63004w_context_t *ctx);
+
+/**
+ * @brief Check whether playback is running
+ */
+bool dac_playback_active(void);
+
+/**
+ * @brief Number of samples dropped because the SPI bus was busy
+ */
+uint16_t dac_playback_dropped(void);
+
+/**
+ * @brief Report the sustainable sample rate and edge jitter
+ *
+ * @param config SPI configuration the bus was initialised with
+ * @param timing Filled with the limits for that configuration
+ */
+void dac_playback_timing(const spi_config_t *config, dac_playback_timing_t *timing);
+
+/**
+ * @brief SMCLK cycles one sample takes in the ISR on a bus device
+ *
+ * @param device Device handle, NULL for the msp_spi_init() device
+ */
+uint16_t dac_playback_frame_cycles(const spi_device_t *device);
+
+#endif /* DAC63004W_PLAYBACK_H */
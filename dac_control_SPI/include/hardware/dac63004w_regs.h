@@ -14,6 +14,7 @@
 #define DAC_REG_COMMON_CONFIG   0x1F    // Common configuration register
 #define DAC_REG_COMMON_TRIGGER  0x20    // Common trigger register
 #define DAC_REG_COMMON_DAC_TRIG 0x21    // Common DAC trig register
+#define DAC_REG_GENERAL_STATUS  0x22    // General status register
 #define DAC_REG_DEVICE_MODE     0x25    // Device mode configuration
 #define DAC_REG_INTERFACE       0x26    // Interface configuration
 
@@ -31,6 +32,12 @@
 #define DAC_VOUT_GAIN_3X_INT_REFERENCE        (4 << 10)
 #define DAC_VOUT_GAIN_4X_INT_REFERENCE        (5 << 10)
 
+/**
+ * @brief DAC-X-MARGIN-HIGH/LOW registers (function generator limits)
+ */
+#define DAC_REG_DAC0_MARGIN_HIGH    0x01
+#define DAC_REG_DAC0_MARGIN_LOW     0x02
+
 /**
  * @brief DAC-X-FUNC-CONFIG registers
  */
@@ -53,6 +60,22 @@
 #define DAC_PHASE_SEL_240                   (2 << 11)  // 240° Phase
 #define DAC_PHASE_SEL_90                    (3 << 11)  // 90° Phase
 
+#define DAC_FUNC_CONFIG_SYNC_LDAC           (1 << 14)  // Output updates on LDAC
+#define DAC_FUNC_CONFIG_SHAPE_MASK          (7 << 8)
+#define DAC_FUNC_CONFIG_PHASE_MASK          (3 << 11)
+#define DAC_FUNC_CONFIG_LOG_SLEW            (1 << 7)   // Logarithmic slew
+#define DAC_FUNC_CONFIG_SLEW_MASK           0x000F
+
+#define DAC_CODE_STEP_1_LSB                 (0 << 4)   // Code step per slew
+#define DAC_CODE_STEP_2_LSB                 (1 << 4)
+#define DAC_CODE_STEP_3_LSB                 (2 << 4)
+#define DAC_CODE_STEP_4_LSB                 (3 << 4)
+#define DAC_CODE_STEP_6_LSB                 (4 << 4)
+#define DAC_CODE_STEP_8_LSB                 (5 << 4)
+#define DAC_CODE_STEP_16_LSB                (6 << 4)
+#define DAC_CODE_STEP_32_LSB                (7 << 4)
+#define DAC_CODE_STEP_MASK                  (7 << 4)
+
 /**
  * @brief Common Config register bits
  */
@@ -61,16 +84,51 @@
 #define DAC_VOUT_PDN_NORMAL    0x00        // Normal operation
 #define DAC_VOUT_PDN_HIZ       0x03        // Hi-Z to AGND
 
+// Per-channel power-down fields: channel 0 in bits 11:9 down to channel 3
+// in bits 2:0, each a 2-bit VOUT-PDN field above a 1-bit IOUT-PDN bit
+#define DAC_VOUT_PDN_SHIFT(ch) (10 - 3 * (ch))
+#define DAC_VOUT_PDN(ch, val)  ((uint16_t)(val) << DAC_VOUT_PDN_SHIFT(ch))
+#define DAC_IOUT_PDN(ch)       (1 << (9 - 3 * (ch)))
+
+/**
+ * @brief DAC-X-IOUT-MISC-CONFIG register bits
+ */
+#define DAC_IOUT_RANGE_SHIFT   9
+#define DAC_IOUT_RANGE_MASK    (0xF << DAC_IOUT_RANGE_SHIFT)
+
 /**
  * @brief Common Trigger register bits
  */
 #define DAC_RESET_TRIGGER           (0xA << 8)// Reset trigger value
 #define DAC_LDAC_TRIGGER            (1 << 7)  // LDAC trigger bit
 #define DAC_CLR_TRIGGER             (1 << 6)  // Clear trigger bit
-#define DAC_START_FUNC_0            (1 << 0)  // Start function for channel 0
-#define DAC_START_FUNC_1            (1 << 4)  // Start function for channel 1
-#define DAC_START_FUNC_2            (1 << 8)  // Start function for channel 2
-#define DAC_START_FUNC_3            (1 << 12) // Start function for channel 3
+
+/**
+ * @brief Common DAC Trig register bits (channel 0 in the top nibble)
+ */
+#define DAC_START_FUNC_0            (1 << 12) // Start function for channel 0
+#define DAC_START_FUNC_1            (1 << 8)  // Start function for channel 1
+#define DAC_START_FUNC_2            (1 << 4)  // Start function for channel 2
+#define DAC_START_FUNC_3            (1 << 0)  // Start function for channel 3
+#define DAC_START_FUNC(ch)          (1 << (12 - (ch) * 4))
+
+/**
+ * @brief General status register bits
+ */
+#define DAC_STATUS_NVM_CRC_FAIL_INT   (1 << 15) // Factory NVM CRC failed
+#define DAC_STATUS_NVM_CRC_FAIL_USER  (1 << 14) // User NVM CRC failed
+#define DAC_STATUS_DEVICE_ID_MASK     (0x3F << 2)
+
+/**
+ * @brief Interface config bits
+ */
+#define DAC_INTERFACE_SDO_EN   (1 << 0)    // Drive SDO for register reads
+
+/**
+ * @brief SPI frame bits
+ */
+#define DAC_SPI_READ           0x80        // R/W bit in the address byte
+#define DAC_REG_NOP            0x00        // No-operation register
 
 /**
  * @brief Device mode config bits
@@ -83,6 +141,7 @@
  */
 #define DAC_DATA_12BIT(val)    ((val & 0xFFF) << 4)  // 12-bit data left aligned
 #define DAC_DATA_MIDSCALE      0x8000               // Mid-scale value
+#define DAC_DATA_8BIT(val)     ((val & 0xFF) << 8)  // 8-bit IOUT data left aligned
 
 /**
  * @brief Slew rate definitions for wave generation
@@ -1,6 +1,23 @@
 #ifndef MSP_CLOCK_H
 #define MSP_CLOCK_H
 
+/**
+ * @brief MCLK = SMCLK frequency set up by init_clock()
+ *
+ * One of 1, 2, 4, 8 or 16 MHz, chosen at build time (make MCLK_HZ=...).
+ * The FLL multiplies the 32768Hz REFO, so the real clock is the nearest
+ * multiple of 32768Hz below this value.
+ */
+#ifndef MSP_MCLK_HZ
+#define MSP_MCLK_HZ 4000000UL
+#endif
+
+/**
+ * @brief Clock frequencies set up by init_clock()
+ */
+#define MSP_SMCLK_HZ MSP_MCLK_HZ
+#define MSP_ACLK_HZ 32768UL
+
 void init_clock(void);
 
 
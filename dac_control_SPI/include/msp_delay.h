@@ -2,6 +2,28 @@
 #define MSP_DELAY_H
 
 #include <stdint.h>
+
+/**
+ * @brief Sleep for at least the given number of milliseconds
+ *
+ * Timer2_A counts ACLK and the CPU waits in LPM3, or in LPM0 while queued
+ * SPI transfers or a delay_smclk_acquire() holder still need SMCLK. Other
+ * interrupts are serviced during the delay. Must not be called from an ISR.
+ * @param ms Milliseconds to delay
+ */
 void delay_ms(uint16_t ms);
 
+/**
+ * @brief Keep SMCLK running while delay_ms() sleeps
+ *
+ * For peripherals clocked from SMCLK that run in the background, such as a
+ * timer pacing DAC playback. Calls nest; each needs a matching release.
+ */
+void delay_smclk_acquire(void);
+
+/**
+ * @brief Drop a hold taken with delay_smclk_acquire(). Safe to call from ISRs.
+ */
+void delay_smclk_release(void);
+
 #endif
@@ -1,12 +1,31 @@
 /**
  * @file msp_spi.h
  * @brief MSP430 SPI interface implementation
+ *
+ * The bus runs on eUSCI_A0, eUSCI_A1 or eUSCI_B0, chosen at build time
+ * (msp_spi_eusci.h); the API is the same for all three.
  */
 #ifndef MSP_SPI_H
 #define MSP_SPI_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
+/**
+ * @brief Number of transactions the asynchronous queue can hold
+ */
+#ifndef SPI_QUEUE_DEPTH
+#define SPI_QUEUE_DEPTH 8
+#endif
+
+/**
+ * @brief Frames up to this many bytes are copied into the queue on submit,
+ *        so the caller's transmit buffer may live on the stack
+ */
+#ifndef SPI_QUEUE_FRAME_SIZE
+#define SPI_QUEUE_FRAME_SIZE 4
+#endif
+
 /**
  * @brief SPI operation status codes
  */
@@ -14,9 +33,18 @@ typedef enum {
     SPI_SUCCESS = 0,
     SPI_ERROR_INIT = -1,
     SPI_ERROR_TRANSFER = -2,
-    SPI_ERROR_PARAM = -3
+    SPI_ERROR_PARAM = -3,
+    SPI_ERROR_BUSY = -4
 } spi_status_t;
 
+/**
+ * @brief Completion callback for asynchronous transfers
+ *
+ * Runs in interrupt context once CS has been released for the transaction.
+ * It may submit further transactions but must not block.
+ */
+typedef void (*spi_callback_t)(spi_status_t status, void *arg);
+
 /**
  * @brief SPI pin configuration structure
  */
@@ -40,6 +68,21 @@ typedef struct {
     uint8_t bit_order;      // Bit order (MSB or LSB first)
 } spi_config_t;
 
+/**
+ * @brief A peripheral on the shared SPI bus
+ *
+ * Filled in by msp_spi_device_init() or msp_spi_group_init(); treat the
+ * fields as private. The bus is reconfigured only when the next transaction
+ * targets a device whose mode or divider differs from the current one.
+ * A NULL device handle means the device set up by msp_spi_init().
+ */
+typedef struct {
+    volatile uint8_t *cs_out; // PxOUT register of the CS pin(s)
+    uint8_t cs_mask;          // CS pin mask; several bits for a CS group
+    uint16_t ctlw0;           // UCxCTLW0 for this device's mode/bit order
+    uint16_t brw;             // UCxBRW clock divider
+} spi_device_t;
+
 /**
  * @brief Initialize SPI hardware
  * 
@@ -49,6 +92,34 @@ typedef struct {
  */
 spi_status_t msp_spi_init(const spi_pin_config_t *pins, const spi_config_t *config);
 
+/**
+ * @brief Set up an additional device on the bus initialised by msp_spi_init()
+ *
+ * Configures the CS pin as an output, driven high.
+ *
+ * @param device Device handle to fill in
+ * @param cs_port CS port (1-3)
+ * @param cs_pin CS pin (0-7)
+ * @param config Mode, divider and bit order used for this device
+ * @return spi_status_t Status code
+ */
+spi_status_t msp_spi_device_init(spi_device_t *device, uint8_t cs_port, uint8_t cs_pin, const spi_config_t *config);
+
+/**
+ * @brief Combine devices into a CS group that is selected as one device
+ *
+ * A frame sent to the group asserts every member's CS at once, so all of
+ * them latch the same data. Members must share a CS port, mode and divider.
+ * Group frames are for writes only: members that drive SDO push-pull will
+ * contend on MISO while selected together.
+ *
+ * @param group Device handle to fill in
+ * @param devices Member devices
+ * @param count Number of members
+ * @return spi_status_t SPI_ERROR_PARAM if the members are incompatible
+ */
+spi_status_t msp_spi_group_init(spi_device_t *group, const spi_device_t *const *devices, uint8_t count);
+
 /**
  * @brief Send a single byte over SPI
  * 
@@ -58,7 +129,12 @@ spi_status_t msp_spi_init(const spi_pin_config_t *pins, const spi_config_t *conf
 uint8_t msp_spi_transfer_byte(uint8_t data);
 
 /**
- * @brief Send multiple bytes over SPI with CS control
+ * @brief Send multiple bytes over SPI with CS control, busy-waiting per byte
+ *
+ * Drains the asynchronous queue first so frames are never interleaved, and
+ * holds the bus until CS is released: msp_spi_write_polled() calls from
+ * ISRs meanwhile return SPI_ERROR_BUSY, and frames submitted from ISRs
+ * start once the transfer is done.
  * 
  * @param tx_data Transmit buffer
  * @param rx_data Receive buffer (can be NULL for write-only)
@@ -68,12 +144,84 @@ uint8_t msp_spi_transfer_byte(uint8_t data);
 spi_status_t msp_spi_transfer(const uint8_t *tx_data, uint8_t *rx_data, uint16_t length);
 
 /**
- * @brief Assert (lower) the CS pin
+ * @brief msp_spi_transfer() to a specific device
+ */
+spi_status_t msp_spi_transfer_to(const spi_device_t *device, const uint8_t *tx_data, uint8_t *rx_data, uint16_t length);
+
+/**
+ * @brief Queue a CS-framed transfer to be clocked out by the eUSCI ISR
+ *
+ * Returns immediately. Transmit data no longer than SPI_QUEUE_FRAME_SIZE is
+ * copied into the queue; longer transmit buffers and any receive buffer must
+ * stay valid until the callback runs. Requires GIE to make progress.
+ *
+ * @param tx_data Transmit buffer
+ * @param rx_data Receive buffer (can be NULL for write-only)
+ * @param length Number of bytes to transfer
+ * @param callback Completion callback (can be NULL)
+ * @param arg Argument passed to the callback
+ * @return spi_status_t SPI_ERROR_BUSY if the queue is full
+ */
+spi_status_t msp_spi_submit(const uint8_t *tx_data, uint8_t *rx_data,
+                            uint16_t length, spi_callback_t callback,
+                            void *arg);
+
+/**
+ * @brief msp_spi_submit() to a specific device
+ */
+spi_status_t msp_spi_submit_to(const spi_device_t *device,
+                               const uint8_t *tx_data, uint8_t *rx_data,
+                               uint16_t length, spi_callback_t callback,
+                               void *arg);
+
+/**
+ * @brief Check whether queued transfers are still in progress
+ *
+ * @return true while the queue is not empty
+ */
+bool msp_spi_busy(void);
+
+/**
+ * @brief Sleep in LPM0 until every queued transfer has completed
+ *
+ * Must not be called from interrupt context.
+ */
+void msp_spi_flush(void);
+
+/**
+ * @brief Shift a write-only frame out immediately by polling
+ *
+ * Intended for timer ISRs that need the frame edges at a fixed offset from
+ * the interrupt. Does not touch the queue; returns SPI_ERROR_BUSY instead of
+ * interleaving with a queued transfer or with a blocking msp_spi_transfer()
+ * the interrupt arrived in.
+ *
+ * @param tx_data Transmit buffer
+ * @param length Number of bytes to transfer
+ * @return spi_status_t Status code
+ */
+spi_status_t msp_spi_write_polled(const uint8_t *tx_data, uint16_t length);
+
+/**
+ * @brief msp_spi_write_polled() to a specific device
+ */
+spi_status_t msp_spi_write_polled_to(const spi_device_t *device, const uint8_t *tx_data, uint16_t length);
+
+/**
+ * @brief SMCLK divider a device's bit clock runs at
+ *
+ * @param device Device handle, NULL for the msp_spi_init() device
+ * @return uint16_t Divider, 1 for a clock_divider of 0
+ */
+uint16_t msp_spi_clock_divider(const spi_device_t *device);
+
+/**
+ * @brief Assert (lower) the CS pin of the msp_spi_init() device
  */
 void msp_spi_cs_assert(void);
 
 /**
- * @brief Deassert (raise) the CS pin
+ * @brief Deassert (raise) the CS pin of the msp_spi_init() device
  */
 void msp_spi_cs_deassert(void);
 
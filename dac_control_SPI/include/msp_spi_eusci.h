@@ -0,0 +1,93 @@
+/**
+ * @file msp_spi_eusci.h
+ * @brief Build-time choice of the eUSCI module that runs the SPI bus
+ *
+ * Define one of SPI_EUSCI_A0 (default), SPI_EUSCI_A1 or SPI_EUSCI_B0 (see
+ * the Makefile's SPI_EUSCI). The data pins are fixed by the module:
+ *
+ * | Module | SIMO | SOMI | CLK  | Notes                                  |
+ * |--------|------|------|------|----------------------------------------|
+ * | UCA0   | P1.4 | P1.5 | P1.6 | Shares pins with the backchannel UART  |
+ * | UCA1   | P2.6 | P2.5 | P2.4 |                                        |
+ * | UCB0   | P1.2 | P1.3 | P1.1 | CLK shares P1.1 with LaunchPad LED2    |
+ *
+ * With UCA1 or UCB0 selected, UCA0 stays free for the UART. All three
+ * modules have the same SPI-mode register layout and bit positions, apart
+ * from the modulation register eUSCI_B lacks.
+ */
+#ifndef MSP_SPI_EUSCI_H
+#define MSP_SPI_EUSCI_H
+
+#if (defined(SPI_EUSCI_A0) + defined(SPI_EUSCI_A1) + defined(SPI_EUSCI_B0)) > 1
+#error Define only one of SPI_EUSCI_A0, SPI_EUSCI_A1 and SPI_EUSCI_B0
+#endif
+
+#if defined(SPI_EUSCI_B0)
+
+#define SPI_CTLW0 UCB0CTLW0
+#define SPI_BRW UCB0BRW
+#define SPI_STATW UCB0STATW
+#define SPI_RXBUF UCB0RXBUF
+#define SPI_TXBUF UCB0TXBUF
+#define SPI_IE UCB0IE
+#define SPI_IFG UCB0IFG
+#define SPI_IV UCB0IV
+#define SPI_VECTOR USCI_B0_VECTOR
+#define SPI_ISR USCI_B0_ISR
+
+#define SPI_DATA_PORT 1
+#define SPI_SIMO_PIN 2
+#define SPI_SOMI_PIN 3
+#define SPI_CLK_PIN 1
+#define SPI_DATA_SEL0 P1SEL0
+#define SPI_DATA_SEL1 P1SEL1
+
+#elif defined(SPI_EUSCI_A1)
+
+#define SPI_CTLW0 UCA1CTLW0
+#define SPI_BRW UCA1BRW
+#define SPI_MCTLW UCA1MCTLW
+#define SPI_STATW UCA1STATW
+#define SPI_RXBUF UCA1RXBUF
+#define SPI_TXBUF UCA1TXBUF
+#define SPI_IE UCA1IE
+#define SPI_IFG UCA1IFG
+#define SPI_IV UCA1IV
+#define SPI_VECTOR USCI_A1_VECTOR
+#define SPI_ISR USCI_A1_ISR
+
+#define SPI_DATA_PORT 2
+#define SPI_SIMO_PIN 6
+#define SPI_SOMI_PIN 5
+#define SPI_CLK_PIN 4
+#define SPI_DATA_SEL0 P2SEL0
+#define SPI_DATA_SEL1 P2SEL1
+
+#else
+
+#define SPI_CTLW0 UCA0CTLW0
+#define SPI_BRW UCA0BRW
+#define SPI_MCTLW UCA0MCTLW
+#define SPI_STATW UCA0STATW
+#define SPI_RXBUF UCA0RXBUF
+#define SPI_TXBUF UCA0TXBUF
+#define SPI_IE UCA0IE
+#define SPI_IFG UCA0IFG
+#define SPI_IV UCA0IV
+#define SPI_VECTOR USCI_A0_VECTOR
+#define SPI_ISR USCI_A0_ISR
+
+#define SPI_DATA_PORT 1
+#define SPI_SIMO_PIN 4
+#define SPI_SOMI_PIN 5
+#define SPI_CLK_PIN 6
+#define SPI_DATA_SEL0 P1SEL0
+#define SPI_DATA_SEL1 P1SEL1
+
+#endif
+
+// Data pins, all on the primary module function (SEL1 = 0, SEL0 = 1)
+#define SPI_DATA_MASK                                                          \
+  ((1 << SPI_SIMO_PIN) | (1 << SPI_SOMI_PIN) | (1 << SPI_CLK_PIN))
+
+#endif
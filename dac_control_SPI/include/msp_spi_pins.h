@@ -0,0 +1,60 @@
+/**
+ * @file msp_spi_pins.h
+ * @brief Build-time SPI pin assignment for SPI_STATIC_PINS builds
+ *
+ * With SPI_STATIC_PINS defined, the CS pin is a compile-time constant and
+ * each CS edge of a blocking or polled frame to the msp_spi_init() device
+ * compiles to one BIC.B/BIS.B #mask,&PxOUT instead of going through the
+ * port pointer and mask held in its spi_device_t. The path is picked once
+ * per frame, never per edge. Queued frames and devices added with
+ * msp_spi_device_init() always use the handle. Override
+ * SPI_CS_PORT/SPI_CS_PIN from the command line (see the Makefile).
+ *
+ * The data pins are fixed by the eUSCI module, see msp_spi_eusci.h.
+ */
+#ifndef MSP_SPI_PINS_H
+#define MSP_SPI_PINS_H
+
+#include "msp_spi_eusci.h"
+
+#ifndef SPI_CS_PORT
+#define SPI_CS_PORT 1
+#endif
+
+#ifndef SPI_CS_PIN
+#define SPI_CS_PIN 7
+#endif
+
+#if SPI_CS_PIN > 7
+#error SPI_CS_PIN must be 0..7
+#endif
+
+// PxREG from a port number macro. Two levels so the port number expands
+// first; the suffix is pasted directly because OUT, DIR and friends are
+// themselves macros in the device header.
+#define SPI_PX_OUT_(port) P##port##OUT
+#define SPI_PX_DIR_(port) P##port##DIR
+#define SPI_PX_SEL0_(port) P##port##SEL0
+#define SPI_PX_SEL1_(port) P##port##SEL1
+#define SPI_PX_OUT(port) SPI_PX_OUT_(port)
+#define SPI_PX_DIR(port) SPI_PX_DIR_(port)
+#define SPI_PX_SEL0(port) SPI_PX_SEL0_(port)
+#define SPI_PX_SEL1(port) SPI_PX_SEL1_(port)
+
+#define SPI_CS_MASK (1 << SPI_CS_PIN)
+#define SPI_CS_OUT SPI_PX_OUT(SPI_CS_PORT)
+#define SPI_CS_DIR SPI_PX_DIR(SPI_CS_PORT)
+#define SPI_CS_SEL0 SPI_PX_SEL0(SPI_CS_PORT)
+#define SPI_CS_SEL1 SPI_PX_SEL1(SPI_CS_PORT)
+
+/**
+ * @brief Drive CS low: a single BIC.B on a constant port address
+ */
+#define SPI_CS_LOW() (SPI_CS_OUT &= ~SPI_CS_MASK)
+
+/**
+ * @brief Drive CS high: a single BIS.B on a constant port address
+ */
+#define SPI_CS_HIGH() (SPI_CS_OUT |= SPI_CS_MASK)
+
+#endif
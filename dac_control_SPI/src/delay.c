@@ -1,14 +1,94 @@
+#include "msp_clock.h"
 #include "msp_delay.h"
+#include "msp_spi.h"
 #include <msp430.h>
+#include <stdbool.h>
+
+#if MSP_ACLK_HZ < 1000
+#error ACLK must be at least 1 kHz for millisecond delays
+#endif
+
+// Longest stretch one CCR0 period can cover
+#define DELAY_MAX_TICKS 0xFFFFU
+
+static volatile bool g_expired;
+static volatile uint8_t g_smclk_holds;
+
 /**
- * @brief Delay function (approximate milliseconds)
+ * @brief Sleep until Timer2_A CCR0 fires
  *
- * TODO: Implement delay function using MSP430's Timer0
+ * Interrupts are disabled while choosing the low-power mode so a wake-up
+ * cannot slip in between the check and the sleep; entering LPM sets GIE
+ * again atomically. The caller's interrupt state is restored afterwards.
+ */
+static void delay_sleep(void) {
+  uint16_t state = __get_interrupt_state();
+
+  while (1) {
+    __disable_interrupt();
+    if (g_expired) {
+      break;
+    }
+    if (g_smclk_holds || msp_spi_busy()) {
+      __bis_SR_register(LPM0_bits | GIE); // SMCLK must keep running
+    } else {
+      __bis_SR_register(LPM3_bits | GIE);
+    }
+  }
+  __set_interrupt_state(state);
+}
+
+/**
+ * @brief Delay using Timer2_A from ACLK
  * @param ms Milliseconds to delay
  */
 void delay_ms(uint16_t ms) {
-  // At 4MHz, each cycle is 0.25us, so 4000 cycles = 1ms
-  while (ms--) {
-    __delay_cycles(4000);
+  // Round up so the delay is never shorter than requested
+  uint32_t ticks = ((uint32_t)ms * MSP_ACLK_HZ + 999) / 1000;
+
+  while (ticks) {
+    uint16_t chunk = (ticks > DELAY_MAX_TICKS) ? DELAY_MAX_TICKS : ticks;
+    ticks -= chunk;
+
+    g_expired = false;
+    TA2CCR0 = chunk;
+    TA2CCTL0 = CCIE;
+    TA2CTL = TASSEL__ACLK | MC__UP | TACLR;
+
+    delay_sleep();
   }
+
+  TA2CTL = MC__STOP;
+  TA2CCTL0 = 0;
+}
+
+void delay_smclk_acquire(void) {
+  uint16_t state = __get_interrupt_state();
+  __disable_interrupt();
+  g_smclk_holds++;
+  __set_interrupt_state(state);
+}
+
+void delay_smclk_release(void) {
+  uint16_t state = __get_interrupt_state();
+  __disable_interrupt();
+  if (g_smclk_holds) {
+    g_smclk_holds--;
+  }
+  __set_interrupt_state(state);
+}
+
+// Timer2_A CCR0 interrupt: delay period elapsed
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector = TIMER2_A0_VECTOR
+__interrupt void TIMER2_A0_ISR(void)
+#elif defined(__GNUC__)
+void __attribute__((interrupt(TIMER2_A0_VECTOR))) TIMER2_A0_ISR(void)
+#else
+#error Compiler not supported!
+#endif
+{
+  TA2CTL &= ~MC__UP; // One-shot per chunk
+  g_expired = true;
+  __bic_SR_register_on_exit(LPM3_bits);
 }
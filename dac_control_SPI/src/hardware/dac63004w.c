@@ -5,6 +5,7 @@
 
 static uint8_t dac_get_data_register(uint8_t channel);
 static uint8_t dac_get_vout_config_register(uint8_t channel);
+static uint8_t dac_get_func_config_register(uint8_t channel);
 
 static uint8_t dac_get_data_register(uint8_t channel) {
   uint8_t base = DAC_REG_X_DATA;
@@ -22,7 +23,40 @@ static uint8_t dac_get_vout_config_register(uint8_t channel) {
   return base + (channel * 6);
 }
 
-static dac63004w_status_t dac_write_register(uint8_t reg, uint16_t value) {
+static uint8_t dac_get_iout_config_register(uint8_t channel) {
+  uint8_t base = DAC_REG_X_IOUT_MISC_CONFIG;
+  if (channel > 3) {
+    return 0xFF; // Invalid channel
+  }
+  return base + (channel * 6);
+}
+
+static uint8_t dac_get_func_config_register(uint8_t channel) {
+  uint8_t base = DAC_REG_DAC0_FUNC_CONFIG;
+  if (channel > 3) {
+    return 0xFF; // Invalid channel
+  }
+  return base + (channel * 6);
+}
+
+static uint8_t dac_get_margin_high_register(uint8_t channel) {
+  uint8_t base = DAC_REG_DAC0_MARGIN_HIGH;
+  if (channel > 3) {
+    return 0xFF; // Invalid channel
+  }
+  return base + (channel * 6);
+}
+
+static uint8_t dac_get_margin_low_register(uint8_t channel) {
+  uint8_t base = DAC_REG_DAC0_MARGIN_LOW;
+  if (channel > 3) {
+    return 0xFF; // Invalid channel
+  }
+  return base + (channel * 6);
+}
+
+static dac63004w_status_t dac_write_register(const spi_device_t *device,
+                                             uint8_t reg, uint16_t value) {
   if (reg == 0xFF) {
     return DAC_ERROR_PARAM;
   }
@@ -32,8 +66,15 @@ static dac63004w_status_t dac_write_register(uint8_t reg, uint16_t value) {
   tx_data[1] = (value >> 8) & 0xFF; // Data MSB
   tx_data[2] = value & 0xFF;        // Data LSB
 
-  // Perform SPI transfer
-  int status = msp_spi_transfer(tx_data, NULL, sizeof(tx_data));
+  // Queue the frame; the SPI ISR clocks it out while the CPU carries on.
+  // If the queue is full, sleep until it drains and try once more.
+  int status =
+      msp_spi_submit_to(device, tx_data, NULL, sizeof(tx_data), NULL, NULL);
+  if (status == SPI_ERROR_BUSY) {
+    msp_spi_flush();
+    status =
+        msp_spi_submit_to(device, tx_data, NULL, sizeof(tx_data), NULL, NULL);
+  }
   if (status != SPI_SUCCESS) {
     return DAC_ERROR_COMM;
   }
@@ -41,46 +82,391 @@ static dac63004w_status_t dac_write_register(uint8_t reg, uint16_t value) {
   return DAC_SUCCESS;
 }
 
-dac63004w_status_t dac_reset(void) {
-  return dac_write_register(DAC_REG_COMMON_TRIGGER, 0x0A00); // Power-on reset
+/**
+ * @brief Send one blocking frame and capture the data clocked out during it
+ */
+static dac63004w_status_t dac_transfer_frame(const spi_device_t *device,
+                                             uint8_t addr, uint16_t value,
+                                             uint16_t *rx_value) {
+  uint8_t tx_data[3];
+  uint8_t rx_data[3];
+  tx_data[0] = addr;
+  tx_data[1] = (value >> 8) & 0xFF;
+  tx_data[2] = value & 0xFF;
+
+  if (msp_spi_transfer_to(device, tx_data, rx_data, sizeof(tx_data)) !=
+      SPI_SUCCESS) {
+    return DAC_ERROR_COMM;
+  }
+
+  if (rx_value) {
+    *rx_value = ((uint16_t)rx_data[1] << 8) | rx_data[2];
+  }
+  return DAC_SUCCESS;
+}
+
+/**
+ * @brief Check whether a register reads back what was written to it
+ *
+ * Trigger registers hold action bits that read back as zero, and the
+ * status registers are read-only.
+ */
+static bool dac_reg_verifiable(uint8_t reg) {
+  return reg != DAC_REG_NOP && reg != DAC_REG_COMMON_TRIGGER &&
+         reg != DAC_REG_COMMON_DAC_TRIG && reg != DAC_REG_GENERAL_STATUS &&
+         reg < DAC_REG_COUNT;
 }
 
-dac63004w_status_t dac_trigger_ldac(void) {
-  return dac_write_register(DAC_REG_COMMON_TRIGGER, 0x0080); // DAC_LDAC_TRIGGER
+/**
+ * @brief Read back a register that was just written
+ */
+static dac63004w_status_t dac_verify_write(dac63004w_context_t *ctx,
+                                           uint8_t reg, uint16_t value) {
+  if (!ctx->verify_writes || !dac_reg_verifiable(reg)) {
+    return DAC_SUCCESS;
+  }
+
+  uint16_t readback;
+  dac63004w_status_t status = dac_read_register(ctx, reg, &readback);
+  if (status != DAC_SUCCESS) {
+    return status;
+  }
+  return (readback == value) ? DAC_SUCCESS : DAC_ERROR_VERIFY;
 }
-dac63004w_status_t dac_init(dac63004w_context_t *ctx) {
+
+static inline bool dac_shadow_test(const uint8_t *bits, uint8_t reg) {
+  return bits[reg >> 3] & (1 << (reg & 7));
+}
+
+static inline void dac_shadow_mark(uint8_t *bits, uint8_t reg) {
+  bits[reg >> 3] |= (1 << (reg & 7));
+}
+
+static inline void dac_shadow_unmark(uint8_t *bits, uint8_t reg) {
+  bits[reg >> 3] &= ~(1 << (reg & 7));
+}
+
+/**
+ * @brief Check whether the device already holds a register value
+ */
+static bool dac_shadow_matches(const dac63004w_context_t *ctx, uint8_t reg,
+                               uint16_t value) {
+  return dac_shadow_test(ctx->shadow.valid, reg) &&
+         !dac_shadow_test(ctx->shadow.dirty, reg) &&
+         ctx->shadow.value[reg] == value;
+}
+
+/**
+ * @brief Record that a register reached the device
+ *
+ * A DATA register only drives its output once LDAC latches it.
+ */
+static void dac_shadow_written(dac63004w_context_t *ctx, uint8_t reg) {
+  dac_shadow_mark(ctx->shadow.valid, reg);
+  dac_shadow_unmark(ctx->shadow.dirty, reg);
+  if (reg >= DAC_REG_X_DATA && reg < DAC_REG_X_DATA + DAC_NUM_CHANNELS) {
+    ctx->shadow.unlatched |= 1 << (reg - DAC_REG_X_DATA);
+  }
+}
+
+/**
+ * @brief Check whether a channel's output already shows its cached code
+ */
+static bool dac_output_matches(const dac63004w_context_t *ctx, uint8_t channel,
+                               uint16_t data) {
+  return !(ctx->shadow.unlatched & (1 << channel)) &&
+         dac_shadow_matches(ctx, dac_get_data_register(channel), data);
+}
+
+/**
+ * @brief Write a register through the shadow cache
+ */
+static dac63004w_status_t dac_write_shadowed(dac63004w_context_t *ctx,
+                                             uint8_t reg, uint16_t value) {
+  if (reg >= DAC_REG_COUNT || reg == DAC_REG_COMMON_TRIGGER) {
+    return DAC_ERROR_PARAM;
+  }
+
+  if (dac_shadow_matches(ctx, reg, value)) {
+    ctx->shadow.skipped++;
+    return DAC_SUCCESS;
+  }
+
+  dac63004w_status_t status = dac_write_register(ctx->spi, reg, value);
+  if (status == DAC_SUCCESS) {
+    ctx->shadow.issued++;
+    status = dac_verify_write(ctx, reg, value);
+  }
+  if (status != DAC_SUCCESS) {
+    dac_shadow_unmark(ctx->shadow.valid, reg);
+    return status;
+  }
+
+  ctx->shadow.value[reg] = value;
+  dac_shadow_written(ctx, reg);
+  return DAC_SUCCESS;
+}
+
+/**
+ * @brief Trigger LDAC and count the frame
+ */
+static dac63004w_status_t dac_issue_ldac(dac63004w_context_t *ctx) {
+  dac63004w_status_t status =
+      dac_write_register(ctx->spi, DAC_REG_COMMON_TRIGGER, DAC_LDAC_TRIGGER);
+  if (status == DAC_SUCCESS) {
+    ctx->shadow.issued++;
+    ctx->shadow.unlatched = 0;
+  }
+  return status;
+}
+
+dac63004w_status_t dac_shadow_stage(dac63004w_context_t *ctx, uint8_t reg,
+                                    uint16_t value) {
+  if (!ctx || reg >= DAC_REG_COUNT || reg == DAC_REG_COMMON_TRIGGER) {
+    return DAC_ERROR_PARAM;
+  }
+
+  if (dac_shadow_matches(ctx, reg, value)) {
+    ctx->shadow.skipped++;
+    return DAC_SUCCESS;
+  }
+
+  ctx->shadow.value[reg] = value;
+  dac_shadow_mark(ctx->shadow.dirty, reg);
+  return DAC_SUCCESS;
+}
+
+dac63004w_status_t dac_shadow_flush(dac63004w_context_t *ctx) {
+  if (!ctx) {
+    return DAC_ERROR_PARAM;
+  }
+
+  for (uint8_t reg = 0; reg < DAC_REG_COUNT; reg++) {
+    if (!dac_shadow_test(ctx->shadow.dirty, reg)) {
+      continue;
+    }
+    dac63004w_status_t status =
+        dac_write_register(ctx->spi, reg, ctx->shadow.value[reg]);
+    if (status == DAC_SUCCESS) {
+      ctx->shadow.issued++;
+      status = dac_verify_write(ctx, reg, ctx->shadow.value[reg]);
+    }
+    if (status != DAC_SUCCESS) {
+      return status; // Entry stays dirty for a retry
+    }
+    dac_shadow_written(ctx, reg);
+  }
+
+  return DAC_SUCCESS;
+}
+
+void dac_shadow_invalidate(dac63004w_context_t *ctx, uint8_t reg) {
   if (!ctx) {
+    return;
+  }
+
+  if (reg >= DAC_REG_COUNT) {
+    for (uint8_t i = 0; i < sizeof(ctx->shadow.valid); i++) {
+      ctx->shadow.valid[i] = 0;
+      ctx->shadow.dirty[i] = 0;
+    }
+    ctx->shadow.unlatched = 0;
+    return;
+  }
+
+  dac_shadow_unmark(ctx->shadow.valid, reg);
+  dac_shadow_unmark(ctx->shadow.dirty, reg);
+}
+
+dac63004w_status_t dac_read_register(dac63004w_context_t *ctx, uint8_t reg,
+                                     uint16_t *value) {
+  if (!ctx || !value || reg & DAC_SPI_READ) {
     return DAC_ERROR_PARAM;
   }
 
-  // Step 1: Software reset
-  if (dac_reset() != DAC_SUCCESS) {
+  // The first frame selects the register, the second clocks its data out
+  dac63004w_status_t status = dac_transfer_frame(ctx->spi, DAC_SPI_READ | reg, 0, NULL);
+  if (status == DAC_SUCCESS) {
+    status = dac_transfer_frame(ctx->spi, DAC_REG_NOP, 0, value);
+  }
+  if (status == DAC_SUCCESS) {
+    ctx->shadow.issued += 2;
   }
+  return status;
+}
+
+dac63004w_status_t dac_set_write_verify(dac63004w_context_t *ctx,
+                                        bool enable) {
+  if (!ctx) {
+    return DAC_ERROR_PARAM;
+  }
+
+  ctx->verify_writes = enable;
+  return DAC_SUCCESS;
+}
+
+dac63004w_status_t dac_check_status(dac63004w_context_t *ctx,
+                                    uint16_t *status) {
+  uint16_t value;
+  dac63004w_status_t result = dac_read_register(ctx, DAC_REG_GENERAL_STATUS,
+                                                &value);
+  if (result != DAC_SUCCESS) {
+    return result;
+  }
+
+  if (status) {
+    *status = value;
+  }
+
+  // A dead or unpowered SDO line floats to one rail
+  if (value == 0x0000 || value == 0xFFFF) {
+    return DAC_ERROR_COMM;
+  }
+
+  if (value & (DAC_STATUS_NVM_CRC_FAIL_INT | DAC_STATUS_NVM_CRC_FAIL_USER)) {
+    return DAC_ERROR_CRC;
+  }
+
+  return DAC_SUCCESS;
+}
+
+dac63004w_status_t dac_verify_config(dac63004w_context_t *ctx,
+                                     uint8_t *mismatches) {
+  if (!ctx) {
+    return DAC_ERROR_PARAM;
+  }
+
+  uint8_t count = 0;
+  uint8_t prev = DAC_REG_NOP;
+
+  // Each read command frame clocks out the previous register's data, and a
+  // final NOP frame clocks out the last one
+  for (uint8_t reg = 1; reg <= DAC_REG_COUNT; reg++) {
+    bool last = (reg == DAC_REG_COUNT);
+    if (!last && !(dac_reg_verifiable(reg) &&
+                   dac_shadow_test(ctx->shadow.valid, reg) &&
+                   !dac_shadow_test(ctx->shadow.dirty, reg))) {
+      continue;
+    }
+
+    uint16_t readback;
+    uint8_t addr = last ? DAC_REG_NOP : (DAC_SPI_READ | reg);
+    if (dac_transfer_frame(ctx->spi, addr, 0, &readback) != DAC_SUCCESS) {
+      return DAC_ERROR_COMM;
+    }
+    ctx->shadow.issued++;
+
+    if (prev != DAC_REG_NOP && readback != ctx->shadow.value[prev]) {
+      dac_shadow_unmark(ctx->shadow.valid, prev); // Resend on next write
+      count++;
+    }
+    prev = last ? DAC_REG_NOP : reg;
+  }
+
+  if (mismatches) {
+    *mismatches = count;
+  }
+  return count ? DAC_ERROR_VERIFY : DAC_SUCCESS;
+}
+
+dac63004w_status_t dac_reset(dac63004w_context_t *ctx) {
+  if (!ctx) {
+    return DAC_ERROR_PARAM;
+  }
+
+  // Every register goes back to its default
+  dac_shadow_invalidate(ctx, DAC_REG_COUNT);
+  ctx->iout_channels = 0;
+  ctx->mode = DAC_MODE_VOLTAGE;
+
+  if (dac_write_register(ctx->spi, DAC_REG_COMMON_TRIGGER, DAC_RESET_TRIGGER) !=
+      DAC_SUCCESS) {
+    return DAC_ERROR_COMM;
+  }
+  ctx->shadow.issued++;
+  return DAC_SUCCESS;
+}
+
+dac63004w_status_t dac_trigger_ldac(dac63004w_context_t *ctx) {
+  if (!ctx) {
+    return DAC_ERROR_PARAM;
+  }
+
+  return dac_issue_ldac(ctx);
+}
+
+dac63004w_status_t dac_broadcast_ldac(const spi_device_t *group) {
+  if (!group) {
+    return DAC_ERROR_PARAM;
+  }
+
+  return dac_write_register(group, DAC_REG_COMMON_TRIGGER, DAC_LDAC_TRIGGER);
+}
+dac63004w_status_t dac_init(dac63004w_context_t *ctx) {
+  if (!ctx || ctx->vref_mv < DAC_VREF_MV_MIN) {
+    return DAC_ERROR_PARAM;
+  }
+
+  // Precompute the reciprocal once so updates need no division
+  ctx->mv_scale = (uint16_t)((((uint32_t)0xFFF << DAC_SCALE_Q) +
+                              (ctx->vref_mv >> 1)) /
+                             ctx->vref_mv);
+
+  ctx->shadow.issued = 0;
+  ctx->shadow.skipped = 0;
 
+  // Step 1: Software reset; nothing is known about the registers until
+  // they are written
+  if (dac_reset(ctx) != DAC_SUCCESS) {
+    return DAC_ERROR_COMM;
+  }
+
+  // The reset frame must be on the wire before the reset wait starts
+  msp_spi_flush();
   delay_ms(1);
 
-  // Step 2: Configure gain settings for each channel
+  // Step 2: Drive SDO so registers can be read back
+  if (dac_write_shadowed(ctx, DAC_REG_INTERFACE, DAC_INTERFACE_SDO_EN) !=
+      DAC_SUCCESS) {
+    return DAC_ERROR_COMM;
+  }
+
+  // Step 3: Configure gain settings for each channel
   uint16_t gain_config =
       DAC_VOUT_GAIN_1P5X_INT_REFERENCE; // Using internal reference
   for (uint8_t channel = 0; channel < 4; channel++) {
     uint8_t reg_addr = dac_get_vout_config_register(channel);
-    if (dac_write_register(reg_addr, gain_config) != DAC_SUCCESS) {
+    if (dac_write_shadowed(ctx, reg_addr, gain_config) != DAC_SUCCESS) {
       return DAC_ERROR_COMM;
     }
   }
 
-  // Step 3: Enable internal reference and set normal operation
-  if (dac_write_register(DAC_REG_COMMON_CONFIG, 0x1249) != DAC_SUCCESS) {
+  // Step 4: Hold data register writes until LDAC so channels update together
+  for (uint8_t channel = 0; channel < DAC_NUM_CHANNELS; channel++) {
+    uint8_t reg_addr = dac_get_func_config_register(channel);
+    if (dac_write_shadowed(ctx, reg_addr, DAC_FUNC_CONFIG_SYNC_LDAC) !=
+        DAC_SUCCESS) {
+      return DAC_ERROR_COMM;
+    }
+  }
+
+  // Step 5: Enable internal reference and set normal operation
+  if (dac_write_shadowed(ctx, DAC_REG_COMMON_CONFIG, 0x1249) != DAC_SUCCESS) {
     return DAC_ERROR_COMM;
   }
 
-  // Step 4: Trigger LDAC to update all outputs
-  if (dac_trigger_ldac() != DAC_SUCCESS) {
+  // Reset leaves every generator stopped
+  ctx->shadow.value[DAC_REG_COMMON_DAC_TRIG] = 0;
+  dac_shadow_mark(ctx->shadow.valid, DAC_REG_COMMON_DAC_TRIG);
+
+  // Step 6: Trigger LDAC to update all outputs
+  if (dac_issue_ldac(ctx) != DAC_SUCCESS) {
     return DAC_ERROR_COMM;
   }
 
   // Wait for settings to take effect
   /* usleep(1000); */
+  msp_spi_flush();
   return DAC_SUCCESS;
 }
 
@@ -96,6 +482,163 @@ dac63004w_status_t dac_set_mode(dac63004w_context_t *ctx,
   return DAC_SUCCESS;
 }
 
+dac63004w_status_t dac_set_channel_sync(dac63004w_context_t *ctx,
+                                        uint8_t channel, bool ldac_sync) {
+  if (!ctx || channel > 3) {
+    return DAC_ERROR_PARAM;
+  }
+
+  uint8_t reg_addr = dac_get_func_config_register(channel);
+  uint16_t value = ctx->shadow.value[reg_addr] & ~DAC_FUNC_CONFIG_SYNC_LDAC;
+  if (ldac_sync) {
+    value |= DAC_FUNC_CONFIG_SYNC_LDAC;
+  }
+
+  return dac_write_shadowed(ctx, reg_addr, value);
+}
+
+/**
+ * @brief Clear the START-FUNC bits of the channels in the mask
+ */
+static dac63004w_status_t dac_funcgen_halt(dac63004w_context_t *ctx,
+                                           uint8_t channel_mask) {
+  uint16_t value = ctx->shadow.value[DAC_REG_COMMON_DAC_TRIG];
+  for (uint8_t channel = 0; channel < DAC_NUM_CHANNELS; channel++) {
+    if (channel_mask & (1 << channel)) {
+      value &= ~DAC_START_FUNC(channel);
+      // The generator left the output somewhere; resend the next code
+      dac_shadow_invalidate(ctx, dac_get_data_register(channel));
+    }
+  }
+
+  return dac_write_shadowed(ctx, DAC_REG_COMMON_DAC_TRIG, value);
+}
+
+dac63004w_status_t dac_funcgen_configure(
+    dac63004w_context_t *ctx, uint8_t channel,
+    const dac63004w_funcgen_config_t *config) {
+  if (!ctx || !config || channel > 3) {
+    return DAC_ERROR_PARAM;
+  }
+
+  if ((config->shape & ~DAC_FUNC_CONFIG_SHAPE_MASK) ||
+      (config->phase & ~DAC_FUNC_CONFIG_PHASE_MASK) ||
+      (config->code_step & ~DAC_CODE_STEP_MASK) ||
+      config->slew == DAC_SLEW_RATE_NONE ||
+      config->slew > DAC_SLEW_RATE_5128_US ||
+      config->margin_low > 0xFFF || config->margin_high > 0xFFF ||
+      config->margin_low >= config->margin_high) {
+    return DAC_ERROR_PARAM;
+  }
+
+  // Registers must not change under a running generator
+  dac63004w_status_t status = dac_funcgen_halt(ctx, 1 << channel);
+  if (status != DAC_SUCCESS) {
+    return status;
+  }
+
+  status = dac_write_shadowed(ctx, dac_get_margin_high_register(channel),
+                              DAC_DATA_12BIT(config->margin_high));
+  if (status != DAC_SUCCESS) {
+    return status;
+  }
+  status = dac_write_shadowed(ctx, dac_get_margin_low_register(channel),
+                              DAC_DATA_12BIT(config->margin_low));
+  if (status != DAC_SUCCESS) {
+    return status;
+  }
+
+  // The generator drives the output directly, so LDAC sync is left off
+  uint16_t value = config->shape | config->phase | config->code_step |
+                   (uint16_t)config->slew;
+  return dac_write_shadowed(ctx, dac_get_func_config_register(channel), value);
+}
+
+dac63004w_status_t dac_funcgen_start(dac63004w_context_t *ctx,
+                                     uint8_t channel_mask) {
+  if (!ctx || channel_mask == 0 || channel_mask > 0x0F) {
+    return DAC_ERROR_PARAM;
+  }
+
+  uint16_t value = ctx->shadow.value[DAC_REG_COMMON_DAC_TRIG];
+  for (uint8_t channel = 0; channel < DAC_NUM_CHANNELS; channel++) {
+    if (channel_mask & (1 << channel)) {
+      value |= DAC_START_FUNC(channel);
+    }
+  }
+
+  return dac_write_shadowed(ctx, DAC_REG_COMMON_DAC_TRIG, value);
+}
+
+dac63004w_status_t dac_funcgen_stop(dac63004w_context_t *ctx,
+                                    uint8_t channel_mask) {
+  if (!ctx || channel_mask == 0 || channel_mask > 0x0F) {
+    return DAC_ERROR_PARAM;
+  }
+
+  dac63004w_status_t status = dac_funcgen_halt(ctx, channel_mask);
+
+  // Hand the channels back LDAC-synchronised and without slew, as
+  // dac_init() left them, so dac_write_batch() latches them together again
+  for (uint8_t channel = 0; channel < DAC_NUM_CHANNELS; channel++) {
+    if (status != DAC_SUCCESS) {
+      break;
+    }
+    if (channel_mask & (1 << channel)) {
+      status = dac_write_shadowed(ctx, dac_get_func_config_register(channel),
+                                  DAC_FUNC_CONFIG_SYNC_LDAC);
+    }
+  }
+
+  return status;
+}
+
+uint32_t dac_funcgen_period_us(const dac63004w_funcgen_config_t *config) {
+  // Time per step in units of 40 ns, indexed by slew_rate_t. Every slew
+  // time is a multiple of 40 ns, and this keeps steps * time within 32 bits.
+  static const uint32_t k_slew_40ns[16] = {
+      0,    100,  200,   300,   450,   676,   1012,  1518,
+      2278, 3418, 5980, 10466, 18314, 32050, 64099, 128198};
+  // LSB per step, indexed by DAC_CODE_STEP_* >> 4
+  static const uint8_t k_step_lsb[8] = {1, 2, 3, 4, 6, 8, 16, 32};
+
+  if (!config || config->slew == DAC_SLEW_RATE_NONE ||
+      config->slew > DAC_SLEW_RATE_5128_US ||
+      config->margin_low >= config->margin_high) {
+    return 0;
+  }
+
+  uint32_t steps;
+  if (config->shape == DAC_FUNC_CONFIG_SINE) {
+    steps = 24; // Fixed sine table
+  } else {
+    uint8_t lsb = k_step_lsb[(config->code_step & DAC_CODE_STEP_MASK) >> 4];
+    uint16_t span = config->margin_high - config->margin_low;
+    steps = (span + lsb - 1) / lsb;
+    if (config->shape == DAC_FUNC_CONFIG_TRIANGLE) {
+      steps *= 2; // Up and back down
+    }
+  }
+
+  return (steps * k_slew_40ns[config->slew] + 12) / 25;
+}
+
+/**
+ * @brief Power one channel's VOUT or IOUT stage up and the other down
+ */
+static dac63004w_status_t dac_select_output(dac63004w_context_t *ctx,
+                                            uint8_t channel, bool current) {
+  uint16_t value = ctx->shadow.value[DAC_REG_COMMON_CONFIG];
+  value &= ~(DAC_VOUT_PDN(channel, 0x3) | DAC_IOUT_PDN(channel));
+  if (current) {
+    value |= DAC_VOUT_PDN(channel, DAC_VOUT_PDN_HIZ);
+  } else {
+    value |= DAC_IOUT_PDN(channel);
+  }
+
+  return dac_write_shadowed(ctx, DAC_REG_COMMON_CONFIG, value);
+}
+
 dac63004w_status_t dac_configure_voltage_mode(dac63004w_context_t *ctx,
                                               uint16_t gain, uint8_t channel) {
   if (!ctx || channel > 3) {
@@ -105,16 +648,189 @@ dac63004w_status_t dac_configure_voltage_mode(dac63004w_context_t *ctx,
   // Configure the VOUT_CMP_CONFIG register for the channel
   uint8_t reg_addr = dac_get_vout_config_register(channel);
 
-  if (dac_write_register(reg_addr, gain) != DAC_SUCCESS) {
+  if (dac_write_shadowed(ctx, reg_addr, gain) != DAC_SUCCESS) {
     return DAC_ERROR_PARAM;
   }
 
+  // Hand the pin back from the current stage
+  if (ctx->iout_channels & (1 << channel)) {
+    if (dac_select_output(ctx, channel, false) != DAC_SUCCESS) {
+      return DAC_ERROR_COMM;
+    }
+    ctx->iout_channels &= ~(1 << channel);
+
+    // The data register still holds an IOUT code
+    dac_shadow_invalidate(ctx, dac_get_data_register(channel));
+  }
+
   // Update the operating mode
-  ctx->mode = DAC_MODE_VOLTAGE;
+  ctx->mode = ctx->iout_channels ? DAC_MODE_CURRENT : DAC_MODE_VOLTAGE;
 
   return DAC_SUCCESS;
 }
 
+dac63004w_status_t dac_configure_current_mode(dac63004w_context_t *ctx,
+                                              uint8_t channel,
+                                              dac63004w_iout_range_t range) {
+  // Range ends in µA, indexed by dac63004w_iout_range_t
+  static const int16_t k_range_min[] = {0,   0,   0,    0,    -24, -48,
+                                        -120, -240, -25, -50, -125, -250};
+  static const int16_t k_range_max[] = {25, 50, 125, 250, 0,   0,
+                                        0,  0,  25,  50,  125, 250};
+
+  if (!ctx || channel > 3 || range > DAC_IOUT_RANGE_PM250UA) {
+    return DAC_ERROR_PARAM;
+  }
+
+  uint8_t reg_addr = dac_get_iout_config_register(channel);
+  uint16_t value = dac_shadow_test(ctx->shadow.valid, reg_addr)
+                       ? ctx->shadow.value[reg_addr] & ~DAC_IOUT_RANGE_MASK
+                       : 0;
+  value |= (uint16_t)range << DAC_IOUT_RANGE_SHIFT;
+  if (dac_write_shadowed(ctx, reg_addr, value) != DAC_SUCCESS) {
+    return DAC_ERROR_COMM;
+  }
+
+  if (!(ctx->iout_channels & (1 << channel))) {
+    if (dac_select_output(ctx, channel, true) != DAC_SUCCESS) {
+      return DAC_ERROR_COMM;
+    }
+    ctx->iout_channels |= (1 << channel);
+
+    // The data register still holds a VOUT code
+    dac_shadow_invalidate(ctx, dac_get_data_register(channel));
+  }
+
+  // Precompute the reciprocal so dac_write_current() needs no division
+  uint16_t span = k_range_max[range] - k_range_min[range];
+  ctx->iout_min_ua[channel] = k_range_min[range];
+  ctx->iout_max_ua[channel] = k_range_max[range];
+  ctx->iout_scale[channel] =
+      (uint16_t)((((uint32_t)0xFF << DAC_IOUT_SCALE_Q) + (span >> 1)) / span);
+
+  ctx->mode = DAC_MODE_CURRENT;
+
+  return DAC_SUCCESS;
+}
+
+dac63004w_status_t dac_write_current(dac63004w_context_t *ctx, uint8_t channel,
+                                     int16_t microamps) {
+  if (!ctx || channel > 3 || !(ctx->iout_channels & (1 << channel))) {
+    return DAC_ERROR_PARAM;
+  }
+
+  int16_t min = ctx->iout_min_ua[channel];
+  int16_t max = ctx->iout_max_ua[channel];
+  if (microamps < min || microamps > max) {
+    return DAC_ERROR_PARAM;
+  }
+
+  // Sink-only ranges count up from 0 µA towards the negative end; the
+  // others count up from their low end
+  uint16_t offset = (max == 0) ? (uint16_t)(-microamps)
+                               : (uint16_t)(microamps - min);
+
+  // code = offset * (255 / span), rounded; one 16x16 hardware multiply
+  uint32_t product = (uint32_t)offset * ctx->iout_scale[channel];
+  uint16_t code = (uint16_t)((product + (1UL << (DAC_IOUT_SCALE_Q - 1))) >>
+                             DAC_IOUT_SCALE_Q);
+  if (code > 0xFF) {
+    code = 0xFF;
+  }
+
+  uint16_t data = DAC_DATA_8BIT(code);
+  if (dac_output_matches(ctx, channel, data)) {
+    ctx->shadow.skipped += 2;
+    return DAC_SUCCESS;
+  }
+
+  // Skips the data frame if only the LDAC is outstanding
+  dac63004w_status_t status =
+      dac_write_shadowed(ctx, dac_get_data_register(channel), data);
+  if (status != DAC_SUCCESS) {
+    return status;
+  }
+
+  return dac_issue_ldac(ctx);
+}
+
+/**
+ * @brief Put a channel in voltage mode before a 12-bit code is written
+ *
+ * A channel in current mode goes back to voltage mode with its last gain.
+ */
+static dac63004w_status_t dac_ensure_voltage_mode(dac63004w_context_t *ctx,
+                                                  uint8_t channel) {
+  if (!(ctx->iout_channels & (1 << channel))) {
+    return DAC_SUCCESS;
+  }
+
+  uint8_t vout_reg = dac_get_vout_config_register(channel);
+  uint16_t gain = dac_shadow_test(ctx->shadow.valid, vout_reg)
+                      ? ctx->shadow.value[vout_reg]
+                      : DAC_VOUT_GAIN_1X_VDD_REFERENCE;
+  return dac_configure_voltage_mode(ctx, gain, channel);
+}
+
+/**
+ * @brief Queue a data frame for one channel followed by LDAC
+ */
+static dac63004w_status_t dac_write_data(dac63004w_context_t *ctx,
+                                         uint8_t channel, uint16_t code) {
+  dac63004w_status_t status = dac_ensure_voltage_mode(ctx, channel);
+  if (status != DAC_SUCCESS) {
+    return status;
+  }
+
+  // An unchanged, latched code means the output is already there and
+  // neither frame is needed
+  uint16_t data = DAC_DATA_12BIT(code);
+  if (dac_output_matches(ctx, channel, data)) {
+    ctx->shadow.skipped += 2;
+    return DAC_SUCCESS;
+  }
+
+  // Write to DAC register - 12-bit value left-aligned in 16-bit word. A
+  // staged or unlatched code already in the device only needs the LDAC.
+  status = dac_write_shadowed(ctx, dac_get_data_register(channel), data);
+  if (status != DAC_SUCCESS) {
+    return status;
+  }
+
+  // Trigger LDAC to update outputs
+  return dac_issue_ldac(ctx);
+}
+
+dac63004w_status_t dac_write_code(dac63004w_context_t *ctx, uint8_t channel,
+                                  uint16_t code) {
+  if (!ctx || channel > 3 || code > 0xFFF) {
+    return DAC_ERROR_PARAM;
+  }
+
+  return dac_write_data(ctx, channel, code);
+}
+
+uint16_t dac_millivolts_to_code(const dac63004w_context_t *ctx,
+                                uint16_t millivolts) {
+  // code = mV * (4095 / vref_mv), rounded; one 16x16 hardware multiply
+  uint32_t product = (uint32_t)millivolts * ctx->mv_scale;
+  uint16_t code =
+      (uint16_t)((product + (1UL << (DAC_SCALE_Q - 1))) >> DAC_SCALE_Q);
+  if (code > 0xFFF) {
+    code = 0xFFF;
+  }
+  return code;
+}
+
+dac63004w_status_t dac_write_millivolts(dac63004w_context_t *ctx,
+                                        uint8_t channel, uint16_t millivolts) {
+  if (!ctx || channel > 3 || millivolts > ctx->vref_mv) {
+    return DAC_ERROR_PARAM;
+  }
+
+  return dac_write_data(ctx, channel, dac_millivolts_to_code(ctx, millivolts));
+}
+
 dac63004w_status_t dac_write_voltage(dac63004w_context_t *ctx, uint8_t channel,
                                      float voltage) {
   if (!ctx || channel > 3) {
@@ -122,31 +838,56 @@ dac63004w_status_t dac_write_voltage(dac63004w_context_t *ctx, uint8_t channel,
   }
 
   // Validate voltage range
-  if (voltage < 0 || voltage > ctx->vref) {
+  float vref = ctx->vref_mv / 1000.0f;
+  if (voltage < 0 || voltage > vref) {
+    return DAC_ERROR_PARAM;
+  }
+
+  // Calculate DAC code - 12-bit value
+  uint16_t dac_code = (uint16_t)(((voltage / vref) * 0xFFF) + 0.5f);
+
+  return dac_write_data(ctx, channel, dac_code);
+}
+
+dac63004w_status_t dac_write_batch(dac63004w_context_t *ctx,
+                                   const dac63004w_update_t *updates,
+                                   uint8_t count) {
+  if (!ctx || !updates || count == 0) {
     return DAC_ERROR_PARAM;
   }
 
-  // If in current mode, switch to voltage mode
-  if (ctx->mode != DAC_MODE_VOLTAGE) {
-    dac63004w_status_t status = dac_configure_voltage_mode(
-        ctx, DAC_VOUT_GAIN_1X_VDD_REFERENCE, channel);
+  // Reject the whole batch up front so a bad entry never leaves the
+  // channels half updated
+  for (uint8_t i = 0; i < count; i++) {
+    if (updates[i].channel >= DAC_NUM_CHANNELS || updates[i].code > 0xFFF) {
+      return DAC_ERROR_PARAM;
+    }
+  }
+
+  // Codes are 12-bit voltage codes, so current-mode channels switch over
+  // before any data goes out
+  for (uint8_t i = 0; i < count; i++) {
+    dac63004w_status_t status = dac_ensure_voltage_mode(ctx, updates[i].channel);
     if (status != DAC_SUCCESS) {
       return status;
     }
   }
 
-  // Calculate DAC code - 12-bit value left-aligned in 16-bit word
-  uint16_t dac_code = (uint16_t)(((voltage / ctx->vref) * 0xFFF) + 0.5) << 4;
-
-  // Get data register for the channel
-  uint8_t reg_addr = dac_get_data_register(channel);
+  // Queue the changed data frames back to back; outputs hold until LDAC
+  for (uint8_t i = 0; i < count; i++) {
+    uint8_t reg_addr = dac_get_data_register(updates[i].channel);
+    dac63004w_status_t status =
+        dac_write_shadowed(ctx, reg_addr, DAC_DATA_12BIT(updates[i].code));
+    if (status != DAC_SUCCESS) {
+      return status;
+    }
+  }
 
-  // Write to DAC register
-  dac63004w_status_t status = dac_write_register(reg_addr, dac_code);
-  if (status != DAC_SUCCESS) {
-    return status;
+  if (!ctx->shadow.unlatched) {
+    ctx->shadow.skipped++; // Every output is current, LDAC would be a no-op
+    return DAC_SUCCESS;
   }
 
-  // Trigger LDAC to update outputs
-  return dac_trigger_ldac();
+  // One LDAC latches every channel on the same edge
+  return dac_issue_ldac(ctx);
 }
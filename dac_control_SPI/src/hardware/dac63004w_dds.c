@@ -0,0 +1,291 @@
+/**
+ * @file dac63004w_dds.c
+ * @brief Direct digital synthesis of sine tones and sweeps on a DAC63004W
+ */
+#include "hardware/dac63004w_dds.h"
+#include "hardware/dac63004w_playback.h"
+#include "msp_clock.h"
+#include "msp_delay.h"
+#include "msp_spi.h"
+#include <msp430.h>
+
+#define DDS_FRAME_SIZE 3
+
+// sin(x) on [0, pi/2] as a Taylor series to x^11, evaluated by the compiler;
+// the truncation error stays below 0.01 LSB of the table
+#define DDS_PI 3.14159265358979323846
+#define DDS_X(i) ((double)(i) * (DDS_PI / 2.0 / (1 << DAC_DDS_TABLE_BITS)))
+#define DDS_SIN(x)                                                             \
+  ((x) * (1.0 - (x) * (x) / 6.0 *                                              \
+                    (1.0 - (x) * (x) / 20.0 *                                  \
+                               (1.0 - (x) * (x) / 42.0 *                       \
+                                          (1.0 - (x) * (x) / 72.0 *            \
+                                                     (1.0 - (x) * (x) /        \
+                                                                110.0))))))
+#define DDS_ENTRY(i) ((uint16_t)(DAC_DDS_PEAK * DDS_SIN(DDS_X(i)) + 0.5))
+#define DDS_E4(i)                                                              \
+  DDS_ENTRY(i), DDS_ENTRY((i) + 1), DDS_ENTRY((i) + 2), DDS_ENTRY((i) + 3)
+#define DDS_E16(i) DDS_E4(i), DDS_E4((i) + 4), DDS_E4((i) + 8), DDS_E4((i) + 12)
+#define DDS_E64(i)                                                             \
+  DDS_E16(i), DDS_E16((i) + 16), DDS_E16((i) + 32), DDS_E16((i) + 48)
+#define DDS_E256(i)                                                            \
+  DDS_E64(i), DDS_E64((i) + 64), DDS_E64((i) + 128), DDS_E64((i) + 192)
+
+#if DAC_DDS_TABLE_BITS != 8
+#error The quarter-wave table initializer is written out for 256 entries
+#endif
+
+// Quarter sine wave, const so it stays in FRAM. The extra last entry is the
+// peak, so interpolation never reads past the table.
+static const uint16_t k_quarter_sine[(1 << DAC_DDS_TABLE_BITS) + 1] = {
+    DDS_E256(0), DDS_ENTRY(1 << DAC_DDS_TABLE_BITS)};
+
+// Generator state shared with the Timer3_A CCR0 ISR
+static uint32_t g_phase;
+static uint32_t g_word;           // Phase increment per sample
+static int32_t g_step;            // Sweep increment of g_word per sample,
+static uint16_t g_step_frac;      //   plus g_step_frac / 65536
+static uint16_t g_frac;           // Fractional part of g_word
+static uint32_t g_sweep_left;     // Samples until the sweep ends, 0 if none
+static uint32_t g_sweep_samples;
+static uint32_t g_word_start;
+static uint32_t g_word_stop;
+static uint32_t g_period_cycles;  // SMCLK cycles per sample
+static bool g_repeat;
+static uint16_t g_amplitude;
+static uint16_t g_offset;
+static uint8_t g_frame[DDS_FRAME_SIZE]; // Next sample, ready to send
+static uint8_t g_channel;
+static volatile bool g_active;
+static volatile uint16_t g_dropped;
+static const spi_device_t *g_device;
+
+/**
+ * @brief 16 x 16 bit unsigned multiply
+ *
+ * Uses MPY32 directly, with interrupts held off like the compiler's own
+ * multiply helpers: dac_dds_sample() also runs outside the ISR, and the
+ * ISR must not find the multiplier mid-operation or clobber its result.
+ */
+static inline uint32_t mul16(uint16_t a, uint16_t b) {
+#ifdef __MSP430_HAS_MPY32__
+  uint16_t state = __get_interrupt_state();
+  __disable_interrupt();
+  MPY = a;
+  OP2 = b; // Starts the multiplication
+  uint32_t result = ((uint32_t)RESHI << 16) | RESLO;
+  __set_interrupt_state(state);
+  return result;
+#else
+  return (uint32_t)a * b;
+#endif
+}
+
+static inline void encode_frame(uint16_t code) {
+  uint16_t data = DAC_DATA_12BIT(code);
+  g_frame[1] = (data >> 8) & 0xFF;
+  g_frame[2] = data & 0xFF;
+}
+
+uint32_t dac_dds_tuning_word(uint32_t freq_mhz, uint32_t period_cycles) {
+  // word = freq / sample rate * 2^32
+  //      = freq_mhz * period_cycles * 2^32 / (SMCLK * 1000),
+  // as two 16-bit long division steps so nothing overflows 64 bits
+  const uint64_t divisor = (uint64_t)MSP_SMCLK_HZ * 1000;
+  uint64_t x = (uint64_t)freq_mhz * period_cycles;
+  uint64_t high = (x << 16) / divisor;
+  uint64_t rest = (x << 16) % divisor;
+  uint64_t low = ((rest << 16) + divisor / 2) / divisor;
+  return (uint32_t)((high << 16) + low);
+}
+
+uint16_t dac_dds_sample(uint32_t phase, uint16_t amplitude, uint16_t offset) {
+  // Top two bits: quadrant. The second and fourth quadrants run the table
+  // backwards, the third and fourth are negated.
+  uint8_t quadrant = (uint8_t)(phase >> 30);
+  uint32_t position = phase << 2;
+  if (quadrant & 1) {
+    position = ~position;
+  }
+
+  uint16_t index = (uint16_t)(position >> (32 - DAC_DDS_TABLE_BITS));
+  uint16_t frac = (uint16_t)(position >> (16 - DAC_DDS_TABLE_BITS));
+  uint16_t low = k_quarter_sine[index];
+  uint16_t high = k_quarter_sine[index + 1];
+  uint16_t sine = low + (uint16_t)((mul16(high - low, frac) + 0x8000) >> 16);
+
+  uint16_t swing = (uint16_t)((mul16(sine, amplitude) + 0x4000) >> 15);
+  return (quadrant & 2) ? offset - swing : offset + swing;
+}
+
+dac63004w_status_t dac_dds_start(dac63004w_context_t *ctx, uint8_t channel,
+                                 const dac_dds_config_t *config) {
+  if (!ctx || !config || channel > 3 || config->sample_rate_hz == 0 ||
+      config->amplitude > config->offset ||
+      (uint32_t)config->offset + config->amplitude > 0xFFF) {
+    return DAC_ERROR_PARAM;
+  }
+
+  // Same prescaler search as playback: ID gives /1../8, TAIDEX up to /64
+  uint32_t ticks = (MSP_SMCLK_HZ + config->sample_rate_hz / 2) /
+                   config->sample_rate_hz;
+  uint8_t shift = 0;
+  while ((ticks >> shift) > 0x10000UL) {
+    if (++shift > 6) {
+      return DAC_ERROR_PARAM; // Slower than SMCLK / 64 / 65536
+    }
+  }
+  ticks >>= shift;
+  if (ticks < 2) {
+    return DAC_ERROR_PARAM;
+  }
+  uint32_t period_cycles = ticks << shift;
+
+  // Every tick sends a frame and computes the next sample
+  if (period_cycles < (uint32_t)dac_playback_frame_cycles(ctx->spi) +
+                          DAC_DDS_SYNTH_CYCLES) {
+    return DAC_ERROR_PARAM;
+  }
+
+  // Both ends must stay below half the sample rate
+  uint64_t nyquist = (uint64_t)MSP_SMCLK_HZ * 1000 / 2;
+  bool sweep = config->sweep_ms != 0;
+  if ((uint64_t)config->start_mhz * period_cycles >= nyquist ||
+      (sweep && (uint64_t)config->stop_mhz * period_cycles >= nyquist)) {
+    return DAC_ERROR_PARAM;
+  }
+
+  dac_dds_stop(ctx);
+
+  // Each frame updates the output by itself while streaming
+  if (dac_set_channel_sync(ctx, channel, false) != DAC_SUCCESS) {
+    return DAC_ERROR_COMM;
+  }
+  msp_spi_flush();
+
+  // Raw frames bypass the driver's register cache
+  dac_shadow_invalidate(ctx, DAC_REG_X_DATA + channel);
+
+  g_period_cycles = period_cycles;
+  g_word_start = dac_dds_tuning_word(config->start_mhz, period_cycles);
+  g_word_stop = g_word_start;
+  g_sweep_samples = 0;
+  g_step = 0;
+  g_step_frac = 0;
+  if (sweep) {
+    g_word_stop = dac_dds_tuning_word(config->stop_mhz, period_cycles);
+    g_sweep_samples = (uint32_t)((uint64_t)config->sweep_ms * MSP_SMCLK_HZ /
+                                 (1000ULL * period_cycles));
+  }
+  if (g_sweep_samples) {
+    // Per-sample increment of the tuning word in 1/65536 steps, split into
+    // whole and fractional parts so the ISR only adds
+    int64_t step = ((int64_t)g_word_stop - (int64_t)g_word_start) * 65536 /
+                   (int64_t)g_sweep_samples;
+    g_step_frac = (uint16_t)step;
+    g_step = (int32_t)((step - g_step_frac) / 65536);
+  }
+
+  g_phase = 0;
+  g_word = g_word_start;
+  g_frac = 0;
+  g_sweep_left = g_sweep_samples;
+  g_repeat = config->sweep_repeat;
+  g_amplitude = config->amplitude;
+  g_offset = config->offset;
+  g_frame[0] = (DAC_REG_X_DATA + channel) & 0x7F;
+  encode_frame(dac_dds_sample(0, g_amplitude, g_offset));
+  g_dropped = 0;
+  g_channel = channel;
+  g_device = ctx->spi;
+  g_active = true;
+  delay_smclk_acquire(); // The timer stops if delay_ms() enters LPM3
+
+  static const uint16_t k_input_divider[] = {ID_0, ID_1, ID_2, ID_3};
+  uint16_t id = k_input_divider[(shift > 3) ? 3 : shift];
+  TA3CTL = TACLR;
+  TA3EX0 = (shift > 3) ? ((1 << (shift - 3)) - 1) : 0;
+  TA3CCR0 = (uint16_t)(ticks - 1);
+  TA3CCTL0 = CCIE;
+  TA3CTL = TASSEL__SMCLK | MC__UP | id | TACLR;
+
+  return DAC_SUCCESS;
+}
+
+dac63004w_status_t dac_dds_stop(dac63004w_context_t *ctx) {
+  if (!ctx) {
+    return DAC_ERROR_PARAM;
+  }
+
+  TA3CTL = MC__STOP;
+  TA3CCTL0 = 0;
+
+  if (!g_active) {
+    return DAC_SUCCESS;
+  }
+  g_active = false;
+  delay_smclk_release();
+
+  // Back to LDAC-synchronised updates for the rest of the driver
+  return dac_set_channel_sync(ctx, g_channel, true);
+}
+
+bool dac_dds_active(void) { return g_active; }
+
+uint16_t dac_dds_dropped(void) { return g_dropped; }
+
+uint32_t dac_dds_frequency_mhz(void) {
+  uint16_t state = __get_interrupt_state();
+  __disable_interrupt();
+  uint32_t word = g_word;
+  uint32_t period_cycles = g_period_cycles;
+  __set_interrupt_state(state);
+
+  if (period_cycles == 0) {
+    return 0; // Never started
+  }
+
+  // freq_mhz = word * SMCLK / period * 1000 / 2^32, rounded; 1000 / 2^32
+  // is applied as 125 / 2^29 to keep the products within 64 bits
+  uint64_t cycles = (uint64_t)word * MSP_SMCLK_HZ;
+  uint64_t whole = cycles / period_cycles;
+  uint64_t part = cycles % period_cycles;
+  uint64_t scaled = whole * 125 + part * 125 / period_cycles;
+  return (uint32_t)((scaled + (1UL << 28)) >> 29);
+}
+
+// Timer3_A CCR0 interrupt: send the sample computed last time, then the next
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector = TIMER3_A0_VECTOR
+__interrupt void TIMER3_A0_ISR(void)
+#elif defined(__GNUC__)
+void __attribute__((interrupt(TIMER3_A0_VECTOR))) TIMER3_A0_ISR(void)
+#else
+#error Compiler not supported!
+#endif
+{
+  // Sending first keeps the CS edge a fixed time after the tick
+  if (msp_spi_write_polled_to(g_device, g_frame, DDS_FRAME_SIZE) !=
+      SPI_SUCCESS) {
+    g_dropped++; // A queued or blocking transfer owns the bus
+  }
+
+  g_phase += g_word;
+
+  if (g_sweep_left) {
+    uint32_t frac = (uint32_t)g_frac + g_step_frac;
+    g_frac = (uint16_t)frac;
+    g_word += (uint32_t)g_step + (frac >> 16);
+    if (--g_sweep_left == 0) {
+      if (g_repeat) {
+        g_word = g_word_start;
+        g_frac = 0;
+        g_sweep_left = g_sweep_samples;
+      } else {
+        g_word = g_word_stop;
+      }
+    }
+  }
+
+  encode_frame(dac_dds_sample(g_phase, g_amplitude, g_offset));
+}
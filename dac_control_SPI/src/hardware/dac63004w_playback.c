@@ -0,0 +1,188 @@
+/**
+ * @file dac63004w_playback.c
+ * @brief Timer-paced waveform playback from FRAM tables to a DAC63004W channel
+ */
+#include "hardware/dac63004w_playback.h"
+#include "msp_clock.h"
+#include "msp_delay.h"
+#include <msp430.h>
+
+// Playback state shared with the Timer1_A CCR0 ISR
+static const dac_frame_t *g_begin;
+static const dac_frame_t *g_end;
+static const dac_frame_t *volatile g_next;
+static volatile bool g_loop;
+static volatile bool g_active;
+static volatile uint16_t g_dropped;
+static uint8_t g_channel;
+static const spi_device_t *g_device;
+
+/**
+ * @brief 24 bit clocks per frame plus the fixed ISR cost
+ */
+static uint16_t frame_cycles(uint16_t divider) {
+  return (uint16_t)(DAC_FRAME_SIZE * 8 * divider) +
+         DAC_PLAYBACK_ISR_OVERHEAD_CYCLES;
+}
+
+dac63004w_status_t dac_playback_encode(dac_frame_t *frames,
+                                       const uint16_t *codes, uint16_t count,
+                                       uint8_t channel) {
+  if (!frames || !codes || count == 0 || channel > 3) {
+    return DAC_ERROR_PARAM;
+  }
+
+  // Lift FRAM write protection in case the table is persistent
+  uint16_t fram_state = SYSCFG0 & (PFWP | DFWP);
+  SYSCFG0 = FRWPPW;
+
+  for (uint16_t i = 0; i < count; i++) {
+    uint16_t data = DAC_DATA_12BIT(codes[i]);
+    frames[i].bytes[0] = (DAC_REG_X_DATA + channel) & 0x7F;
+    frames[i].bytes[1] = (data >> 8) & 0xFF;
+    frames[i].bytes[2] = data & 0xFF;
+  }
+
+  SYSCFG0 = FRWPPW | fram_state;
+
+  return DAC_SUCCESS;
+}
+
+dac63004w_status_t dac_playback_start(dac63004w_context_t *ctx,
+                                      uint8_t channel,
+                                      const dac_frame_t *frames,
+                                      uint16_t count, uint32_t sample_rate_hz,
+                                      bool loop) {
+  if (!ctx || !frames || count == 0 || channel > 3 || sample_rate_hz == 0) {
+    return DAC_ERROR_PARAM;
+  }
+
+  // Faster than the ISR can shift frames out
+  if (sample_rate_hz > MSP_SMCLK_HZ / dac_playback_frame_cycles(ctx->spi)) {
+    return DAC_ERROR_PARAM;
+  }
+
+  // Find the smallest prescaler that brings the period into 16 bits:
+  // ID gives /1../8, TAIDEX extends it to /64
+  uint32_t ticks = (MSP_SMCLK_HZ + sample_rate_hz / 2) / sample_rate_hz;
+  uint8_t shift = 0;
+  while ((ticks >> shift) > 0x10000UL) {
+    if (++shift > 6) {
+      return DAC_ERROR_PARAM; // Slower than SMCLK / 64 / 65536
+    }
+  }
+  ticks >>= shift;
+  if (ticks < 2) {
+    return DAC_ERROR_PARAM;
+  }
+
+  dac_playback_stop(ctx);
+
+  // Each frame updates the output by itself while streaming
+  if (dac_set_channel_sync(ctx, channel, false) != DAC_SUCCESS) {
+    return DAC_ERROR_COMM;
+  }
+  msp_spi_flush();
+
+  // Raw frames bypass the driver's register cache
+  dac_shadow_invalidate(ctx, DAC_REG_X_DATA + channel);
+
+  g_begin = frames;
+  g_end = frames + count;
+  g_next = frames;
+  g_loop = loop;
+  g_dropped = 0;
+  g_channel = channel;
+  g_device = ctx->spi;
+  g_active = true;
+  delay_smclk_acquire(); // The timer stops if delay_ms() enters LPM3
+
+  static const uint16_t k_input_divider[] = {ID_0, ID_1, ID_2, ID_3};
+  uint16_t id = k_input_divider[(shift > 3) ? 3 : shift];
+  TA1CTL = TACLR;
+  TA1EX0 = (shift > 3) ? ((1 << (shift - 3)) - 1) : 0;
+  TA1CCR0 = (uint16_t)(ticks - 1);
+  TA1CCTL0 = CCIE;
+  TA1CTL = TASSEL__SMCLK | MC__UP | id | TACLR;
+
+  return DAC_SUCCESS;
+}
+
+dac63004w_status_t dac_playback_stop(dac63004w_context_t *ctx) {
+  if (!ctx) {
+    return DAC_ERROR_PARAM;
+  }
+
+  TA1CTL = MC__STOP;
+  TA1CCTL0 = 0;
+
+  if (!g_end) {
+    return DAC_SUCCESS; // Not started, or already stopped
+  }
+  if (g_active) {
+    delay_smclk_release();
+  }
+  g_active = false;
+  g_end = 0;
+
+  // Back to LDAC-synchronised updates for the rest of the driver
+  return dac_set_channel_sync(ctx, g_channel, true);
+}
+
+bool dac_playback_active(void) { return g_active; }
+
+uint16_t dac_playback_dropped(void) { return g_dropped; }
+
+void dac_playback_timing(const spi_config_t *config,
+                         dac_playback_timing_t *timing) {
+  if (!config || !timing) {
+    return;
+  }
+
+  uint16_t divider = config->clock_divider ? config->clock_divider : 1;
+
+  timing->frame_cycles = frame_cycles(divider);
+  timing->max_rate_hz = MSP_SMCLK_HZ / timing->frame_cycles;
+
+  // The timer period itself is exact. The CS edge moves with the instruction
+  // being executed at CCR0, the BRCLK phase when TXBUF is first written and
+  // the final UCBUSY poll. Time spent in other ISRs or with GIE cleared comes
+  // on top of this.
+  timing->jitter_cycles = DAC_PLAYBACK_IRQ_JITTER_CYCLES + (divider - 1) +
+                          DAC_PLAYBACK_POLL_CYCLES;
+}
+
+uint16_t dac_playback_frame_cycles(const spi_device_t *device) {
+  return frame_cycles(msp_spi_clock_divider(device));
+}
+
+// Timer1_A CCR0 interrupt: one frame per sample period
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector = TIMER1_A0_VECTOR
+__interrupt void TIMER1_A0_ISR(void)
+#elif defined(__GNUC__)
+void __attribute__((interrupt(TIMER1_A0_VECTOR))) TIMER1_A0_ISR(void)
+#else
+#error Compiler not supported!
+#endif
+{
+  const dac_frame_t *frame = g_next;
+
+  if (msp_spi_write_polled_to(g_device, frame->bytes, DAC_FRAME_SIZE) !=
+      SPI_SUCCESS) {
+    g_dropped++; // A queued or blocking transfer owns the bus
+  }
+
+  if (++frame == g_end) {
+    if (g_loop) {
+      frame = g_begin;
+    } else {
+      TA1CTL &= ~MC__UP;
+      TA1CCTL0 &= ~CCIE;
+      g_active = false;
+      delay_smclk_release();
+      __bic_SR_register_on_exit(LPM3_bits); // Let the caller notice
+    }
+  }
+  g_next = frame;
+}
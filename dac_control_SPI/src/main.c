@@ -3,13 +3,14 @@
 #include "msp_delay.h"
 #include "msp_gpio.h"
 #include "msp_spi.h"
+#include "msp_spi_eusci.h"
 #include <msp430.h>
 #include <stddef.h> /* For NULL definition */
 
 void init_spi_peripherals(void);
 
 // DAC context
-dac63004w_context_t *dac_ctx;
+static dac63004w_context_t dac_ctx;
 /**
  * @brief Main function
  */
@@ -26,14 +27,21 @@ int main(void) {
 
   init_spi_peripherals();
 
-  dac_ctx->vref = 3.3;
-  dac_ctx->mode = DAC_MODE_VOLTAGE;
+  dac_ctx.vref_mv = 3300;
+  dac_ctx.mode = DAC_MODE_VOLTAGE;
+  // SPI transfers are interrupt driven
+  __enable_interrupt();
+
   // Initialize DAC
-  dac_init(dac_ctx);
+  dac_init(&dac_ctx);
 
   while (1) {
-    dac_write_voltage(dac_ctx, 0, 2);
+    dac_write_millivolts(&dac_ctx, 0, 2000);
+
+    // Sleep in LPM0 while the ISR shifts the frames out
+    msp_spi_flush();
 
+    // Sleep in LPM3 on the ACLK timer
     delay_ms(50);
   }
 }
@@ -44,12 +52,12 @@ int main(void) {
 void init_spi_peripherals(void) {
   // Define SPI pin configuration
   spi_pin_config_t spi_pins = {
-      .mosi_port = 1,
-      .mosi_pin = 4, // P1.4 = MOSI/SDI
-      .miso_port = 1,
-      .miso_pin = 5, // P1.5 = MISO/SDO (not used but configured)
-      .sclk_port = 1,
-      .sclk_pin = 6, // P1.6 = SCLK
+      .mosi_port = SPI_DATA_PORT,
+      .mosi_pin = SPI_SIMO_PIN, // MOSI/SDI (P1.4 on eUSCI_A0)
+      .miso_port = SPI_DATA_PORT,
+      .miso_pin = SPI_SOMI_PIN, // MISO/SDO (not used but configured)
+      .sclk_port = SPI_DATA_PORT,
+      .sclk_pin = SPI_CLK_PIN,  // SCLK
       .cs_port = 1,
       .cs_pin = 7 // P1.7 = CS/SYNC
   };
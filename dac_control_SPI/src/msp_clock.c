@@ -1,14 +1,43 @@
 #include "msp_clock.h"
 #include <msp430.h>
 
+// DCO range and FLL divider for MSP_MCLK_HZ. DCOCLKDIV = 32768Hz * (FLLN + 1)
+// and DCOCLK = DCOCLKDIV * FLLD must fall inside the DCORSEL range.
+#if MSP_MCLK_HZ == 1000000UL
+#define CLOCK_DCORSEL DCORSEL_1 // DCOCLK = 2MHz
+#define CLOCK_FLLD FLLD_1
+#elif MSP_MCLK_HZ == 2000000UL
+#define CLOCK_DCORSEL DCORSEL_2 // DCOCLK = 4MHz
+#define CLOCK_FLLD FLLD_1
+#elif MSP_MCLK_HZ == 4000000UL
+#define CLOCK_DCORSEL DCORSEL_3 // DCOCLK = 8MHz
+#define CLOCK_FLLD FLLD_1
+#elif MSP_MCLK_HZ == 8000000UL
+#define CLOCK_DCORSEL DCORSEL_5 // DCOCLK = 16MHz
+#define CLOCK_FLLD FLLD_1
+#elif MSP_MCLK_HZ == 16000000UL
+#define CLOCK_DCORSEL DCORSEL_5 // DCOCLK = 16MHz
+#define CLOCK_FLLD FLLD_0
+#else
+#error MSP_MCLK_HZ must be 1, 2, 4, 8 or 16 MHz
+#endif
+
+#define CLOCK_FLLN (MSP_MCLK_HZ / 32768UL - 1)
+
+// MSP_MCLK_HZ, MSP_SMCLK_HZ and MSP_ACLK_HZ in msp_clock.h must match this
 void init_clock(void) {
+#if MSP_MCLK_HZ > 8000000UL
+  // FRAM needs a wait state above 8MHz; set it before raising the clock
+  FRCTL0 = FRCTLPW | NWAITS_1;
+#endif
+
   // Configure MSP430 clock
   __bis_SR_register(SCG0);  // Disable FLL
   CSCTL3 = SELREF__REFOCLK; // Set REFOCLK as FLL reference source
   CSCTL0 = 0;               // Clear DCO and MOD registers
   CSCTL1 &= ~(DCORSEL_7);   // Clear DCO frequency select bits first
-  CSCTL1 |= DCORSEL_3;      // Set DCOCLK = 8MHz
-  CSCTL2 = FLLD_1 + 121;    // FLLD = 1, DCODIV = DCO/2 = 4MHz
+  CSCTL1 |= CLOCK_DCORSEL;  // Set DCOCLK range
+  CSCTL2 = CLOCK_FLLD + CLOCK_FLLN; // DCODIV = MSP_MCLK_HZ
   __delay_cycles(3);
   __bic_SR_register(SCG0); // Enable FLL
   while (CSCTL7 & (FLLUNLOCK0 | FLLUNLOCK1))
@@ -16,5 +45,5 @@ void init_clock(void) {
 
   CSCTL4 = SELMS__DCOCLKDIV | SELA__REFOCLK; // Set ACLK = REFOCLK = 32768Hz,
                                              // DCOCLK as MCLK and SMCLK source
-  CSCTL5 &= ~(DIVM0 | DIVS0); // Remove division for full speed (4MHz)
+  CSCTL5 &= ~(DIVM0 | DIVS0); // Remove division for full speed (MSP_MCLK_HZ)
 }
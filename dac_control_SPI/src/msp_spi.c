@@ -3,13 +3,51 @@
  * @brief MSP430 SPI interface implementation
  */
 #include "msp_spi.h"
+#include "msp_spi_eusci.h"
 #include <msp430.h>
 #include <stddef.h> /* For NULL definition */
 
-// SPI pin configuration globals
-static uint8_t g_cs_port;
-static uint8_t g_cs_pin;
-static uint8_t g_cs_pin_mask;
+#ifdef SPI_STATIC_PINS
+#include "msp_spi_pins.h"
+#endif
+
+// Frame bodies take a constant CS path flag and must be inlined into each
+// caller so the flag folds away
+#if defined(__GNUC__)
+#define SPI_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define SPI_ALWAYS_INLINE inline
+#endif
+
+// Device set up by msp_spi_init(), used when no device handle is given
+static spi_device_t g_default_device;
+
+// Mode and divider currently programmed into the eUSCI
+static uint16_t g_bus_ctlw0;
+static uint16_t g_bus_brw;
+
+/**
+ * @brief Queued asynchronous transaction
+ */
+typedef struct {
+  const spi_device_t *device;
+  const uint8_t *tx_data;
+  uint8_t *rx_data;
+  uint16_t length;
+  spi_callback_t callback;
+  void *arg;
+  uint8_t frame[SPI_QUEUE_FRAME_SIZE]; // Inline copy of short tx frames
+} spi_transaction_t;
+
+// Asynchronous transaction queue, consumed by the eUSCI ISR
+static spi_transaction_t g_queue[SPI_QUEUE_DEPTH];
+static volatile uint8_t g_queue_head;
+static volatile uint8_t g_queue_count;
+static volatile uint16_t g_xfer_index;
+static volatile bool g_xfer_active;
+
+// Set while a blocking transfer drives the bus from the main loop
+static volatile bool g_bus_owned;
 
 // SPI mode parameters
 #define SPI_MODE_0 0x00 // CPOL=0, CPHA=0
@@ -22,92 +60,136 @@ static uint8_t g_cs_pin_mask;
 #define SPI_LSB_FIRST 1
 
 /**
- * @brief Configure GPIO for SPI operation
+ * @brief Configure a CS pin as a GPIO output, driven high (inactive)
  *
- * @param pins SPI pin configuration
+ * @param device Device whose CS fields are filled in
+ * @param port CS port (1-3)
+ * @param pin CS pin (0-7)
  * @return spi_status_t Status code
  */
-static spi_status_t configure_gpio(const spi_pin_config_t *pins) {
-  if (!pins) {
+static spi_status_t configure_cs(spi_device_t *device, uint8_t port,
+                                 uint8_t pin) {
+  if (pin > 7) {
     return SPI_ERROR_PARAM;
   }
 
-  // Store CS pin info for later use
-  g_cs_port = pins->cs_port;
-  g_cs_pin = pins->cs_pin;
-  g_cs_pin_mask = (1 << pins->cs_pin);
-
-  // Configure CS pin as GPIO output
-  switch (g_cs_port) {
+  uint8_t mask = (1 << pin);
+  switch (port) {
   case 1:
-    P1SEL0 &= ~g_cs_pin_mask;
-    P1SEL1 &= ~g_cs_pin_mask;
-    P1DIR |= g_cs_pin_mask;
-    P1OUT |= g_cs_pin_mask; // Initialize CS high (inactive)
+    P1SEL0 &= ~mask;
+    P1SEL1 &= ~mask;
+    P1OUT |= mask;
+    P1DIR |= mask;
+    device->cs_out = &P1OUT;
     break;
   case 2:
-    P2SEL0 &= ~g_cs_pin_mask;
-    P2SEL1 &= ~g_cs_pin_mask;
-    P2DIR |= g_cs_pin_mask;
-    P2OUT |= g_cs_pin_mask; // Initialize CS high (inactive)
+    P2SEL0 &= ~mask;
+    P2SEL1 &= ~mask;
+    P2OUT |= mask;
+    P2DIR |= mask;
+    device->cs_out = &P2OUT;
+    break;
+  case 3:
+    P3SEL0 &= ~mask;
+    P3SEL1 &= ~mask;
+    P3OUT |= mask;
+    P3DIR |= mask;
+    device->cs_out = &P3OUT;
     break;
   default:
     return SPI_ERROR_PARAM;
   }
 
-  // Configure SPI pins based on the port number
-  if (pins->mosi_port == 1 && pins->sclk_port == 1) {
-    // Configure P1.4 (MOSI) and P1.6 (SCK) for SPI
-    P1SEL0 |= (1 << pins->mosi_pin) | (1 << pins->sclk_pin);
-    P1SEL1 &= ~((1 << pins->mosi_pin) | (1 << pins->sclk_pin));
+  device->cs_mask = mask;
+  return SPI_SUCCESS;
+}
+
+/**
+ * @brief Configure GPIO for SPI operation
+ *
+ * @param pins SPI pin configuration
+ * @return spi_status_t Status code
+ */
+static spi_status_t configure_gpio(const spi_pin_config_t *pins) {
+  if (!pins) {
+    return SPI_ERROR_PARAM;
+  }
+
+#ifdef SPI_STATIC_PINS
+  // Pins are fixed at build time; reject a config that disagrees
+  if (pins->cs_port != SPI_CS_PORT || pins->cs_pin != SPI_CS_PIN ||
+      pins->mosi_port != SPI_DATA_PORT || pins->mosi_pin != SPI_SIMO_PIN ||
+      pins->sclk_port != SPI_DATA_PORT || pins->sclk_pin != SPI_CLK_PIN) {
+    return SPI_ERROR_PARAM;
+  }
+
+  SPI_CS_SEL0 &= ~SPI_CS_MASK;
+  SPI_CS_SEL1 &= ~SPI_CS_MASK;
+  SPI_CS_DIR |= SPI_CS_MASK;
+  SPI_CS_HIGH(); // Initialize CS high (inactive)
+
+  SPI_DATA_SEL0 |= SPI_DATA_MASK;
+  SPI_DATA_SEL1 &= ~SPI_DATA_MASK;
+
+  g_default_device.cs_out = &SPI_CS_OUT;
+  g_default_device.cs_mask = SPI_CS_MASK;
+
+  return SPI_SUCCESS;
+#else
+  // Configure CS pin as GPIO output
+  spi_status_t status =
+      configure_cs(&g_default_device, pins->cs_port, pins->cs_pin);
+  if (status != SPI_SUCCESS) {
+    return status;
+  }
+
+  // Data pins must be on the eUSCI's port (msp_spi_eusci.h)
+  if (pins->mosi_port == SPI_DATA_PORT && pins->sclk_port == SPI_DATA_PORT) {
+    // Configure MOSI and SCK for SPI
+    SPI_DATA_SEL0 |= (1 << pins->mosi_pin) | (1 << pins->sclk_pin);
+    SPI_DATA_SEL1 &= ~((1 << pins->mosi_pin) | (1 << pins->sclk_pin));
 
     // Configure MISO if needed (for full duplex)
-    if (pins->miso_port == 1) {
-      P1SEL0 |= (1 << pins->miso_pin);
-      P1SEL1 &= ~(1 << pins->miso_pin);
+    if (pins->miso_port == SPI_DATA_PORT) {
+      SPI_DATA_SEL0 |= (1 << pins->miso_pin);
+      SPI_DATA_SEL1 &= ~(1 << pins->miso_pin);
     }
   } else {
     return SPI_ERROR_PARAM;
   }
 
   return SPI_SUCCESS;
+#endif
 }
 
 /**
- * @brief Configure SPI module settings
+ * @brief Work out the eUSCI settings for a device
  *
+ * @param device Device whose bus settings are filled in
  * @param config SPI configuration options
  * @return spi_status_t Status code
  */
-static spi_status_t configure_spi(const spi_config_t *config) {
+static spi_status_t configure_device(spi_device_t *device,
+                                     const spi_config_t *config) {
   if (!config) {
     return SPI_ERROR_PARAM;
   }
 
-  // Put SPI module in reset state
-  UCA0CTLW0 = UCSWRST;
-
-  // Configure as SPI master with specified settings
-  UCA0CTLW0 |= UCMST | UCSYNC; // SPI master, synchronous mode
-
-  // Configure clock source
-  UCA0CTLW0 |= UCSSEL__SMCLK; // Use SMCLK as clock source
+  // SPI master, synchronous mode, clocked from SMCLK
+  uint16_t ctlw0 = UCMST | UCSYNC | UCSSEL__SMCLK;
 
   // Configure SPI mode (clock polarity and phase)
   switch (config->mode) {
   case SPI_MODE_0:
-    UCA0CTLW0 &= ~(UCCKPH | UCCKPL);
     break;
   case SPI_MODE_1:
-    UCA0CTLW0 |= UCCKPH;
-    UCA0CTLW0 &= ~UCCKPL;
+    ctlw0 |= UCCKPH;
     break;
   case SPI_MODE_2:
-    UCA0CTLW0 &= ~UCCKPH;
-    UCA0CTLW0 |= UCCKPL;
+    ctlw0 |= UCCKPL;
     break;
   case SPI_MODE_3:
-    UCA0CTLW0 |= (UCCKPH | UCCKPL);
+    ctlw0 |= (UCCKPH | UCCKPL);
     break;
   default:
     return SPI_ERROR_PARAM;
@@ -115,20 +197,46 @@ static spi_status_t configure_spi(const spi_config_t *config) {
 
   // Configure bit order
   if (config->bit_order == SPI_MSB_FIRST) {
-    UCA0CTLW0 |= UCMSB; // MSB first (most common)
-  } else {
-    UCA0CTLW0 &= ~UCMSB; // LSB first
+    ctlw0 |= UCMSB; // MSB first (most common)
   }
 
-  // Configure clock divider
-  UCA0BR0 = config->clock_divider;
-  UCA0BR1 = 0;
-  UCA0MCTLW = 0; // No modulation for SPI
+  device->ctlw0 = ctlw0;
+  device->brw = config->clock_divider;
+  return SPI_SUCCESS;
+}
+
+/**
+ * @brief Program the eUSCI with a device's mode and clock divider
+ *
+ * Only called while the bus is idle and every CS is high. Resetting the
+ * module also clears SPI_IE, which the transfer paths set up again.
+ */
+static void configure_spi(const spi_device_t *device) {
+  SPI_CTLW0 = device->ctlw0 | UCSWRST;
+  SPI_BRW = device->brw;
+#ifdef SPI_MCTLW
+  SPI_MCTLW = 0; // No modulation for SPI
+#endif
+  SPI_CTLW0 &= ~UCSWRST;
+
+  g_bus_ctlw0 = device->ctlw0;
+  g_bus_brw = device->brw;
+}
 
-  // Enable SPI
-  UCA0CTLW0 &= ~UCSWRST;
+/**
+ * @brief Switch the bus over to a device if its settings differ
+ */
+static inline void spi_select(const spi_device_t *device) {
+  if (device->ctlw0 != g_bus_ctlw0 || device->brw != g_bus_brw) {
+    configure_spi(device);
+  }
+}
 
-  return SPI_SUCCESS;
+/**
+ * @brief Map a NULL device handle to the msp_spi_init() device
+ */
+static inline const spi_device_t *spi_device(const spi_device_t *device) {
+  return device ? device : &g_default_device;
 }
 
 /**
@@ -147,53 +255,146 @@ spi_status_t msp_spi_init(const spi_pin_config_t *pins,
   }
 
   // Configure SPI module
-  status = configure_spi(config);
+  status = configure_device(&g_default_device, config);
   if (status != SPI_SUCCESS) {
     return status;
   }
+  configure_spi(&g_default_device);
 
   return SPI_SUCCESS;
 }
 
+spi_status_t msp_spi_device_init(spi_device_t *device, uint8_t cs_port,
+                                 uint8_t cs_pin, const spi_config_t *config) {
+  if (!device || !config) {
+    return SPI_ERROR_PARAM;
+  }
+
+  spi_status_t status = configure_device(device, config);
+  if (status != SPI_SUCCESS) {
+    return status;
+  }
+
+  return configure_cs(device, cs_port, cs_pin);
+}
+
+spi_status_t msp_spi_group_init(spi_device_t *group,
+                                const spi_device_t *const *devices,
+                                uint8_t count) {
+  if (!group || !devices || count == 0) {
+    return SPI_ERROR_PARAM;
+  }
+
+  // One CS write can only reach pins on a single port
+  const spi_device_t *first = spi_device(devices[0]);
+  uint8_t mask = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    const spi_device_t *device = spi_device(devices[i]);
+    if (device->cs_out != first->cs_out || device->ctlw0 != first->ctlw0 ||
+        device->brw != first->brw) {
+      return SPI_ERROR_PARAM;
+    }
+    mask |= device->cs_mask;
+  }
+
+  *group = *first;
+  group->cs_mask = mask;
+  return SPI_SUCCESS;
+}
+
 /**
- * @brief Assert (lower) the CS pin
+ * @brief Check whether a frame takes the build-time CS pin path
+ *
+ * True for the msp_spi_init() device in SPI_STATIC_PINS builds. Callers
+ * decide once per frame and pass the result on as a constant.
  */
-void msp_spi_cs_assert(void) {
-  // Lower CS pin to activate device
-  switch (g_cs_port) {
-  case 1:
-    P1OUT &= ~g_cs_pin_mask;
-    break;
-  case 2:
-    P2OUT &= ~g_cs_pin_mask;
-    break;
+static inline bool spi_cs_fixed(const spi_device_t *device) {
+#ifdef SPI_STATIC_PINS
+  return !device || device == &g_default_device;
+#else
+  (void)device;
+  return false;
+#endif
+}
+
+/**
+ * @brief Drive a device's CS low without any settling delay
+ *
+ * @param fixed Constant from spi_cs_fixed(): the edge is a single BIC.B on
+ *              the build-time pin, otherwise it goes through the handle
+ */
+static SPI_ALWAYS_INLINE void cs_low(const spi_device_t *device,
+                                     const bool fixed) {
+#ifdef SPI_STATIC_PINS
+  if (fixed) {
+    SPI_CS_LOW();
+    return;
   }
+#else
+  (void)fixed;
+#endif
+  *device->cs_out &= ~device->cs_mask;
+}
+
+/**
+ * @brief Drive a device's CS high without any settling delay
+ *
+ * @param fixed Constant from spi_cs_fixed(), see cs_low()
+ */
+static SPI_ALWAYS_INLINE void cs_high(const spi_device_t *device,
+                                      const bool fixed) {
+#ifdef SPI_STATIC_PINS
+  if (fixed) {
+    SPI_CS_HIGH();
+    return;
+  }
+#else
+  (void)fixed;
+#endif
+  *device->cs_out |= device->cs_mask;
+}
+
+/**
+ * @brief Lower CS and let it settle before the first clock edge
+ */
+static SPI_ALWAYS_INLINE void cs_assert(const spi_device_t *device,
+                                        const bool fixed) {
+  // Lower CS pin to activate device
+  cs_low(device, fixed);
 
   // Small delay to ensure CS is stable
   __delay_cycles(10);
 }
 
 /**
- * @brief Deassert (raise) the CS pin
+ * @brief Raise CS with settling time around the edge
  */
-void msp_spi_cs_deassert(void) {
+static SPI_ALWAYS_INLINE void cs_deassert(const spi_device_t *device,
+                                          const bool fixed) {
   // Small delay to ensure last transfer is complete
   __delay_cycles(10);
 
   // Raise CS pin to deactivate device
-  switch (g_cs_port) {
-  case 1:
-    P1OUT |= g_cs_pin_mask;
-    break;
-  case 2:
-    P2OUT |= g_cs_pin_mask;
-    break;
-  }
+  cs_high(device, fixed);
 
   // Small delay after CS change
   __delay_cycles(10);
 }
 
+/**
+ * @brief Assert (lower) the CS pin
+ */
+void msp_spi_cs_assert(void) {
+  cs_assert(&g_default_device, spi_cs_fixed(NULL));
+}
+
+/**
+ * @brief Deassert (raise) the CS pin
+ */
+void msp_spi_cs_deassert(void) {
+  cs_deassert(&g_default_device, spi_cs_fixed(NULL));
+}
+
 /**
  * @brief Send a single byte over SPI
  *
@@ -201,12 +402,54 @@ void msp_spi_cs_deassert(void) {
  * @return uint8_t Received byte (if applicable)
  */
 uint8_t msp_spi_transfer_byte(uint8_t data) {
-  while (!(UCA0IFG & UCTXIFG))
+  while (!(SPI_IFG & UCTXIFG))
     ;               // Wait for TX buffer to be ready
-  UCA0TXBUF = data; // Send byte
-  while (!(UCA0IFG & UCRXIFG))
+  SPI_TXBUF = data; // Send byte
+  while (!(SPI_IFG & UCRXIFG))
     ;               // Wait for RX to complete
-  return UCA0RXBUF; // Return received byte
+  return SPI_RXBUF; // Return received byte
+}
+
+/**
+ * @brief Sleep in LPM0 until the queue is idle; call with GIE cleared
+ */
+static void spi_wait_idle(void) {
+  while (g_xfer_active) {
+    // GIE and CPUOFF are set atomically, so the ISR cannot drain the queue
+    // between the check and the sleep. It clears CPUOFF once the queue is idle.
+    __bis_SR_register(LPM0_bits | GIE);
+    __disable_interrupt();
+  }
+}
+
+/**
+ * @brief Take the bus for a blocking transfer once the queue has drained
+ *
+ * Until spi_release(), polled writes from timer ISRs back off and frames
+ * submitted from ISRs stay queued, so nothing can add a CS edge or bytes
+ * to the transfer or consume its RXIFG.
+ */
+static void spi_claim(void) {
+  uint16_t state = __get_interrupt_state();
+  __disable_interrupt();
+  spi_wait_idle();
+  g_bus_owned = true;
+  __set_interrupt_state(state);
+}
+
+static void spi_start_transaction(void);
+
+/**
+ * @brief Hand the bus back and start any frame queued meanwhile
+ */
+static void spi_release(void) {
+  uint16_t state = __get_interrupt_state();
+  __disable_interrupt();
+  g_bus_owned = false;
+  if (!g_xfer_active && g_queue_count) {
+    spi_start_transaction();
+  }
+  __set_interrupt_state(state);
 }
 
 /**
@@ -219,12 +462,21 @@ uint8_t msp_spi_transfer_byte(uint8_t data) {
  */
 spi_status_t msp_spi_transfer(const uint8_t *tx_data, uint8_t *rx_data,
                               uint16_t length) {
-  if (!tx_data || length == 0) {
-    return SPI_ERROR_PARAM;
-  }
+  return msp_spi_transfer_to(NULL, tx_data, rx_data, length);
+}
+
+/**
+ * @brief Clock one CS-framed transfer out, busy-waiting per byte
+ */
+static SPI_ALWAYS_INLINE void spi_transfer_frame(const spi_device_t *device,
+                                                 const bool fixed,
+                                                 const uint8_t *tx_data,
+                                                 uint8_t *rx_data,
+                                                 uint16_t length) {
+  spi_select(device);
 
   // Assert CS
-  msp_spi_cs_assert();
+  cs_assert(device, fixed);
 
   // Transfer each byte
   for (uint16_t i = 0; i < length; i++) {
@@ -237,19 +489,267 @@ spi_status_t msp_spi_transfer(const uint8_t *tx_data, uint8_t *rx_data,
   }
 
   // Deassert CS
-  msp_spi_cs_deassert();
+  cs_deassert(device, fixed);
+}
+
+spi_status_t msp_spi_transfer_to(const spi_device_t *device,
+                                 const uint8_t *tx_data, uint8_t *rx_data,
+                                 uint16_t length) {
+  if (!tx_data || length == 0) {
+    return SPI_ERROR_PARAM;
+  }
+
+  // Never interleave with frames still owned by the ISR, and keep ISRs off
+  // the bus until CS is back up
+  spi_claim();
+
+  // Pick the CS path once; each branch has its edges compiled in
+  if (spi_cs_fixed(device)) {
+    spi_transfer_frame(&g_default_device, true, tx_data, rx_data, length);
+  } else {
+    spi_transfer_frame(spi_device(device), false, tx_data, rx_data, length);
+  }
+
+  spi_release();
+  return SPI_SUCCESS;
+}
+
+/**
+ * @brief Start the transaction at the head of the queue
+ *
+ * Called with interrupts disabled or from the ISR. The first byte is written
+ * here; every following byte is written by the ISR once the previous one has
+ * been shifted in, so CS is never released before the last bit is out.
+ */
+static void spi_start_transaction(void) {
+  const spi_transaction_t *t = &g_queue[g_queue_head];
+
+  g_xfer_index = 0;
+  g_xfer_active = true;
+
+  // Queued frames always go through the handle, so the ISR never has to
+  // pick a CS path
+  spi_select(t->device);
+  cs_low(t->device, false);
+  SPI_IFG &= ~UCRXIFG; // Drop any stale byte from a blocking transfer
+  SPI_IE |= UCRXIE;
+  SPI_TXBUF = t->tx_data[0];
+}
+
+/**
+ * @brief Queue a CS-framed transfer to be clocked out by the eUSCI ISR
+ *
+ * @param tx_data Transmit buffer
+ * @param rx_data Receive buffer (can be NULL for write-only)
+ * @param length Number of bytes to transfer
+ * @param callback Completion callback (can be NULL)
+ * @param arg Argument passed to the callback
+ * @return spi_status_t SPI_ERROR_BUSY if the queue is full
+ */
+spi_status_t msp_spi_submit(const uint8_t *tx_data, uint8_t *rx_data,
+                            uint16_t length, spi_callback_t callback,
+                            void *arg) {
+  return msp_spi_submit_to(NULL, tx_data, rx_data, length, callback, arg);
+}
+
+spi_status_t msp_spi_submit_to(const spi_device_t *device,
+                               const uint8_t *tx_data, uint8_t *rx_data,
+                               uint16_t length, spi_callback_t callback,
+                               void *arg) {
+  if (!tx_data || length == 0) {
+    return SPI_ERROR_PARAM;
+  }
+
+  uint16_t state = __get_interrupt_state();
+  __disable_interrupt();
+
+  if (g_queue_count >= SPI_QUEUE_DEPTH) {
+    __set_interrupt_state(state);
+    return SPI_ERROR_BUSY;
+  }
+
+  uint8_t slot = g_queue_head + g_queue_count;
+  if (slot >= SPI_QUEUE_DEPTH) {
+    slot -= SPI_QUEUE_DEPTH;
+  }
+
+  spi_transaction_t *t = &g_queue[slot];
+  if (length <= SPI_QUEUE_FRAME_SIZE) {
+    for (uint16_t i = 0; i < length; i++) {
+      t->frame[i] = tx_data[i];
+    }
+    t->tx_data = t->frame;
+  } else {
+    t->tx_data = tx_data;
+  }
+  t->device = spi_device(device);
+  t->rx_data = rx_data;
+  t->length = length;
+  t->callback = callback;
+  t->arg = arg;
+  g_queue_count++;
+
+  // Kick the ISR if the bus is idle; a blocking transfer starts it on release
+  if (!g_xfer_active && !g_bus_owned) {
+    spi_start_transaction();
+  }
 
+  __set_interrupt_state(state);
   return SPI_SUCCESS;
 }
 
+/**
+ * @brief Check whether queued transfers are still in progress
+ *
+ * @return true while the queue is not empty
+ */
+bool msp_spi_busy(void) { return g_xfer_active; }
+
+/**
+ * @brief Sleep in LPM0 until every queued transfer has completed
+ */
+void msp_spi_flush(void) {
+  uint16_t state = __get_interrupt_state();
+  __disable_interrupt();
+  spi_wait_idle();
+  __set_interrupt_state(state);
+}
+
+/**
+ * @brief Clock one write-only frame out back to back, polling TXIFG
+ */
+static SPI_ALWAYS_INLINE void spi_write_polled_frame(const spi_device_t *device,
+                                                     const bool fixed,
+                                                     const uint8_t *tx_data,
+                                                     uint16_t length) {
+  spi_select(device);
+
+  cs_low(device, fixed);
+  for (uint16_t i = 0; i < length; i++) {
+    while (!(SPI_IFG & UCTXIFG))
+      ; // TXBUF is double buffered, so the stream stays gap free
+    SPI_TXBUF = tx_data[i];
+  }
+  while (SPI_STATW & UCBUSY)
+    ; // Wait for the last bit to leave the shift register
+  cs_high(device, fixed);
+
+  // Discard the received bytes; this also clears UCRXIFG and UCOE
+  (void)SPI_RXBUF;
+}
+
+/**
+ * @brief Shift a write-only frame out immediately by polling
+ *
+ * @param tx_data Transmit buffer
+ * @param length Number of bytes to transfer
+ * @return spi_status_t Status code
+ */
+spi_status_t msp_spi_write_polled(const uint8_t *tx_data, uint16_t length) {
+  return msp_spi_write_polled_to(NULL, tx_data, length);
+}
+
+spi_status_t msp_spi_write_polled_to(const spi_device_t *device,
+                                     const uint8_t *tx_data, uint16_t length) {
+  if (!tx_data || length == 0) {
+    return SPI_ERROR_PARAM;
+  }
+
+  // A queued frame or a blocking transfer in the interrupted code owns the
+  // bus; joining in would corrupt its frame
+  if (g_xfer_active || g_bus_owned) {
+    return SPI_ERROR_BUSY;
+  }
+
+  // Pick the CS path once; each branch has its edges compiled in
+  if (spi_cs_fixed(device)) {
+    spi_write_polled_frame(&g_default_device, true, tx_data, length);
+  } else {
+    spi_write_polled_frame(spi_device(device), false, tx_data, length);
+  }
+
+  return SPI_SUCCESS;
+}
+
+uint16_t msp_spi_clock_divider(const spi_device_t *device) {
+  uint16_t brw = spi_device(device)->brw;
+  return brw ? brw : 1;
+}
+
 /**
  * @brief Deinitialize SPI hardware
  *
  * @return spi_status_t Status code
  */
 spi_status_t msp_spi_deinit(void) {
+  // Let queued frames finish before the module is reset
+  msp_spi_flush();
+
   // Put SPI in reset state
-  UCA0CTLW0 = UCSWRST;
+  SPI_IE &= ~(UCRXIE | UCTXIE);
+  SPI_CTLW0 = UCSWRST;
+  g_bus_ctlw0 = 0; // Force a full setup on the next transfer
 
   return SPI_SUCCESS;
 }
+
+// eUSCI interrupt handler: shifts queued frames out one byte per RX flag
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector = SPI_VECTOR
+__interrupt void SPI_ISR(void)
+#elif defined(__GNUC__)
+void __attribute__((interrupt(SPI_VECTOR))) SPI_ISR(void)
+#else
+#error Compiler not supported!
+#endif
+{
+  switch (__even_in_range(SPI_IV, USCI_SPI_UCTXIFG)) {
+  case USCI_NONE:
+    break;
+  case USCI_SPI_UCRXIFG: {
+    spi_transaction_t *t = &g_queue[g_queue_head];
+    uint16_t index = g_xfer_index;
+    uint8_t rx_byte = SPI_RXBUF; // Reading RXBUF clears UCRXIFG
+
+    if (t->rx_data) {
+      t->rx_data[index] = rx_byte;
+    }
+
+    if (++index < t->length) {
+      g_xfer_index = index;
+      SPI_TXBUF = t->tx_data[index];
+      break;
+    }
+
+    // Last byte is in, release the device and retire the transaction
+    cs_high(t->device, false);
+    SPI_IE &= ~UCRXIE;
+
+    spi_callback_t callback = t->callback;
+    void *arg = t->arg;
+    if (++g_queue_head >= SPI_QUEUE_DEPTH) {
+      g_queue_head = 0;
+    }
+    g_queue_count--;
+    g_xfer_active = false;
+
+    if (callback) {
+      callback(SPI_SUCCESS, arg);
+    }
+
+    // The callback may already have started a new transaction
+    if (!g_xfer_active) {
+      if (g_queue_count) {
+        spi_start_transaction();
+      } else {
+        __bic_SR_register_on_exit(LPM0_bits); // Wake msp_spi_flush()
+      }
+    }
+    break;
+  }
+  case USCI_SPI_UCTXIFG:
+    break;
+  default:
+    break;
+  }
+}
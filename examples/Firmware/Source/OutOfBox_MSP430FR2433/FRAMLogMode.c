@@ -43,6 +43,9 @@
 
 #include "FRAMLogMode.h"
 
+// Samples of one decoded NVS delta block
+static int16_t samples[NVS_DELTA_BLOCK_SAMPLES];
+
 void framLog()
 {
     _q8 DegC;          // Q variables using global type
@@ -61,21 +64,27 @@ void framLog()
 
             buttonS1Pressed = false;
 
-            // Transmit JSON formatted string
-            int i = 0;
-            int length = nvs_ring_entries(nvsHandle);
+            // Transmit JSON formatted string, decoding one block at a time
+            uint16_t blocks = nvs_delta_blocks(nvsHandle);
+            uint16_t count;
+            bool first = true;
             transmitString("{\"framTempData\":[");
-            for (i = 0; i < length; i++)
+            for (uint16_t block = 0; block < blocks; block++)
             {
-                adc_data_t data;
-                nvs_ring_retrieve(nvsHandle, &data, i);
-
-                DegC = _Q8(((int16_t)(data.value - CALADC_15V_30C)) * (85.0f-30.0f) / (CALADC_15V_85C - CALADC_15V_30C) + 30.0f);
-                char str[MAX_STRBUF_SIZE];
-                _Q8toa(str, "%2.2f", DegC);
-                transmitString(str);
-                if (i < length-1)
-                    transmitString(", ");
+                // Skip a block that fails its CRC check
+                if (nvs_delta_retrieve_block(nvsHandle, block, samples, &count) != NVS_OK)
+                    continue;
+
+                for (uint16_t i = 0; i < count; i++)
+                {
+                    DegC = _Q8(((int16_t)(samples[i] - CALADC_15V_30C)) * (85.0f-30.0f) / (CALADC_15V_85C - CALADC_15V_30C) + 30.0f);
+                    char str[MAX_STRBUF_SIZE];
+                    _Q8toa(str, "%2.2f", DegC);
+                    if (!first)
+                        transmitString(", ");
+                    transmitString(str);
+                    first = false;
+                }
             }
             transmitString("]}");
             while (EUSCI_A_UART_queryStatusFlags(EUSCI_A0_BASE, EUSCI_A_UART_BUSY));
@@ -84,7 +93,7 @@ void framLog()
         if (buttonS2Pressed)
         {
             buttonS2Pressed = false;
-            nvs_ring_reset(nvsHandle);
+            nvs_delta_reset(nvsHandle);
         }
         if (rtcWakeup)
         {
@@ -99,8 +108,8 @@ void framLog()
 
             __bis_SR_register(LPM3_bits | GIE);
 
-            // Add adc_data to ring storage
-            status = nvs_ring_add(nvsHandle, &adc_data);
+            // Add adc_data to delta storage
+            status = nvs_delta_add(nvsHandle, adc_data.value);
 
             /*
              * Status should never be not NVS_OK but if it happens trap execution.
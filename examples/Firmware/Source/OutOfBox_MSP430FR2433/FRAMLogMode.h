@@ -56,9 +56,12 @@
 // Appliation mode
 extern char mode;
 
-// Size of NVS ring storage
+// Size of NVS storage, in entries of a ring holding one adc_data_t each
 #define NVS_RING_SIZE      100
 
+// Number of NVS delta blocks in the same storage
+#define NVS_DELTA_SIZE     NVS_DELTA_BLOCKS(NVS_RING_STORAGE_SIZE(sizeof(adc_data_t), NVS_RING_SIZE))
+
 // Define structure to hold timestamp and ADC samples
 typedef struct adc_data_t {
     int16_t value;
@@ -67,8 +70,8 @@ typedef struct adc_data_t {
 // ADC data
 extern adc_data_t adc_data;
 
-// NVS ring handle
-extern nvs_ring_handle nvsHandle;
+// NVS delta handle
+extern nvs_delta_handle nvsHandle;
 
 //extern uint8_t nvsStorage[NVS_RING_STORAGE_SIZE(sizeof(adc_data_t), NVS_RING_SIZE)];
 
@@ -0,0 +1,199 @@
+/**
+ * @file nvs_delta_bench.c
+ * @brief History kept by the delta container in the FRAMLogMode storage
+ *
+ * Feeds ../nvs/nvs_delta.c sample streams that are long enough to wrap it,
+ * using the bytes FRAMLogMode reserves for NVS_RING_SIZE entries of a ring,
+ * and reports how many samples it then holds against the ring's 100. Every
+ * block is decoded and compared with the newest input samples, and power
+ * losses during an add are replayed to check recovery, so the program also
+ * fails if compression or recovery is wrong.
+ *
+ * Signals:
+ *   temperature  slow drift with +/-1 code noise, as the internal sensor
+ *   noisy        the same with +/-8 code noise
+ *   steps        flat with a jump of up to +/-512 codes every 20 samples
+ *   random       uniform over the full 16-bit range, the worst case
+ *
+ * Usage: nvs_delta_bench [--no-header]
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nvs.h"
+
+// FRAMLogMode storage: NVS_RING_SIZE entries of adc_data_t
+#define NVS_BENCH_RING_SIZE 100
+#define NVS_BENCH_STORAGE NVS_RING_STORAGE_SIZE(sizeof(int16_t), NVS_BENCH_RING_SIZE)
+#define NVS_BENCH_LENGTH NVS_DELTA_BLOCKS(NVS_BENCH_STORAGE)
+
+// Samples fed per signal, enough to wrap the container several times
+#define NVS_BENCH_SAMPLES 6000
+
+typedef enum {
+    SIGNAL_TEMPERATURE,
+    SIGNAL_NOISY,
+    SIGNAL_STEPS,
+    SIGNAL_RANDOM,
+    SIGNAL_COUNT
+} signal_t;
+
+static const char *const k_signal_names[SIGNAL_COUNT] = {
+    "temperature", "noisy", "steps", "random"};
+
+static uint8_t g_storage[NVS_BENCH_STORAGE];
+static int16_t g_input[NVS_BENCH_SAMPLES];
+static uint32_t g_seed;
+static int g_failures;
+
+static uint32_t lcg(void)
+{
+    g_seed = g_seed*1664525u + 1013904223u;
+    return g_seed >> 8;
+}
+
+static int16_t noise(int16_t amplitude)
+{
+    return (int16_t)((int32_t)(lcg() % (2u*amplitude + 1)) - amplitude);
+}
+
+static void make_signal(signal_t signal)
+{
+    int32_t level = 750;
+
+    g_seed = 12345;
+    for (int i = 0; i < NVS_BENCH_SAMPLES; i++) {
+        switch (signal) {
+        case SIGNAL_TEMPERATURE:
+            // One code of drift every 50 samples on average
+            level += ((lcg() % 100) == 0) - ((lcg() % 100) == 0);
+            g_input[i] = (int16_t)(level + noise(1));
+            break;
+        case SIGNAL_NOISY:
+            level += ((lcg() % 100) == 0) - ((lcg() % 100) == 0);
+            g_input[i] = (int16_t)(level + noise(8));
+            break;
+        case SIGNAL_STEPS:
+            if ((i % 20) == 0) {
+                level += noise(512);
+            }
+            g_input[i] = (int16_t)level;
+            break;
+        default:
+            g_input[i] = (int16_t)lcg();
+            break;
+        }
+    }
+}
+
+/*
+ * Check the container holds exactly the newest samples of g_input[0, fed).
+ * Returns the number of samples held.
+ */
+static uint32_t check_history(nvs_delta_handle handle, uint32_t fed, const char *what)
+{
+    int16_t samples[NVS_DELTA_BLOCK_SAMPLES];
+    uint16_t count;
+    uint32_t entries = nvs_delta_entries(handle);
+    uint32_t next = fed - entries;
+
+    if (entries > fed) {
+        printf("# %s: %lu samples after %lu added\n", what, (unsigned long)entries, (unsigned long)fed);
+        g_failures++;
+        return 0;
+    }
+    for (uint16_t block = 0; block < nvs_delta_blocks(handle); block++) {
+        if (nvs_delta_retrieve_block(handle, block, samples, &count) != NVS_OK) {
+            printf("# %s: block %u not valid\n", what, block);
+            g_failures++;
+            return entries;
+        }
+        for (uint16_t i = 0; i < count; i++) {
+            if (samples[i] != g_input[next++]) {
+                printf("# %s: block %u sample %u wrong\n", what, block, i);
+                g_failures++;
+                return entries;
+            }
+        }
+    }
+    if (next != fed) {
+        printf("# %s: blocks hold %lu samples, count says %lu\n", what,
+               (unsigned long)(next - (fed - entries)), (unsigned long)entries);
+        g_failures++;
+    }
+    return entries;
+}
+
+/*
+ * Replay a power loss during the add of sample fed: the state it committed
+ * is torn, or the block header it copied afterwards is. Recovery must give
+ * the container before or after that add.
+ */
+static void check_power_loss(nvs_delta_handle handle, uint32_t fed)
+{
+    static uint8_t before[NVS_BENCH_STORAGE];
+    nvs_delta_header *header = (nvs_delta_header *)handle;
+    nvs_delta_block *blocks = (nvs_delta_block *)(header + 1);
+    nvs_delta_state *newest;
+
+    memcpy(before, g_storage, sizeof(g_storage));
+
+    // Torn state commit: back to before the add
+    nvs_delta_add(handle, g_input[fed]);
+    newest = &header->state[(int16_t)(header->state[1].seq - header->state[0].seq) > 0];
+    newest->value ^= 0x5a5a;
+    handle = nvs_delta_init(g_storage, NVS_BENCH_LENGTH);
+    check_history(handle, fed, "torn-state");
+    memcpy(g_storage, before, sizeof(g_storage));
+
+    // Torn open block header: the add is kept
+    nvs_delta_add(handle, g_input[fed]);
+    newest = &header->state[(int16_t)(header->state[1].seq - header->state[0].seq) > 0];
+    blocks[newest->last].count ^= 0x55;
+    blocks[newest->last].crc ^= 0x5a5a;
+    handle = nvs_delta_init(g_storage, NVS_BENCH_LENGTH);
+    check_history(handle, fed + 1, "torn-block");
+    memcpy(g_storage, before, sizeof(g_storage));
+}
+
+int main(int argc, char **argv)
+{
+    bool header = !(argc > 1 && strcmp(argv[1], "--no-header") == 0);
+    nvs_delta_handle handle;
+    uint32_t entries;
+
+    if (header) {
+        printf("signal,storage_bytes,blocks,samples,ring_samples,gain_percent,bits_per_sample\n");
+    }
+    for (signal_t signal = 0; signal < SIGNAL_COUNT; signal++) {
+        make_signal(signal);
+        g_storage[0] = 0;
+        handle = nvs_delta_init(g_storage, NVS_BENCH_LENGTH);
+        for (uint32_t i = 0; i < NVS_BENCH_SAMPLES; i++) {
+            if ((i % 997) == 500) {
+                check_power_loss(handle, i);
+            }
+            nvs_delta_add(handle, g_input[i]);
+        }
+
+        entries = check_history(handle, NVS_BENCH_SAMPLES, k_signal_names[signal]);
+        printf("%s,%u,%u,%lu,%u,%lu,%.2f\n", k_signal_names[signal],
+               (unsigned)NVS_BENCH_STORAGE, (unsigned)NVS_BENCH_LENGTH, (unsigned long)entries,
+               NVS_BENCH_RING_SIZE, (unsigned long)(entries*100/NVS_BENCH_RING_SIZE),
+               entries ? 8.0*NVS_BENCH_STORAGE/entries : 0.0);
+    }
+
+    // A reset container is empty and takes new samples
+    nvs_delta_reset(handle);
+    if (nvs_delta_entries(handle) || nvs_delta_blocks(handle)) {
+        printf("# reset: not empty\n");
+        g_failures++;
+    }
+    nvs_delta_add(handle, g_input[0]);
+    check_history(handle, 1, "reset");
+
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,537 @@
+/**
+ * @file nvs_ring_bench.c
+ * @brief Boot-time recovery cost of nvs_ring_init()
+ *
+ * Runs ../nvs/nvs_ring.c on the host against rings of 100, 1000 and 4000
+ * entries that have wrapped, and counts the CRC work nvs_ring_init() does
+ * on the next boot: after a clean shutdown, after a power loss that tore
+ * the last state commit, and after one that missed the working copy of
+ * first/last. The version 1 recovery (a copy of the original scan, kept
+ * here as the baseline) is measured for a clean boot and for an entry
+ * whose CRC was not written yet.
+ *
+ * nvs_support.c runs against the CRC16 module model in sim/crc16.c, which
+ * counts register accesses. The cycle column assumes NVS_BENCH_CALL_CYCLES
+ * per CRC call and NVS_BENCH_WRITE_CYCLES per CRCDI or CRCDI_L write; only
+ * the CRC work is estimated, which is what grows with the ring. The crc
+ * rows show the cost of one buffer of the given size, word aligned or not,
+ * and the buffer CRCs are checked against a bytewise reference first.
+ *
+ * The second CSV block reports appends with nvs_ring_add(), and with
+ * nvs_ring_add_batch() and nvs_log_add_batch() in batches of 1, 8 and 32,
+ * as entries per second at NVS_BENCH_MCLK_HZ. Besides the CRC work the
+ * estimate charges NVS_BENCH_WINDOW_CYCLES per FRAM unlock/lock window,
+ * NVS_BENCH_ENTRY_CYCLES per entry and NVS_BENCH_CALL_CYCLES per call.
+ * irq_off_cycles is the longest window with interrupts disabled.
+ *
+ * After every v2 recovery all entries are read
+ * back with nvs_ring_retrieve(), a cursor and nvs_ring_retrieve_range() and
+ * checked, so the program also fails if recovery or retrieval is wrong.
+ *
+ * Usage: nvs_ring_bench [--no-header]
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <msp430.h>
+
+#include "nvs.h"
+#include "nvs_support.h"
+
+// Size of adc_data_t in FRAMLogMode
+#ifndef NVS_BENCH_SIZE
+#define NVS_BENCH_SIZE 2
+#endif
+
+#define NVS_BENCH_CALL_CYCLES 30
+#define NVS_BENCH_WRITE_CYCLES 6
+#define NVS_BENCH_WINDOW_CYCLES 25
+#define NVS_BENCH_ENTRY_CYCLES 40
+
+// MCLK of the out-of-box demo
+#define NVS_BENCH_MCLK_HZ 16000000UL
+
+// Entries appended per throughput row, a multiple of every batch size
+#define NVS_BENCH_APPENDS 960
+
+// Every CRC call saves, seeds, reads and restores CRCINIRES
+#define NVS_BENCH_RESULT_ACCESS 4
+
+static int g_failures;
+static uint32_t g_windows;
+static uint32_t g_window_max;
+
+/*
+ * Bytewise CRC-CCITT, as the CRC16 module computes it.
+ */
+static uint16_t reference_crc(uint16_t crc, const uint8_t *data, uint16_t size)
+{
+    while (size--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/*
+ * Version 1 layout and recovery scan, as in nvs_ring_init() before the
+ * journaled header. Returns the recovered first index (0xffff if empty).
+ */
+typedef struct {
+    uint16_t token;
+    uint16_t first;
+    uint16_t last;
+    uint16_t size;
+    uint16_t length;
+} v1_header;
+
+static uint16_t __v1_increment(uint16_t index, uint16_t length)
+{
+    return (index + 1 >= length) ? 0 : index + 1;
+}
+
+static uint16_t v1_recover(uint8_t *storage, uint16_t size, uint16_t length)
+{
+    v1_header *header = (v1_header *)storage;
+    uint16_t *crcTable = (uint16_t *)(storage + sizeof(v1_header));
+    uint8_t *dataStorage = (uint8_t *)(crcTable + length);
+    uint8_t *dataPtr;
+    uint16_t first = header->first;
+    uint16_t last = header->last;
+    uint16_t next;
+
+    // Fast check of first, last and next
+    if ((first < length) && (last < length)) {
+        next = __v1_increment(last, length);
+        if ((crcTable[first] == nvs_crc(dataStorage + size*first, size)) &&
+            (crcTable[last] == nvs_crc(dataStorage + size*last, size)) &&
+            ((next == first) || (crcTable[next] == 0))) {
+            return first;
+        }
+    }
+
+    // Scan from both ends
+    if (nvs_crc(dataStorage, size) == crcTable[0]) {
+        last = 1;
+        dataPtr = dataStorage + size;
+        while ((last < length) && (nvs_crc(dataPtr, size) == crcTable[last])) {
+            last++;
+            dataPtr += size;
+        }
+        last--;
+        first = length - 1;
+        dataPtr = dataStorage + size*(length - 1);
+        while ((first > last) && (nvs_crc(dataPtr, size) == crcTable[first])) {
+            first--;
+            dataPtr -= size;
+        }
+        first++;
+    }
+    else {
+        first = 1;
+        dataPtr = dataStorage + size;
+        while ((first < length) && (nvs_crc(dataPtr, size) != crcTable[first])) {
+            first++;
+            dataPtr += size;
+        }
+        if (first == length) {
+            return 0xffff;
+        }
+    }
+    return first;
+}
+
+/*
+ * Fill a v1 ring the way the original nvs_ring_add() did, wrapping it.
+ */
+static void v1_fill(uint8_t *storage, uint16_t size, uint16_t length, uint32_t adds)
+{
+    v1_header *header = (v1_header *)storage;
+    uint16_t *crcTable = (uint16_t *)(storage + sizeof(v1_header));
+    uint8_t *dataStorage = (uint8_t *)(crcTable + length);
+    uint8_t entry[NVS_BENCH_SIZE];
+    uint16_t next;
+
+    memset(storage, 0, sizeof(v1_header) + length*(sizeof(uint16_t) + size));
+    header->token = NVS_RING_TOKEN_V1;
+    header->first = 0xffff;
+    header->last = 0xffff;
+    header->size = size;
+    header->length = length;
+    for (uint32_t i = 0; i < adds; i++) {
+        memset(entry, (int)(i & 0xff), size);
+        entry[0] = (uint8_t)(i >> 8);
+        next = __v1_increment(header->last == 0xffff ? length - 1 : header->last, length);
+        if (next == header->first) {
+            crcTable[next] = 0;
+            header->first = __v1_increment(next, length);
+        }
+        memcpy(dataStorage + size*next, entry, size);
+        crcTable[next] = nvs_crc(entry, size);
+        header->last = next;
+        if (header->first == 0xffff) {
+            header->first = next;
+        }
+    }
+}
+
+static void make_entry(uint8_t *entry, uint32_t i)
+{
+    memset(entry, (int)(i & 0xff), NVS_BENCH_SIZE);
+    entry[0] = (uint8_t)(i >> 8);
+}
+
+typedef struct {
+    uint32_t next;
+    bool ok;
+} range_check;
+
+static void check_range_entry(const void *data, nvs_status status, void *context)
+{
+    range_check *check = context;
+    uint8_t expect[NVS_BENCH_SIZE];
+
+    make_entry(expect, check->next++);
+    if ((status != NVS_OK) || memcmp(data, expect, NVS_BENCH_SIZE)) {
+        check->ok = false;
+    }
+}
+
+/*
+ * Check a v2 ring holds the entries added as numbers [oldest, newest].
+ */
+static void check_ring(nvs_ring_handle handle, uint32_t oldest, uint32_t newest, const char *scenario)
+{
+    uint8_t entry[NVS_BENCH_SIZE];
+    uint8_t expect[NVS_BENCH_SIZE];
+    uint16_t count = (uint16_t)(newest - oldest + 1);
+
+    if (nvs_ring_entries(handle) != count) {
+        printf("# %s: %u entries, expected %u\n", scenario, nvs_ring_entries(handle), count);
+        g_failures++;
+        return;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        make_entry(expect, oldest + i);
+        if ((nvs_ring_retrieve(handle, entry, i) != NVS_OK) || memcmp(entry, expect, NVS_BENCH_SIZE)) {
+            printf("# %s: entry %u wrong\n", scenario, i);
+            g_failures++;
+            return;
+        }
+    }
+
+    // Same entries in place, from every start index for a cursor
+    for (uint16_t start = 0; start < count; start += 1 + count/7) {
+        nvs_ring_cursor cursor;
+        const void *data;
+        uint32_t next = oldest + start;
+
+        nvs_ring_cursor_init(handle, &cursor, start, count - start);
+        while (nvs_ring_cursor_next(&cursor, &data) == NVS_OK) {
+            make_entry(expect, next++);
+            if (memcmp(data, expect, NVS_BENCH_SIZE)) {
+                break;
+            }
+        }
+        if ((next != newest + 1) || nvs_ring_cursor_remaining(&cursor)) {
+            printf("# %s: cursor from %u wrong\n", scenario, start);
+            g_failures++;
+            return;
+        }
+    }
+    range_check check = {oldest, true};
+    if ((nvs_ring_retrieve_range(handle, 0, count, check_range_entry, &check) != NVS_OK) ||
+        !check.ok || (check.next != newest + 1) ||
+        (nvs_ring_retrieve_range(handle, 1, count, check_range_entry, &check) != NVS_INDEX_OUT_OF_BOUND)) {
+        printf("# %s: range wrong\n", scenario);
+        g_failures++;
+    }
+}
+
+static void report(const char *format, uint16_t length, const char *scenario)
+{
+    uint32_t calls = host_crc_stats.result_access / NVS_BENCH_RESULT_ACCESS;
+    uint32_t writes = host_crc_stats.byte_writes + host_crc_stats.word_writes;
+
+    printf("%s,%u,%s,%lu,%lu,%lu,%lu\n", format, length, scenario,
+           (unsigned long)calls,
+           (unsigned long)(host_crc_stats.byte_writes + 2*host_crc_stats.word_writes),
+           (unsigned long)writes,
+           (unsigned long)(calls*NVS_BENCH_CALL_CYCLES + writes*NVS_BENCH_WRITE_CYCLES));
+}
+
+static void measure_start(void)
+{
+    host_crc_clear();
+    g_windows = 0;
+    g_window_max = 0;
+}
+
+static uint32_t crc_cycles(const host_crc_stats_t *stats)
+{
+    return stats->result_access/NVS_BENCH_RESULT_ACCESS*NVS_BENCH_CALL_CYCLES +
+           (stats->byte_writes + stats->word_writes)*NVS_BENCH_WRITE_CYCLES;
+}
+
+static void irq_window(const host_crc_stats_t *window)
+{
+    uint32_t cycles = crc_cycles(window) + NVS_BENCH_WINDOW_CYCLES;
+
+    g_windows++;
+    if (cycles > g_window_max) {
+        g_window_max = cycles;
+    }
+}
+
+/*
+ * Check nvs_crc(), nvs_crc_update() and nvs_copy_crc() against the
+ * reference for every alignment and split, then report one buffer.
+ */
+static void bench_crc(void)
+{
+    static const uint16_t k_sizes[] = {2, 16, 64};
+    uint16_t src[40];
+    uint16_t dst[40];
+    uint8_t *in = (uint8_t *)src;
+    uint8_t *out = (uint8_t *)dst;
+    nvs_crc_context context;
+
+    for (unsigned i = 0; i < sizeof(src); i++) {
+        in[i] = (uint8_t)(i*37 + 11);
+    }
+    for (uint16_t size = 0; size <= 33; size++) {
+        for (uint16_t from = 0; from < 2; from++) {
+            uint16_t expect = reference_crc(0xFFFF, in + from, size);
+
+            if (nvs_crc(in + from, size) != expect) {
+                printf("# crc: size %u offset %u wrong\n", size, from);
+                g_failures++;
+            }
+            for (uint16_t split = 0; split <= size; split++) {
+                nvs_crc_init(&context);
+                nvs_crc_update(&context, in + from, split);
+                nvs_crc_update(&context, in + from + split, size - split);
+                if (nvs_crc_result(&context) != expect) {
+                    printf("# crc: size %u offset %u split %u wrong\n", size, from, split);
+                    g_failures++;
+                }
+            }
+            for (uint16_t to = 0; to < 2; to++) {
+                memset(out, 0, sizeof(dst));
+                if ((nvs_copy_crc(in + from, out + to, size) != expect) || memcmp(in + from, out + to, size) ||
+                    (to && out[0]) || out[to + size]) {
+                    printf("# copy: size %u from %u to %u wrong\n", size, from, to);
+                    g_failures++;
+                }
+            }
+        }
+    }
+
+    for (unsigned i = 0; i < sizeof(k_sizes)/sizeof(k_sizes[0]); i++) {
+        measure_start();
+        nvs_crc(in, k_sizes[i]);
+        report("crc", k_sizes[i], "aligned");
+        measure_start();
+        nvs_crc(in + 1, k_sizes[i]);
+        report("crc", k_sizes[i], "unaligned");
+    }
+}
+
+static void bench_v2(uint8_t *storage, uint16_t length)
+{
+    nvs_ring_handle handle;
+    nvs_ring_header *header;
+    nvs_ring_state *state;
+    uint8_t entry[NVS_BENCH_SIZE];
+    uint32_t adds = length + length/3;
+    uint16_t first;
+    uint16_t last;
+
+    // Wrapped full ring holding entries [adds - length, adds - 1]
+    storage[0] = 0;
+    handle = nvs_ring_init(storage, NVS_BENCH_SIZE, length);
+    header = (nvs_ring_header *)handle;
+    for (uint32_t i = 0; i < adds; i++) {
+        make_entry(entry, i);
+        nvs_ring_add(handle, entry);
+    }
+
+    measure_start();
+    handle = nvs_ring_init(storage, NVS_BENCH_SIZE, length);
+    report("v2", length, "clean");
+    check_ring(handle, adds - length, adds - 1, "clean");
+
+    // Add one more, then tear the commit that made it visible: the ring
+    // falls back to the drop commit made before the oldest was overwritten
+    make_entry(entry, adds);
+    nvs_ring_add(handle, entry);
+    state = &header->state[(int16_t)(header->state[1].seq - header->state[0].seq) > 0];
+    state->last ^= 0x5a5a;
+    measure_start();
+    handle = nvs_ring_init(storage, NVS_BENCH_SIZE, length);
+    report("v2", length, "torn-commit");
+    check_ring(handle, adds - length + 1, adds - 1, "torn-commit");
+
+    // Add the lost entry again; the commit is written but the working copy
+    // of first/last is not updated
+    first = header->first;
+    last = header->last;
+    nvs_ring_add(handle, entry);
+    header->first = first;
+    header->last = last;
+    measure_start();
+    handle = nvs_ring_init(storage, NVS_BENCH_SIZE, length);
+    report("v2", length, "stale-working-copy");
+    check_ring(handle, adds - length + 1, adds, "stale-working-copy");
+}
+
+static void bench_v1(uint8_t *storage, uint16_t length)
+{
+    uint16_t *crcTable = (uint16_t *)(storage + sizeof(v1_header));
+    uint32_t adds = length + length/3;
+
+    v1_fill(storage, NVS_BENCH_SIZE, length, adds);
+    measure_start();
+    v1_recover(storage, NVS_BENCH_SIZE, length);
+    report("v1", length, "clean");
+
+    // Power loss after the data of the newest entry, before its CRC
+    crcTable[((v1_header *)storage)->last] ^= 0x5a5a;
+    measure_start();
+    v1_recover(storage, NVS_BENCH_SIZE, length);
+    report("v1", length, "torn-entry");
+}
+
+static void report_append(const char *container, uint16_t batch, uint16_t calls)
+{
+    uint32_t cycles = crc_cycles(&host_crc_stats) + g_windows*NVS_BENCH_WINDOW_CYCLES +
+                      (uint32_t)NVS_BENCH_APPENDS*NVS_BENCH_ENTRY_CYCLES + (uint32_t)calls*NVS_BENCH_CALL_CYCLES;
+
+    printf("%s,%u,%u,%lu,%lu,%lu,%lu\n", container, batch, NVS_BENCH_APPENDS,
+           (unsigned long)g_windows, (unsigned long)g_window_max,
+           (unsigned long)(cycles/NVS_BENCH_APPENDS),
+           (unsigned long)((uint64_t)NVS_BENCH_MCLK_HZ*NVS_BENCH_APPENDS/cycles));
+}
+
+/*
+ * Append NVS_BENCH_APPENDS entries to a wrapped ring of 1000 entries and
+ * to an empty log, and check what they hold afterwards.
+ */
+static void bench_append(uint8_t *storage)
+{
+    static const uint16_t k_batches[] = {1, 8, 32};
+    static uint8_t entries[32][NVS_BENCH_SIZE];
+    const uint16_t length = 1000;
+    nvs_ring_handle ring;
+    nvs_log_handle log;
+    uint8_t entry[NVS_BENCH_SIZE];
+    uint8_t expect[NVS_BENCH_SIZE];
+    uint32_t next;
+
+    for (int single = 1; single >= 0; single--) {
+        for (unsigned i = 0; i < sizeof(k_batches)/sizeof(k_batches[0]); i++) {
+            uint16_t batch = k_batches[i];
+
+            if (single && (batch > 1)) {
+                break;
+            }
+            storage[0] = 0;
+            ring = nvs_ring_init(storage, NVS_BENCH_SIZE, length);
+            for (next = 0; next < length + 7; next++) {
+                make_entry(entry, next);
+                nvs_ring_add(ring, entry);
+            }
+
+            measure_start();
+            for (uint16_t added = 0; added < NVS_BENCH_APPENDS; added += batch) {
+                for (uint16_t j = 0; j < batch; j++) {
+                    make_entry(entries[j], next++);
+                }
+                if (single) {
+                    nvs_ring_add(ring, entries[0]);
+                }
+                else {
+                    nvs_ring_add_batch(ring, entries, batch);
+                }
+            }
+            report_append(single ? "ring-add" : "ring-batch", batch, NVS_BENCH_APPENDS/batch);
+            check_ring(ring, next - length, next - 1, "append");
+        }
+    }
+
+    for (unsigned i = 0; i < sizeof(k_batches)/sizeof(k_batches[0]); i++) {
+        uint16_t batch = k_batches[i];
+
+        storage[0] = 0;
+        log = nvs_log_init(storage, NVS_BENCH_SIZE, length);
+        next = 0;
+        measure_start();
+        for (uint16_t added = 0; added < NVS_BENCH_APPENDS; added += batch) {
+            for (uint16_t j = 0; j < batch; j++) {
+                make_entry(entries[j], next++);
+            }
+            nvs_log_add_batch(log, entries, batch);
+        }
+        report_append("log-batch", batch, NVS_BENCH_APPENDS/batch);
+
+        // Check contents, and that a batch that does not fit is refused
+        for (uint16_t j = 0; j < NVS_BENCH_APPENDS; j++) {
+            make_entry(expect, j);
+            if ((nvs_log_retrieve(log, entry, j) != NVS_OK) || memcmp(entry, expect, NVS_BENCH_SIZE)) {
+                printf("# log: entry %u wrong\n", j);
+                g_failures++;
+                break;
+            }
+        }
+        if ((nvs_log_add_batch(log, storage, length - NVS_BENCH_APPENDS + 1) != NVS_FULL) ||
+            (nvs_log_entries(log) != NVS_BENCH_APPENDS)) {
+            printf("# log: overfull batch accepted\n");
+            g_failures++;
+        }
+    }
+
+    // Batches that empty the ring and that exceed it keep the newest entries
+    storage[0] = 0;
+    ring = nvs_ring_init(storage, NVS_BENCH_SIZE, 32);
+    for (next = 0; next < 40; next++) {
+        make_entry(entries[next % 32], next);
+        if (next % 32 == 31) {
+            nvs_ring_add_batch(ring, entries, 32);
+        }
+    }
+    nvs_ring_add_batch(ring, entries, 8);
+    check_ring(ring, 8, 39, "batch-wrap");
+}
+
+int main(int argc, char **argv)
+{
+    static const uint16_t k_lengths[] = {100, 1000, 4000};
+    bool header = !(argc > 1 && strcmp(argv[1], "--no-header") == 0);
+
+    if (header) {
+        printf("format,entries,scenario,crc_calls,crc_bytes,crc_writes,est_cycles\n");
+    }
+    bench_crc();
+    for (unsigned i = 0; i < sizeof(k_lengths)/sizeof(k_lengths[0]); i++) {
+        uint16_t length = k_lengths[i];
+        uint8_t *storage = malloc(NVS_RING_STORAGE_SIZE(NVS_BENCH_SIZE, length));
+
+        bench_v1(storage, length);
+        bench_v2(storage, length);
+        free(storage);
+    }
+
+    uint8_t *storage = malloc(NVS_RING_STORAGE_SIZE(NVS_BENCH_SIZE, 1000));
+    host_irq_window = irq_window;
+    if (header) {
+        printf("\ncontainer,batch,entries,fram_windows,irq_off_cycles,cycles_per_entry,entries_per_s\n");
+    }
+    bench_append(storage);
+    free(storage);
+    return g_failures ? 1 : 0;
+}
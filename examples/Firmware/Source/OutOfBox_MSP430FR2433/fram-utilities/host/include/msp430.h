@@ -0,0 +1,58 @@
+/**
+ * @file msp430.h
+ * @brief Host stand-in for the device header, CRC16 module and GIE only
+ *
+ * Enough for ../nvs/nvs_support.c: CRCDI, CRCDI_L and CRCINIRES behave like
+ * the CRC16 module (CRC-CCITT, a word written to CRCDI is processed low byte
+ * first) and count their accesses for the benchmark. SYSCFG0 is a plain
+ * variable, and the interrupt intrinsics track GIE and report every window
+ * with interrupts disabled to host_irq_window (sim/system.c).
+ *
+ * A data register access returns a slot whose value is processed on the
+ * next access to any CRC register, so plain assignments work unchanged.
+ */
+#ifndef HOST_MSP430_H
+#define HOST_MSP430_H
+
+#include <stdint.h>
+
+/**
+ * @brief CRC module access counts since the last host_crc_clear()
+ */
+typedef struct {
+    uint32_t byte_writes;   // CRCDI_L
+    uint32_t word_writes;   // CRCDI
+    uint32_t result_access; // CRCINIRES reads and writes
+} host_crc_stats_t;
+
+extern host_crc_stats_t host_crc_stats;
+
+uint8_t *host_crc_byte(void);
+uint16_t *host_crc_word(void);
+uint16_t *host_crc_result(void);
+void host_crc_clear(void);
+
+#define CRCDI_L (*host_crc_byte())
+#define CRCDI (*host_crc_word())
+#define CRCINIRES (*host_crc_result())
+
+/**
+ * @brief Called when interrupts are enabled again, with the CRC module
+ *        accesses made while they were disabled
+ */
+extern void (*host_irq_window)(const host_crc_stats_t *window);
+
+extern uint16_t host_syscfg0;
+
+uint16_t __get_interrupt_state(void);
+void __disable_interrupt(void);
+void __set_interrupt_state(uint16_t state);
+
+#define __MSP430FR2XX_4XX_FAMILY__
+#define SYSCFG0 host_syscfg0
+#define FRWPPW 0xA500
+#define DFWP 0x0002
+#define PFWP 0x0001
+#define GIE 0x0008
+
+#endif /* HOST_MSP430_H */
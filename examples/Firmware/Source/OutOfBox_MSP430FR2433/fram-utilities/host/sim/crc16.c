@@ -0,0 +1,61 @@
+/**
+ * @file crc16.c
+ * @brief CRC16 module model behind include/msp430.h
+ */
+#include <msp430.h>
+
+host_crc_stats_t host_crc_stats;
+
+static uint16_t g_result = 0xFFFF;
+static uint16_t g_slot;
+static uint8_t g_pending; // Bytes written to g_slot, not processed yet
+
+static void process(uint8_t data)
+{
+    g_result ^= (uint16_t)data << 8;
+    for (int bit = 0; bit < 8; bit++) {
+        g_result = (g_result & 0x8000) ? (uint16_t)((g_result << 1) ^ 0x1021) : (uint16_t)(g_result << 1);
+    }
+}
+
+static void flush(void)
+{
+    if (g_pending >= 1) {
+        process((uint8_t)g_slot);
+    }
+    if (g_pending == 2) {
+        process((uint8_t)(g_slot >> 8));
+    }
+    g_pending = 0;
+}
+
+uint8_t *host_crc_byte(void)
+{
+    flush();
+    host_crc_stats.byte_writes++;
+    g_pending = 1;
+    g_slot = 0;
+    return (uint8_t *)&g_slot; // Host is little-endian like the MSP430
+}
+
+uint16_t *host_crc_word(void)
+{
+    flush();
+    host_crc_stats.word_writes++;
+    g_pending = 2;
+    return &g_slot;
+}
+
+uint16_t *host_crc_result(void)
+{
+    flush();
+    host_crc_stats.result_access++;
+    return &g_result;
+}
+
+void host_crc_clear(void)
+{
+    host_crc_stats.byte_writes = 0;
+    host_crc_stats.word_writes = 0;
+    host_crc_stats.result_access = 0;
+}
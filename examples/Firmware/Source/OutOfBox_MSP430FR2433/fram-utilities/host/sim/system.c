@@ -0,0 +1,40 @@
+/**
+ * @file system.c
+ * @brief GIE and SYSCFG0 model behind include/msp430.h
+ */
+#include <stddef.h>
+
+#include <msp430.h>
+
+void (*host_irq_window)(const host_crc_stats_t *window);
+
+uint16_t host_syscfg0 = PFWP | DFWP;
+
+static uint16_t g_sr = GIE; // Firmware runs with interrupts enabled
+static host_crc_stats_t g_window_start;
+
+uint16_t __get_interrupt_state(void)
+{
+    return g_sr;
+}
+
+void __disable_interrupt(void)
+{
+    if (g_sr & GIE) {
+        g_window_start = host_crc_stats;
+    }
+    g_sr &= ~GIE;
+}
+
+void __set_interrupt_state(uint16_t state)
+{
+    host_crc_stats_t window;
+
+    if ((state & GIE) && !(g_sr & GIE) && (host_irq_window != NULL)) {
+        window.byte_writes = host_crc_stats.byte_writes - g_window_start.byte_writes;
+        window.word_writes = host_crc_stats.word_writes - g_window_start.word_writes;
+        window.result_access = host_crc_stats.result_access - g_window_start.result_access;
+        host_irq_window(&window);
+    }
+    g_sr = state;
+}
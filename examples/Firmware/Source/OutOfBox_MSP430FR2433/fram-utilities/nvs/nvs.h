@@ -50,6 +50,7 @@ typedef enum {
 #include "nvs_data.h"
 #include "nvs_log.h"
 #include "nvs_ring.h"
+#include "nvs_delta.h"
 
 //*****************************************************************************
 //
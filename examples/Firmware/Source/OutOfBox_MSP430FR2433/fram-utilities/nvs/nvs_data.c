@@ -130,14 +130,12 @@ nvs_status nvs_data_restore(nvs_data_handle handle, void *data)
             break;
         case NVS_DATA_1:
             // Copy data and check CRC
-            nvs_copy(data1, data, header->size);
-            crc = nvs_crc(data, header->size);
+            crc = nvs_copy_crc(data1, data, header->size);
             status = (crc == header->crc1) ? NVS_OK : NVS_CRC_ERROR;
             break;
         case NVS_DATA_2:
             // Copy data and check CRC
-            nvs_copy(data2, data, header->size);
-            crc = nvs_crc(data, header->size);
+            crc = nvs_copy_crc(data2, data, header->size);
             status = (crc == header->crc2) ? NVS_OK : NVS_CRC_ERROR;
             break;
         default: break;
@@ -173,16 +171,14 @@ nvs_status nvs_data_commit(nvs_data_handle handle, void *data)
         case NVS_DATA_INIT:
         case NVS_DATA_2:
             // Commit to data1 and set CRC
-            nvs_copy(data, data1, header->size);
-            header->crc1 = nvs_crc(data, header->size);
+            header->crc1 = nvs_copy_crc(data, data1, header->size);
             header->crc2 = 0;
             header->status = NVS_DATA_1;
             status = NVS_OK;
             break;
         case NVS_DATA_1:
             // Commit to data2 and set CRC
-            nvs_copy(data, data2, header->size);
-            header->crc2 = nvs_crc(data, header->size);
+            header->crc2 = nvs_copy_crc(data, data2, header->size);
             header->crc1 = 0;
             header->status = NVS_DATA_2;
             status = NVS_OK;
@@ -0,0 +1,430 @@
+/* --COPYRIGHT--,FRAM-Utilities
+ * Copyright (c) 2015, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * This source code is part of FRAM Utilities for MSP430 FRAM Microcontrollers.
+ * Visit http://www.ti.com/tool/msp-fram-utilities for software information and
+ * download.
+ * --/COPYRIGHT--*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "nvs.h"
+#include "nvs_support.h"
+
+// Number of payload nibbles per block
+#define NVS_DELTA_NIBBLES       (2*NVS_DELTA_PAYLOAD_SIZE)
+
+// Helper function for incrementing block index
+static inline uint16_t __nvs_delta_increment(uint16_t index, uint16_t length)
+{
+    return (index + 1 >= length) ? 0 : index + 1;
+}
+
+// Helper function for calculating the CRC of a block. The free high nibble of
+// a partly used payload byte is left out, since the next add writes it before
+// the new CRC is committed.
+static uint16_t __nvs_delta_block_crc(nvs_delta_block *block, uint8_t used)
+{
+    uint8_t partial;
+    nvs_crc_context context;
+
+    nvs_crc_init(&context);
+    nvs_crc_update(&context, &block->base, sizeof(block->base) + used/2);
+    if (used & 1) {
+        partial = block->payload[used/2] & 0x0f;
+        nvs_crc_update(&context, &partial, 1);
+    }
+    return nvs_crc_result(&context);
+}
+
+// Helper function for calculating the CRC of a state
+static inline uint16_t __nvs_delta_state_crc(const nvs_delta_state *state)
+{
+    return nvs_crc((void *)state, sizeof(nvs_delta_state) - sizeof(state->crc));
+}
+
+// Helper function for checking a state copy
+static bool __nvs_delta_state_valid(const nvs_delta_state *state, uint16_t length)
+{
+    // Check CRC of the state
+    if (__nvs_delta_state_crc(state) != state->crc) {
+        return false;
+    }
+
+    // Check the state is empty or describes blocks within range
+    if (state->first == 0xffff) {
+        return true;
+    }
+    return (state->first < length) && (state->last < length) &&
+           (state->count != 0) && (state->used <= NVS_DELTA_NIBBLES);
+}
+
+// Helper function for selecting the newer of both state copies
+static inline const nvs_delta_state *__nvs_delta_newest(const nvs_delta_header *header)
+{
+    return &header->state[((int16_t)(header->state[1].seq - header->state[0].seq) > 0) ? 1 : 0];
+}
+
+// Helper function for writing a state copy, FRAM must be unlocked
+static void __nvs_delta_state_write(nvs_delta_state *dst, nvs_delta_state *state)
+{
+    state->crc = __nvs_delta_state_crc(state);
+    nvs_copy(state, dst, sizeof(nvs_delta_state));
+}
+
+// Helper function for committing a state, FRAM must be unlocked
+static void __nvs_delta_commit(nvs_delta_header *header, nvs_delta_state *state)
+{
+    const nvs_delta_state *newest;
+
+    // Overwrite the older state copy, the newer one stays valid until done
+    newest = __nvs_delta_newest(header);
+    state->seq = newest->seq + 1;
+    __nvs_delta_state_write(&header->state[(newest == &header->state[0]) ? 1 : 0], state);
+}
+
+// Helper function for copying the open block fields from a state to its block
+static inline void __nvs_delta_close(nvs_delta_block *blocks, const nvs_delta_state *state)
+{
+    if (state->first != 0xffff) {
+        blocks[state->last].count = state->count;
+        blocks[state->last].used = state->used;
+        blocks[state->last].crc = state->blockCrc;
+    }
+}
+
+nvs_delta_handle nvs_delta_init(uint8_t *storage, uint16_t length)
+{
+    bool valid[2];
+    uint16_t newest;
+    uint16_t framState;
+    nvs_delta_block *blocks;
+    nvs_delta_state state;
+    nvs_delta_header *header;
+
+    // A block is dropped whole on wrap, so one block could not keep any
+    // history while the next one fills
+    if (length < 2) {
+        return NULL;
+    }
+
+    // Calculate pointer to header and block storage inside the NVS container
+    header = (nvs_delta_header *)storage;
+    blocks = (nvs_delta_block *)((uintptr_t)header + sizeof(nvs_delta_header));
+
+    // Check status of delta container
+    if ((header->token == NVS_DELTA_TOKEN) && (header->length == length)) {
+        // Check both state copies, a power loss can only tear one of them
+        valid[0] = __nvs_delta_state_valid(&header->state[0], length);
+        valid[1] = __nvs_delta_state_valid(&header->state[1], length);
+        if (valid[0] || valid[1]) {
+            // Select the newer valid state
+            if (valid[0] && valid[1]) {
+                newest = (__nvs_delta_newest(header) == &header->state[1]) ? 1 : 0;
+            }
+            else {
+                newest = valid[1];
+            }
+
+            // Unlock FRAM
+            framState = nvs_unlockFRAM();
+
+            // Replace a torn copy with an older copy of the same state, so the
+            // next commit overwrites it
+            if (!valid[newest ^ 1]) {
+                state = header->state[newest];
+                state.seq--;
+                __nvs_delta_state_write(&header->state[newest ^ 1], &state);
+            }
+
+            // Restore the open block header, which the last add may not have
+            // written completely
+            __nvs_delta_close(blocks, &header->state[newest]);
+
+            // Lock FRAM
+            nvs_lockFRAM(framState);
+
+            // Return NVS delta handle
+            return (nvs_delta_handle)header;
+        }
+    }
+
+    // Unlock FRAM
+    framState = nvs_unlockFRAM();
+
+    // Initialize NVS delta header with an empty container
+    header->length = length;
+    nvs_fill(&state, 0, sizeof(state));
+    state.first = 0xffff;
+    state.last = 0xffff;
+    state.seq = 0;
+    __nvs_delta_state_write(&header->state[0], &state);
+    state.seq = 0xffff;
+    __nvs_delta_state_write(&header->state[1], &state);
+
+    // Write the token last, so an interrupted initialization is repeated
+    header->token = NVS_DELTA_TOKEN;
+
+    // Lock FRAM
+    nvs_lockFRAM(framState);
+
+    // Return NVS delta handle
+    return (nvs_delta_handle)header;
+}
+
+nvs_status nvs_delta_reset(nvs_delta_handle handle)
+{
+    uint16_t framState;
+    nvs_status status;
+    nvs_delta_state state;
+    nvs_delta_header *header;
+
+    // Initialize status
+    status  = NVS_NOK;
+
+    // Calculate pointer to header
+    header = (nvs_delta_header *)handle;
+
+    // Check the header is valid using the token
+    if (header->token == NVS_DELTA_TOKEN) {
+        // Unlock FRAM
+        framState = nvs_unlockFRAM();
+
+        // Commit empty container, keeping the open block position
+        state = *__nvs_delta_newest(header);
+        state.first = 0xffff;
+        __nvs_delta_commit(header, &state);
+
+        // Lock FRAM
+        nvs_lockFRAM(framState);
+
+        // Set return status
+        status = NVS_OK;
+    }
+
+    // Return status
+    return status;
+}
+
+nvs_status nvs_delta_add(nvs_delta_handle handle, int16_t sample)
+{
+    uint8_t nibble;
+    uint8_t needed;
+    uint8_t *payload;
+    uint16_t next;
+    uint16_t length;
+    uint16_t framState;
+    uint32_t zigzag;
+    uint32_t value;
+    int32_t delta;
+    nvs_status status;
+    nvs_delta_block *blocks;
+    nvs_delta_block *block;
+    nvs_delta_state state;
+    nvs_delta_header *header;
+
+    // Initialize status
+    status  = NVS_NOK;
+
+    // Calculate pointer to header and block storage inside the NVS container
+    header = (nvs_delta_header *)handle;
+    blocks = (nvs_delta_block *)((uintptr_t)header + sizeof(nvs_delta_header));
+
+    // Check the header is valid using the token
+    if (header->token == NVS_DELTA_TOKEN) {
+        // Initialize local variables
+        state = *__nvs_delta_newest(header);
+        length = header->length;
+
+        // Count nibbles needed for the zigzag encoded difference
+        delta = (int32_t)sample - state.value;
+        zigzag = (delta < 0) ? ((uint32_t)(-delta) << 1) - 1 : (uint32_t)delta << 1;
+        needed = 1;
+        for (value = zigzag >> 3; value; value >>= 3) {
+            needed++;
+        }
+
+        // Unlock FRAM
+        framState = nvs_unlockFRAM();
+
+        if ((state.first != 0xffff) && (state.used + needed <= NVS_DELTA_NIBBLES)) {
+            // Write nibbles after the committed payload of the open block
+            block = &blocks[state.last];
+            payload = block->payload;
+            value = zigzag;
+            while (needed--) {
+                nibble = (uint8_t)(value & 0x7) | (needed ? 0x8 : 0);
+                value >>= 3;
+                if (state.used & 1) {
+                    payload[state.used/2] = (payload[state.used/2] & 0x0f) | (nibble << 4);
+                }
+                else {
+                    payload[state.used/2] = (payload[state.used/2] & 0xf0) | nibble;
+                }
+                state.used++;
+            }
+            state.count++;
+        }
+        else {
+            // Start a new block, committing without the oldest block first if
+            // all blocks are in use
+            next = __nvs_delta_increment(state.last, length);
+            if (state.first == 0xffff) {
+                state.first = next;
+            }
+            else if (next == state.first) {
+                state.first = __nvs_delta_increment(state.first, length);
+                __nvs_delta_commit(header, &state);
+            }
+            state.last = next;
+            block = &blocks[next];
+            block->base = sample;
+            state.count = 1;
+            state.used = 0;
+        }
+
+        // Commit the open block, then copy its fields into the block header
+        state.blockCrc = __nvs_delta_block_crc(block, state.used);
+        state.value = sample;
+        __nvs_delta_commit(header, &state);
+        __nvs_delta_close(blocks, &state);
+
+        // Lock FRAM
+        nvs_lockFRAM(framState);
+
+        // Set return status
+        status = NVS_OK;
+    }
+
+    // Return status
+    return status;
+}
+
+nvs_status nvs_delta_retrieve_block(nvs_delta_handle handle, uint16_t index, int16_t *samples, uint16_t *count)
+{
+    uint8_t pos;
+    uint8_t shift;
+    uint8_t nibble;
+    uint16_t n;
+    uint16_t value;
+    uint32_t zigzag;
+    nvs_status status;
+    nvs_delta_block *block;
+    const nvs_delta_state *state;
+    nvs_delta_header *header;
+
+    // Initialize status
+    status  = NVS_NOK;
+    *count = 0;
+
+    // Calculate pointer to header
+    header = (nvs_delta_header *)handle;
+
+    // Check the header is valid using the token
+    if (header->token == NVS_DELTA_TOKEN) {
+        // Check index is within range
+        if (index < nvs_delta_blocks(handle)) {
+            // Calculate pointer to block
+            state = __nvs_delta_newest(header);
+            index += state->first;
+            if (index >= header->length) {
+                index -= header->length;
+            }
+            block = (nvs_delta_block *)((uintptr_t)header + sizeof(nvs_delta_header)) + index;
+
+            // Check the block before decoding it
+            status = NVS_CRC_ERROR;
+            if ((block->used > NVS_DELTA_NIBBLES) || (block->count == 0) ||
+                (__nvs_delta_block_crc(block, block->used) != block->crc)) {
+                return status;
+            }
+
+            // Decode differences, wrapping like the 16-bit samples did
+            value = (uint16_t)block->base;
+            samples[0] = (int16_t)value;
+            n = 1;
+            pos = 0;
+            while (pos < block->used) {
+                zigzag = 0;
+                shift = 0;
+                do {
+                    if ((pos >= block->used) || (shift > 15)) {
+                        return status;
+                    }
+                    nibble = block->payload[pos/2];
+                    nibble = (pos & 1) ? nibble >> 4 : nibble & 0x0f;
+                    zigzag |= (uint32_t)(nibble & 0x7) << shift;
+                    shift += 3;
+                    pos++;
+                } while (nibble & 0x8);
+                value += (zigzag & 1) ? (uint16_t)~(zigzag >> 1) : (uint16_t)(zigzag >> 1);
+                samples[n++] = (int16_t)value;
+            }
+
+            // Check the number of samples matches
+            if (n == block->count) {
+                *count = n;
+                status = NVS_OK;
+            }
+        }
+        else {
+            // Index out of range, set return status
+            status = NVS_INDEX_OUT_OF_BOUND;
+        }
+    }
+
+    // Return status
+    return status;
+}
+
+uint16_t nvs_delta_blocks(nvs_delta_handle handle)
+{
+    uint16_t length;
+    const nvs_delta_state *state;
+    nvs_delta_header *header;
+
+    // Calculate pointer to header and newest state
+    header = (nvs_delta_header *)handle;
+    state = __nvs_delta_newest(header);
+
+    // Initialize local variables
+    length = header->length;
+
+    // Calculate and return number of blocks
+    if (state->first == 0xffff) {
+        return 0;
+    }
+    else if (state->first > state->last) {
+        return (state->last + length - state->first + 1);
+    }
+    else {
+        return (state->last - state->first + 1);
+    }
+}
+
+uint32_t nvs_delta_entries(nvs_delta_handle handle)
+{
+    uint16_t index;
+    uint16_t blocks;
+    uint32_t entries;
+    nvs_delta_block *block;
+    const nvs_delta_state *state;
+    nvs_delta_header *header;
+
+    // Calculate pointer to header, newest state and block storage
+    header = (nvs_delta_header *)handle;
+    state = __nvs_delta_newest(header);
+    block = (nvs_delta_block *)((uintptr_t)header + sizeof(nvs_delta_header));
+
+    // Add up sample counts of all blocks
+    entries = 0;
+    index = state->first;
+    for (blocks = nvs_delta_blocks(handle); blocks; blocks--) {
+        entries += block[index].count;
+        index = __nvs_delta_increment(index, header->length);
+    }
+
+    // Return number of samples
+    return entries;
+}
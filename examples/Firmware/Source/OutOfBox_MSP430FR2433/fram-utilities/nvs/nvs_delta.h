@@ -0,0 +1,257 @@
+/* --COPYRIGHT--,FRAM-Utilities
+ * Copyright (c) 2015, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * This source code is part of FRAM Utilities for MSP430 FRAM Microcontrollers.
+ * Visit http://www.ti.com/tool/msp-fram-utilities for software information and
+ * download.
+ * --/COPYRIGHT--*/
+#ifndef NVS_DELTA_H_
+#define NVS_DELTA_H_
+
+//******************************************************************************
+//
+//! \addtogroup nvs_api_delta
+//! @{
+//
+//******************************************************************************
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//******************************************************************************
+//
+//! NVS token to identify the corresponding container.
+//
+//******************************************************************************
+#define NVS_DELTA_TOKEN                 0xA535
+
+//******************************************************************************
+//
+//! Size of a compressed block in bytes, including its header.
+//
+//******************************************************************************
+#ifndef NVS_DELTA_BLOCK_SIZE
+#define NVS_DELTA_BLOCK_SIZE            64
+#endif
+
+//******************************************************************************
+//
+//! Bytes of delta payload per block.
+//
+//******************************************************************************
+#define NVS_DELTA_PAYLOAD_SIZE          (NVS_DELTA_BLOCK_SIZE - 6)
+
+//******************************************************************************
+//
+//! Maximum number of samples in a block: the base sample plus one delta per
+//! payload nibble. Size of the buffer passed to nvs_delta_retrieve_block().
+//
+//******************************************************************************
+#define NVS_DELTA_BLOCK_SAMPLES         (2*NVS_DELTA_PAYLOAD_SIZE + 1)
+
+#if (NVS_DELTA_BLOCK_SIZE & 1) || (NVS_DELTA_BLOCK_SIZE < 8) || (NVS_DELTA_BLOCK_SAMPLES > 255)
+#error NVS_DELTA_BLOCK_SIZE must be even and between 8 and 132 bytes
+#endif
+
+//******************************************************************************
+//
+//! Calculate the NVS delta storage size from the number of blocks.
+//
+//******************************************************************************
+#define NVS_DELTA_STORAGE_SIZE(num)     \
+    (sizeof(nvs_delta_header)+(num)*sizeof(nvs_delta_block))
+
+//******************************************************************************
+//
+//! Calculate the number of blocks that fit into a given storage size.
+//
+//******************************************************************************
+#define NVS_DELTA_BLOCKS(bytes)         \
+    (((bytes)-sizeof(nvs_delta_header))/sizeof(nvs_delta_block))
+
+//******************************************************************************
+//
+//! NVS delta container handle.
+//
+//******************************************************************************
+typedef void *nvs_delta_handle;
+
+//******************************************************************************
+//
+//! NVS delta block. The first sample is stored as is, every following one as
+//! the zigzag encoded difference to its predecessor, in groups of three bits
+//! per nibble with the top bit set if another nibble follows. A difference of
+//! -4 to 3 therefore takes half a byte.
+//
+//******************************************************************************
+typedef struct nvs_delta_block {
+    //! Number of samples in the block.
+    uint8_t count;
+    //! Number of payload nibbles in use.
+    uint8_t used;
+    //! CRC of base and the payload nibbles in use.
+    uint16_t crc;
+    //! First sample of the block.
+    int16_t base;
+    //! Differences, low nibble first.
+    uint8_t payload[NVS_DELTA_PAYLOAD_SIZE];
+} nvs_delta_block;
+
+//******************************************************************************
+//
+//! NVS delta state as committed by an add or reset. Two copies are kept and a
+//! commit overwrites the older one, as for the ring container. The count, used
+//! and crc fields of the open block are restored from it by nvs_delta_init().
+//
+//******************************************************************************
+typedef struct nvs_delta_state {
+    //! Commit sequence number, higher (modulo 2^16) in the newer copy.
+    uint16_t seq;
+    //! Index of the oldest block, 0xffff if empty.
+    uint16_t first;
+    //! Index of the open block that samples are added to.
+    uint16_t last;
+    //! Number of samples in the open block.
+    uint8_t count;
+    //! Number of payload nibbles in use in the open block.
+    uint8_t used;
+    //! CRC of the open block.
+    uint16_t blockCrc;
+    //! Most recent sample, to calculate the next difference.
+    int16_t value;
+    //! CRC of the fields above.
+    uint16_t crc;
+} nvs_delta_state;
+
+//******************************************************************************
+//
+//! NVS type definition for a non volatile DELTA storage container.
+//
+//******************************************************************************
+typedef struct nvs_delta_header {
+    //! Identifier token.
+    uint16_t token;
+    //! Number of blocks in delta storage.
+    uint16_t length;
+    //! Journaled copies of the container state.
+    nvs_delta_state state[2];
+} nvs_delta_header;
+
+//******************************************************************************
+//
+//! \brief  Initialize non-volatile data DELTA storage container
+//!
+//! This function checks for an existing non-volatile delta container at the
+//! given location. If it finds one with the same number of blocks, it selects
+//! the newer of the two journaled states whose CRC is valid, replaces a copy
+//! torn by a power loss and rewrites the header of the open block from it.
+//! Like nvs_ring_init() this takes a fixed number of CRC checks.
+//!
+//! Only when no container is found, or the number of blocks has changed, or
+//! neither state is valid, then the container will be initialized empty.
+//!
+//! \param  storage     Pointer to NVS data storage with size calculated using
+//!                     NVS_DELTA_STORAGE_SIZE.
+//! \param  length      Number of blocks in the delta storage, at least 2.
+//! \return             NVS delta container handle, or NULL if length is
+//!                     less than 2 (the storage is left untouched)
+//
+//******************************************************************************
+extern nvs_delta_handle nvs_delta_init(uint8_t *storage, uint16_t length);
+
+//******************************************************************************
+//
+//! \brief  Reset (clear) non-volatile data DELTA storage container.
+//!
+//! \param  handle    NVS delta container handle.
+//! \return         Status of the NVS operation.
+//
+//******************************************************************************
+extern nvs_status nvs_delta_reset(nvs_delta_handle handle);
+
+//******************************************************************************
+//
+//! \brief  Adds a sample to the non-volatile DELTA storage container
+//!
+//! This function appends the difference to the previous sample to the open
+//! block, or starts a new block with the sample as its base when the
+//! difference does not fit. When all blocks are in use the oldest block is
+//! dropped, and with it all its samples.
+//!
+//! \param  handle    NVS delta container handle.
+//! \param  sample    Sample to add.
+//! \return         Status of the NVS operation.
+//
+//******************************************************************************
+extern nvs_status nvs_delta_add(nvs_delta_handle handle, int16_t sample);
+
+//******************************************************************************
+//
+//! \brief  Decode a block of the non-volatile DELTA storage container.
+//!
+//! This function decodes the block with the given index, counted from the
+//! oldest block, into samples, which must hold NVS_DELTA_BLOCK_SAMPLES.
+//! The CRC of the block is checked and the decoded samples must match the
+//! block's sample count, which is reflected in the return value.
+//!
+//! \param  handle    NVS delta container handle.
+//! \param  index     Index of the block to decode.
+//! \param  samples   Buffer for the decoded samples, oldest first.
+//! \param  count     Set to the number of decoded samples.
+//! \return         Status of the NVS operation.
+//
+//******************************************************************************
+extern nvs_status nvs_delta_retrieve_block(nvs_delta_handle handle, uint16_t index, int16_t *samples, uint16_t *count);
+
+//******************************************************************************
+//
+//! \brief  Return the number of blocks in use.
+//!
+//! \param  handle    NVS delta container handle.
+//! \return         Number of blocks holding samples.
+//
+//******************************************************************************
+extern uint16_t nvs_delta_blocks(nvs_delta_handle handle);
+
+//******************************************************************************
+//
+//! \brief  Return the number of samples in the delta container.
+//!
+//! This function adds up the sample count of every block in use, without
+//! decoding them.
+//!
+//! \param  handle    NVS delta container handle.
+//! \return         Number of samples.
+//
+//******************************************************************************
+extern uint32_t nvs_delta_entries(nvs_delta_handle handle);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+//******************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//******************************************************************************
+
+#endif /* NVS_DELTA_H_ */
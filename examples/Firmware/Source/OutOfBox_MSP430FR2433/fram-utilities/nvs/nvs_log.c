@@ -137,8 +137,7 @@ nvs_status nvs_log_add(nvs_log_handle handle, void *data)
 
             // Increment data storage pointer, copy data and increment index
             dataStorage += header->size * next;
-            nvs_copy(data, dataStorage, header->size);
-            crcTable[next] = nvs_crc(data, header->size);
+            crcTable[next] = nvs_copy_crc(data, dataStorage, header->size);
             header->index = next;
 
             // Lock FRAM
@@ -157,6 +156,63 @@ nvs_status nvs_log_add(nvs_log_handle handle, void *data)
     return status;
 }
 
+nvs_status nvs_log_add_batch(nvs_log_handle handle, void *data, uint16_t count)
+{
+    uint8_t *dataStorage;
+    uint8_t *dataPtr;
+    uint16_t next;
+    uint16_t length;
+    uint16_t *crcTable;
+    uint16_t framState;
+    nvs_status status;
+    nvs_log_header *header;
+
+    // Initialize status
+    status  = NVS_NOK;
+
+    // Calculate pointer to header and data storage inside the NVS container
+    header = (nvs_log_header *)handle;
+    crcTable = (uint16_t *)((uintptr_t)header + sizeof(nvs_log_header));
+    dataStorage = (uint8_t *)((uintptr_t)crcTable + sizeof(uint16_t)*header->length);
+
+    // Initialize local variables
+    length = header->length;
+    dataPtr = (uint8_t *)data;
+
+    // Check the header is valid using the token
+    if (header->token == NVS_LOG_TOKEN) {
+        // Calculate the next index and check if the log has space for all
+        next = header->index + 1;
+        if (count <= length - next) {
+            // Copy data, restoring interrupts between entries so they are only
+            // disabled while a single entry is written
+            dataStorage += header->size * next;
+            while (count--) {
+                framState = nvs_unlockFRAM();
+                crcTable[next++] = nvs_copy_crc(dataPtr, dataStorage, header->size);
+                nvs_lockFRAM(framState);
+                dataStorage += header->size;
+                dataPtr += header->size;
+            }
+
+            // Update the index once for all entries
+            framState = nvs_unlockFRAM();
+            header->index = next - 1;
+            nvs_lockFRAM(framState);
+
+            // Set return status
+            status = NVS_OK;
+        }
+        else {
+            // Log is full, set return status
+            status = NVS_FULL;
+        }
+    }
+
+    // Return status
+    return status;
+}
+
 nvs_status nvs_log_retrieve(nvs_log_handle handle, void *data, uint16_t index)
 {
     uint8_t *dataStorage;
@@ -179,8 +235,7 @@ nvs_status nvs_log_retrieve(nvs_log_handle handle, void *data, uint16_t index)
         if ((header->index != 0xffff) && (index <= header->index)) {
             // Increment data storage pointer, retrieve data and check CRC
             dataStorage += header->size * index;
-            nvs_copy(dataStorage, data, header->size);
-            crc = nvs_crc(data, header->size);
+            crc = nvs_copy_crc(dataStorage, data, header->size);
             status = (crc == crcTable[index]) ? NVS_OK : NVS_CRC_ERROR;
         }
         else {
@@ -123,6 +123,25 @@ extern nvs_status nvs_log_reset(nvs_log_handle handle);
 //******************************************************************************
 extern nvs_status nvs_log_add(nvs_log_handle handle, void *data);
 
+//******************************************************************************
+//
+//! \brief  Adds several data entries to the non-volatile LOG storage
+//!         container.
+//!
+//! This function adds count entries stored back to back at data, oldest first,
+//! and updates the index once for the whole batch. FRAM is unlocked and
+//! interrupts are disabled for one entry at a time, so interrupts are serviced
+//! between entries. They must not add to the same container. If the log has
+//! no space for all entries, none is added.
+//!
+//! \param  handle    NVS log container handle.
+//! \param  data      Pointer to the entries to add to the storage container.
+//! \param  count     Number of entries to add.
+//! \return         Status of the NVS operation.
+//
+//******************************************************************************
+extern nvs_status nvs_log_add_batch(nvs_log_handle handle, void *data, uint16_t count);
+
 //******************************************************************************
 //
 //! \brief  Retrieve a specific data entry from the non-volatile log storage container
@@ -7,6 +7,7 @@
  * download.
  * --/COPYRIGHT--*/
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "nvs.h"
 #include "nvs_support.h"
@@ -23,113 +24,125 @@ static inline uint16_t __nvs_ring_increment(uint16_t index, uint16_t count, uint
     return next;
 }
 
+// Helper function for calculating the CRC of a ring state
+static inline uint16_t __nvs_ring_state_crc(const nvs_ring_state *state)
+{
+    return nvs_crc((void *)state, sizeof(nvs_ring_state) - sizeof(state->crc));
+}
+
+// Helper function for checking a ring state copy
+static bool __nvs_ring_state_valid(const nvs_ring_state *state, uint16_t length)
+{
+    // Check CRC of the state
+    if (__nvs_ring_state_crc(state) != state->crc) {
+        return false;
+    }
+
+    // Check first and last index are both empty or both within range
+    if ((state->first == 0xffff) && (state->last == 0xffff)) {
+        return true;
+    }
+    return (state->first < length) && (state->last < length);
+}
+
+// Helper function for selecting the newer of both ring state copies
+static inline uint16_t __nvs_ring_state_newest(const nvs_ring_header *header)
+{
+    return ((int16_t)(header->state[1].seq - header->state[0].seq) > 0) ? 1 : 0;
+}
+
+// Helper function for writing a ring state copy, FRAM must be unlocked
+static void __nvs_ring_state_write(nvs_ring_state *state, uint16_t seq, uint16_t first, uint16_t last)
+{
+    nvs_ring_state update;
+
+    // Prepare state with CRC and copy it in one go
+    update.seq = seq;
+    update.first = first;
+    update.last = last;
+    update.crc = __nvs_ring_state_crc(&update);
+    nvs_copy(&update, state, sizeof(nvs_ring_state));
+}
+
+// Helper function for committing first and last, FRAM must be unlocked
+static void __nvs_ring_commit(nvs_ring_header *header, uint16_t first, uint16_t last)
+{
+    uint16_t newest;
+
+    // Overwrite the older state copy, the newer one stays valid until done
+    newest = __nvs_ring_state_newest(header);
+    __nvs_ring_state_write(&header->state[newest ^ 1], header->state[newest].seq + 1, first, last);
+
+    // Update working copy of first and last index
+    header->first = first;
+    header->last = last;
+}
+
 nvs_ring_handle nvs_ring_init(uint8_t *storage, uint16_t size, uint16_t length)
 {
-    uint8_t *dataStorage;
-    uint8_t *dataPtr;
-    uint16_t last;
-    uint16_t next;
-    uint16_t first;
-    uint16_t crcLast;
-    uint16_t crcFirst;
+    bool valid[2];
+    uint16_t newest;
     uint16_t *crcTable;
     uint16_t framState;
+    nvs_ring_state *state;
     nvs_ring_header *header;
 
-    // Initialize local variables
-    first = 0xffff;
-    last = 0xffff;
-
-    // Calculate pointer to header and data storage inside the NVS container
+    // Calculate pointer to header and CRC table inside the NVS container
     header = (nvs_ring_header *)storage;
     crcTable = (uint16_t *)((uintptr_t)header + sizeof(nvs_ring_header));
-    dataStorage = (uint8_t *)((uintptr_t)crcTable + sizeof(uint16_t)*length);
 
     // Check status of ring container
     if ((header->token == NVS_RING_TOKEN) && (header->size == size) && (header->length == length)) {
-        // Check first and last index are within range
-        first = header->first;
-        last = header->last;
-        if ((first < length) && (last < length)) {
-            // Check first, last and next CRC and return if entries are valid
-            next = __nvs_ring_increment(last, 1, length);
-            crcLast = nvs_crc(dataStorage+(size*last), size);
-            crcFirst = nvs_crc(dataStorage+(size*first), size);
-            if ((crcTable[first] == crcFirst) && (crcTable[last] == crcLast) && ((next == first) || (crcTable[next] == 0))) {
+        // Check both state copies, a power loss can only tear one of them
+        valid[0] = __nvs_ring_state_valid(&header->state[0], length);
+        valid[1] = __nvs_ring_state_valid(&header->state[1], length);
+        if (valid[0] || valid[1]) {
+            // Select the newer valid state
+            newest = (valid[0] && valid[1]) ? __nvs_ring_state_newest(header) : valid[1];
+            state = &header->state[newest];
+
+            // Return if both copies are valid and the working copy matches
+            if (valid[newest ^ 1] && (header->first == state->first) && (header->last == state->last)) {
                 return (nvs_ring_handle)header;
             }
-        }
 
-        // Reset indices and try to recover last entry using CRC
-        if (nvs_crc(dataStorage, size) == crcTable[0]) {
-            // First CRC is valid, find last valid entry first
-            last = 1;
-            dataPtr = dataStorage + size;
-            while ((last < length) && (nvs_crc(dataPtr, size) == crcTable[last])) {
-                last++;
-                dataPtr += size;
-            }
-            last--;
-
-            // Find first valid entry
-            first = length-1;
-            dataPtr = dataStorage + size*(length-1);
-            while ((first > last) && (nvs_crc(dataPtr, size) == crcTable[first])) {
-                first--;
-                dataPtr -= size;
-            }
-            first++;
-        }
-        else {
-            // First CRC is not valid, find first valid entry
-            first = 1;
-            dataPtr = dataStorage + size;
-            while ((first < length) && (nvs_crc(dataPtr, size) != crcTable[first])) {
-                first++;
-                dataPtr += size;
-            }
+            // Unlock FRAM
+            framState = nvs_unlockFRAM();
 
-            if (first != length) {
-                // First valid entry found, find the last valid entry
-                last = first + 1;
-                dataPtr = dataStorage + size*last;
-                while ((last < length) && (nvs_crc(dataPtr, size) == crcTable[last])) {
-                    last++;
-                    dataPtr += size;
-                }
-                last--;
-            }
-            else {
-                // No valid entries found, reset first and last
-                first = 0xffff;
-                last = 0xffff;
+            // Replace a torn copy with an older copy of the same state, so the
+            // next commit overwrites it
+            if (!valid[newest ^ 1]) {
+                __nvs_ring_state_write(&header->state[newest ^ 1], state->seq - 1, state->first, state->last);
             }
+
+            // Restore working copy of first and last index
+            header->first = state->first;
+            header->last = state->last;
+
+            // Lock FRAM
+            nvs_lockFRAM(framState);
+
+            // Return NVS ring handle
+            return (nvs_ring_handle)header;
         }
     }
 
     // Unlock FRAM
     framState = nvs_unlockFRAM();
 
-    // Initialize NVS ring header
-    header->token = NVS_RING_TOKEN;
-    header->first = first;
-    header->last = last;
+    // Initialize NVS ring header with an empty ring
+    header->first = 0xffff;
+    header->last = 0xffff;
     header->size = size;
     header->length = length;
+    __nvs_ring_state_write(&header->state[0], 0, 0xffff, 0xffff);
+    __nvs_ring_state_write(&header->state[1], 0xffff, 0xffff, 0xffff);
 
-    // Clear CRC checksum
-    if (first == 0xffff) {
-        // Clear all CRC checksum for all ring entries
-        nvs_fill(crcTable, 0, length*sizeof(crcTable[0]));
-    }
-    else {
-        // Clear all CRC checksum from empty ring entries
-        last = __nvs_ring_increment(last, 1, length);
-        while (last != first) {
-            crcTable[last] = 0;
-            last = __nvs_ring_increment(last, 1, length);
-        }
-    }
+    // Clear all CRC checksum for all ring entries
+    nvs_fill(crcTable, 0, length*sizeof(crcTable[0]));
+
+    // Write the token last, so an interrupted initialization is repeated
+    header->token = NVS_RING_TOKEN;
 
     // Lock FRAM
     nvs_lockFRAM(framState);
@@ -161,13 +174,12 @@ nvs_status nvs_ring_reset(nvs_ring_handle handle)
         // Unlock FRAM
         framState = nvs_unlockFRAM();
 
+        // Commit empty ring before the entries are invalidated
+        __nvs_ring_commit(header, 0xffff, 0xffff);
+
         // Clear all CRC checksum for all ring entries
         nvs_fill(crcTable, 0, length*sizeof(crcTable[0]));
 
-        // Reset first and last indices
-        header->first = 0xffff;
-        header->last = 0xffff;
-
         // Lock FRAM
         nvs_lockFRAM(framState);
 
@@ -215,22 +227,28 @@ nvs_status nvs_ring_add(nvs_ring_handle handle, void *data)
         // Calculate the next index from last entry
         next = __nvs_ring_increment(last, 1, length);
         if (next == first) {
-            // Ring storage is full, clear first CRC and increment index
-            crcTable[next] = 0;
-            header->first = __nvs_ring_increment(next, 1, length);
+            // Ring storage is full, commit without the first entry before it
+            // is overwritten
+            if (first == last) {
+                __nvs_ring_commit(header, 0xffff, 0xffff);
+                first = 0xffff;
+            }
+            else {
+                first = __nvs_ring_increment(first, 1, length);
+                __nvs_ring_commit(header, first, last);
+            }
         }
 
-        // Copy data and update last index
-        dataStorage += size * next;
-        nvs_copy(data, dataStorage, size);
-        crcTable[next] = nvs_crc(data, size);
-        header->last = next;
-        
         // Check if this is the first entry
         if (first == 0xffff) {
-            header->first = next;
+            first = next;
         }
 
+        // Copy data outside the committed range, then commit the new last index
+        dataStorage += size * next;
+        crcTable[next] = nvs_copy_crc(data, dataStorage, size);
+        __nvs_ring_commit(header, first, next);
+
         // Lock FRAM
         nvs_lockFRAM(framState);
 
@@ -242,6 +260,94 @@ nvs_status nvs_ring_add(nvs_ring_handle handle, void *data)
     return status;
 }
 
+nvs_status nvs_ring_add_batch(nvs_ring_handle handle, void *data, uint16_t count)
+{
+    uint8_t *dataStorage;
+    uint8_t *dataPtr;
+    uint16_t size;
+    uint16_t last;
+    uint16_t next;
+    uint16_t first;
+    uint16_t drop;
+    uint16_t i;
+    uint16_t entries;
+    uint16_t length;
+    uint16_t *crcTable;
+    uint16_t framState;
+    nvs_status status;
+    nvs_ring_header *header;
+
+    // Initialize status
+    status  = NVS_NOK;
+
+    // Calculate pointer to header and data storage inside the NVS container
+    header = (nvs_ring_header *)handle;
+    crcTable = (uint16_t *)((uintptr_t)header + sizeof(nvs_ring_header));
+    dataStorage = (uint8_t *)((uintptr_t)crcTable + sizeof(uint16_t)*header->length);
+
+    // Initialize local variables
+    first = header->first;
+    last = header->last;
+    size = header->size;
+    length = header->length;
+    dataPtr = (uint8_t *)data;
+
+    // Check the header is valid using the token
+    if (header->token == NVS_RING_TOKEN) {
+        // Only the newest entries that fit into the ring are kept
+        if (count > length) {
+            dataPtr += size * (count - length);
+            count = length;
+        }
+
+        // Commit without the oldest entries the batch overwrites, before any
+        // of them is overwritten
+        entries = nvs_ring_entries(handle);
+        if (count > length - entries) {
+            drop = count - (length - entries);
+            framState = nvs_unlockFRAM();
+            if (drop == entries) {
+                __nvs_ring_commit(header, 0xffff, 0xffff);
+                first = 0xffff;
+            }
+            else {
+                first = __nvs_ring_increment(first, drop, length);
+                __nvs_ring_commit(header, first, last);
+            }
+            nvs_lockFRAM(framState);
+        }
+
+        // Check if these are the first entries
+        if (first == 0xffff) {
+            first = __nvs_ring_increment(last, 1, length);
+        }
+
+        // Copy data outside the committed range, restoring interrupts between
+        // entries so they are only disabled while a single entry is written
+        next = last;
+        for (i = 0; i < count; i++) {
+            next = __nvs_ring_increment(next, 1, length);
+            framState = nvs_unlockFRAM();
+            crcTable[next] = nvs_copy_crc(dataPtr, dataStorage + size*next, size);
+            nvs_lockFRAM(framState);
+            dataPtr += size;
+        }
+
+        // Commit the new last index once for all entries
+        if (count) {
+            framState = nvs_unlockFRAM();
+            __nvs_ring_commit(header, first, next);
+            nvs_lockFRAM(framState);
+        }
+
+        // Set return status
+        status = NVS_OK;
+    }
+
+    // Return status
+    return status;
+}
+
 nvs_status nvs_ring_retrieve(nvs_ring_handle handle, void *data, uint16_t index)
 {
     uint8_t *dataStorage;
@@ -275,8 +381,7 @@ nvs_status nvs_ring_retrieve(nvs_ring_handle handle, void *data, uint16_t index)
 
             // Increment data storage pointer, retrieve data and check CRC
             dataStorage += size * index;
-            nvs_copy(dataStorage, data, size);
-            crc = nvs_crc(data, size);
+            crc = nvs_copy_crc(dataStorage, data, size);
             status = (crc == crcTable[index]) ? NVS_OK : NVS_CRC_ERROR;
         }
         else {
@@ -353,3 +458,106 @@ uint16_t nvs_ring_entries(nvs_ring_handle handle)
         return (last - first + 1);
     }
 }
+
+nvs_status nvs_ring_cursor_init(nvs_ring_handle handle, nvs_ring_cursor *cursor, uint16_t index, uint16_t count)
+{
+    uint16_t size;
+    uint16_t first;
+    uint16_t length;
+    nvs_ring_header *header;
+
+    // Calculate pointer to header
+    header = (nvs_ring_header *)handle;
+
+    // Check the header is valid using the token
+    if (header->token != NVS_RING_TOKEN) {
+        return NVS_NOK;
+    }
+
+    // Check range is within the stored entries
+    if ((uint32_t)index + count > nvs_ring_entries(handle)) {
+        return NVS_INDEX_OUT_OF_BOUND;
+    }
+
+    // Initialize local variables
+    first = header->first;
+    size = header->size;
+    length = header->length;
+
+    // Calculate pointer to CRC table and data storage inside the NVS container
+    cursor->size = size;
+    cursor->crcTable = (uint16_t *)((uintptr_t)header + sizeof(nvs_ring_header));
+    cursor->dataStorage = (uint8_t *)((uintptr_t)cursor->crcTable + sizeof(uint16_t)*length);
+
+    // Split the range at the end of the storage
+    index = (count == 0) ? 0 : __nvs_ring_increment(first, index, length);
+    cursor->segment = length - index;
+    if (cursor->segment >= count) {
+        cursor->segment = count;
+        cursor->wrapped = 0;
+    }
+    else {
+        cursor->wrapped = count - cursor->segment;
+    }
+    cursor->data = cursor->dataStorage + size*index;
+    cursor->crc = cursor->crcTable + index;
+
+    return NVS_OK;
+}
+
+nvs_status nvs_ring_cursor_next(nvs_ring_cursor *cursor, const void **data)
+{
+    nvs_status status;
+
+    // Continue at the start of the storage after the first segment
+    if (cursor->segment == 0) {
+        if (cursor->wrapped == 0) {
+            return NVS_EMPTY;
+        }
+        cursor->segment = cursor->wrapped;
+        cursor->wrapped = 0;
+        cursor->data = cursor->dataStorage;
+        cursor->crc = cursor->crcTable;
+    }
+
+    // Return entry in place and check CRC
+    *data = cursor->data;
+    status = (nvs_crc(cursor->data, cursor->size) == *cursor->crc) ? NVS_OK : NVS_CRC_ERROR;
+
+    // Advance to the next entry
+    cursor->data += cursor->size;
+    cursor->crc++;
+    cursor->segment--;
+
+    return status;
+}
+
+uint16_t nvs_ring_cursor_remaining(const nvs_ring_cursor *cursor)
+{
+    return cursor->segment + cursor->wrapped;
+}
+
+nvs_status nvs_ring_retrieve_range(nvs_ring_handle handle, uint16_t index, uint16_t count, nvs_ring_callback callback, void *context)
+{
+    const void *data;
+    nvs_status entry;
+    nvs_status status;
+    nvs_ring_cursor cursor;
+
+    // Position cursor on the first entry of the range
+    status = nvs_ring_cursor_init(handle, &cursor, index, count);
+    if (status != NVS_OK) {
+        return status;
+    }
+
+    // Visit all entries, remembering any CRC error
+    while ((entry = nvs_ring_cursor_next(&cursor, &data)) != NVS_EMPTY) {
+        callback(data, entry, context);
+        if (entry != NVS_OK) {
+            status = entry;
+        }
+    }
+
+    // Return status
+    return status;
+}
@@ -31,10 +31,19 @@ extern "C"
 
 //******************************************************************************
 //
-//! NVS token to identify the corresponding container.
+//! NVS token to identify the corresponding container. Version 2 adds the
+//! journaled first/last state (nvs_ring_state).
 //
 //******************************************************************************
-#define NVS_RING_TOKEN  0xA533
+#define NVS_RING_TOKEN  0xA534
+
+//******************************************************************************
+//
+//! NVS token of version 1 ring containers. They have a smaller header and are
+//! reinitialized by nvs_ring_init().
+//
+//******************************************************************************
+#define NVS_RING_TOKEN_V1   0xA533
 
 //******************************************************************************
 //
@@ -52,6 +61,24 @@ extern "C"
 //******************************************************************************
 typedef void *nvs_ring_handle;
 
+//******************************************************************************
+//
+//! NVS ring first/last state as committed by an add or reset. Two copies are
+//! kept and a commit overwrites the older one, so a power loss during a commit
+//! always leaves the previous state intact.
+//
+//******************************************************************************
+typedef struct nvs_ring_state {
+    //! Commit sequence number, higher (modulo 2^16) in the newer copy.
+    uint16_t seq;
+    //! Index of first ring entry.
+    uint16_t first;
+    //! Index of last ring entry.
+    uint16_t last;
+    //! CRC of seq, first and last.
+    uint16_t crc;
+} nvs_ring_state;
+
 //******************************************************************************
 //
 //! NVS type definition for a non volatile RING storage container.
@@ -69,24 +96,60 @@ typedef struct nvs_ring_header {
     //! Maximum number of entries in ring storage.
     //!
     uint16_t length;
+    //! Journaled copies of first and last. The fields above are a working
+    //! copy that nvs_ring_init() rebuilds from the newest valid state.
+    nvs_ring_state state[2];
 } nvs_ring_header;
 
+//******************************************************************************
+//
+//! NVS ring cursor for walking entries in place. The range is split at the
+//! end of the storage once, when the cursor is initialized.
+//
+//******************************************************************************
+typedef struct nvs_ring_cursor {
+    //! Data of the next entry.
+    uint8_t *data;
+    //! Stored CRC of the next entry.
+    uint16_t *crc;
+    //! Entries left before the cursor wraps to the start of the storage.
+    uint16_t segment;
+    //! Entries left after the wrap.
+    uint16_t wrapped;
+    //! Size of data structure element.
+    uint16_t size;
+    //! Start of the entry data storage.
+    uint8_t *dataStorage;
+    //! Start of the CRC table.
+    uint16_t *crcTable;
+} nvs_ring_cursor;
+
+//******************************************************************************
+//
+//! NVS ring range callback, called with a pointer to the entry data inside the
+//! container and the result of its CRC check (NVS_OK or NVS_CRC_ERROR).
+//
+//******************************************************************************
+typedef void (*nvs_ring_callback)(const void *data, nvs_status status, void *context);
+
 //******************************************************************************
 //
 //! \brief  Initialize non-volatile data RING storage container
 //!
 //! This function checks for an existing non-volatile ring container at the
 //! given location. If it finds an existing container, it will match the
-//! properties of the container and verify the constancy of the container.
-//! A CRC check of the most recent data is performed and if everything is match
-//! the function will return without any modification to the storage container.
-//! In case of a failing CRC an incomplete storage operation is assumed and the
-//! ring container is completely analyzed to identify the oldest and most recent
-//! data entry. The ring container is then updated to contain the updated
-//! first/last information.
+//! properties of the container and restore first/last from the newer of the
+//! two journaled states whose CRC is valid. A copy torn by a power loss is
+//! replaced with the valid one.
+//!
+//! An entry is written outside the committed first/last range and committed
+//! afterwards, and a full ring commits dropping the oldest entry before it is
+//! overwritten. The committed range therefore never holds an incomplete entry
+//! and recovery takes two state CRCs (plus one to repair a torn copy),
+//! regardless of the ring length. Entries are not scanned.
 //!
 //! Only when no container is found, or the properties of the container have
-//! changed, or no matching CRC was found, then the container will be
+//! changed, or neither state is valid, then the container will be
 //! initialized with an empty ring buffer.
 //!
 //! \param  storage        Pointer to NVS data storage with size calculated using
@@ -117,6 +180,9 @@ extern nvs_status nvs_ring_reset(nvs_ring_handle handle);
 //!
 //! This function copies the data to the storage container. For integrity checks
 //! the CRC of the data is calculated and stored in the container as well.
+//! The entry becomes part of the ring only when the new last index is
+//! committed after the copy. A full ring first commits without its oldest
+//! entry, so adding to it takes two commits.
 //!
 //! \param  handle    NVS ring container handle.
 //! \param  data    Pointer to data structure to add to the storage container.
@@ -125,6 +191,28 @@ extern nvs_status nvs_ring_reset(nvs_ring_handle handle);
 //******************************************************************************
 extern nvs_status nvs_ring_add(nvs_ring_handle handle, void *data);
 
+//******************************************************************************
+//
+//! \brief  Adds several data entries to the non-volatile RING storage
+//!         container.
+//!
+//! This function adds count entries stored back to back at data, oldest first.
+//! Like nvs_ring_add() every entry is copied with its CRC outside the committed
+//! range, but the new last index is committed once for the whole batch, and a
+//! full ring drops all entries the batch overwrites in one commit before.
+//! FRAM is unlocked and interrupts are disabled for one entry at a time, so
+//! interrupts are serviced between entries. They must not add to the same
+//! container. When count exceeds the ring length only the newest entries are
+//! stored.
+//!
+//! \param  handle    NVS ring container handle.
+//! \param  data      Pointer to the entries to add to the storage container.
+//! \param  count     Number of entries to add.
+//! \return         Status of the NVS operation.
+//
+//******************************************************************************
+extern nvs_status nvs_ring_add_batch(nvs_ring_handle handle, void *data, uint16_t count);
+
 //******************************************************************************
 //
 //! \brief  Retrieve a specific data entry from the non-volatile ring storage
@@ -185,6 +273,70 @@ extern uint16_t nvs_ring_max(nvs_ring_handle handle);
 //******************************************************************************
 extern uint16_t nvs_ring_entries(nvs_log_handle handle);
 
+//******************************************************************************
+//
+//! \brief  Start walking entries of the ring container in place.
+//!
+//! This function positions the cursor on the entry with the given index,
+//! counted from the oldest entry, for count entries. The header is read once
+//! here; nvs_ring_cursor_next() then only advances pointers. Adding to the
+//! ring while walking it may overwrite entries that are still to be visited.
+//!
+//! \param  handle    NVS ring container handle.
+//! \param  cursor    Cursor to initialize.
+//! \param  index     Index of the first entry to visit.
+//! \param  count     Number of entries to visit.
+//! \return         NVS_INDEX_OUT_OF_BOUND if the range exceeds the entries,
+//!                 NVS_NOK if the container is not valid, NVS_OK otherwise.
+//
+//******************************************************************************
+extern nvs_status nvs_ring_cursor_init(nvs_ring_handle handle, nvs_ring_cursor *cursor, uint16_t index, uint16_t count);
+
+//******************************************************************************
+//
+//! \brief  Return the next entry of a cursor without copying it.
+//!
+//! This function sets data to the entry inside the container, calculates the
+//! CRC of the entry and compares it against the stored CRC value.
+//!
+//! \param  cursor    Cursor initialized with nvs_ring_cursor_init().
+//! \param  data      Set to the entry data inside the container.
+//! \return         NVS_OK or NVS_CRC_ERROR for the entry, NVS_EMPTY when all
+//!                 entries have been visited.
+//
+//******************************************************************************
+extern nvs_status nvs_ring_cursor_next(nvs_ring_cursor *cursor, const void **data);
+
+//******************************************************************************
+//
+//! \brief  Return the number of entries a cursor has left to visit.
+//!
+//! \param  cursor    Cursor initialized with nvs_ring_cursor_init().
+//! \return         Number of entries left.
+//
+//******************************************************************************
+extern uint16_t nvs_ring_cursor_remaining(const nvs_ring_cursor *cursor);
+
+//******************************************************************************
+//
+//! \brief  Retrieve a range of data entries in place.
+//!
+//! This function calls the callback for count entries starting at index,
+//! counted from the oldest entry, in order. The callback gets a pointer to
+//! the entry inside the container and the result of its CRC check. Every
+//! entry is visited even if an earlier one fails the CRC check.
+//!
+//! \param  handle    NVS ring container handle.
+//! \param  index     Index of the first entry to retrieve.
+//! \param  count     Number of entries to retrieve.
+//! \param  callback  Function called for every entry.
+//! \param  context   Passed to the callback.
+//! \return         NVS_CRC_ERROR if any entry failed the CRC check, otherwise
+//!                 as nvs_ring_cursor_init().
+//
+//******************************************************************************
+extern nvs_status nvs_ring_retrieve_range(nvs_ring_handle handle, uint16_t index, uint16_t count, nvs_ring_callback callback, void *context);
+
 //*****************************************************************************
 //
 // Mark the end of the C bindings section for C++ compilers.
@@ -10,6 +10,65 @@
 
 #include <stdint.h>
 
+#include "nvs_support.h"
+
+/*
+ * Feed a buffer to the CRC module. Aligned words go through CRCDI, which
+ * processes the low byte first and so gives the same result as two byte
+ * writes to CRCDI_L in memory order.
+ */
+static inline void __nvs_crc_feed(const uint8_t *ptrData, uint16_t size)
+{
+    const uint16_t *ptrWord;
+
+    // Feed a leading byte to reach a word boundary
+    if (((uintptr_t)ptrData & 1) && size) {
+        CRCDI_L = *ptrData++;
+        size--;
+    }
+
+    // Feed words, then the remaining byte
+    ptrWord = (const uint16_t *)ptrData;
+    while (size >= 2) {
+        CRCDI = *ptrWord++;
+        size -= 2;
+    }
+    if (size) {
+        CRCDI_L = *(const uint8_t *)ptrWord;
+    }
+}
+
+/*
+ * Copy a buffer and feed it to the CRC module in the same pass.
+ */
+static inline void __nvs_crc_copy(const uint8_t *src, uint8_t *dst, uint16_t size)
+{
+    uint16_t word;
+    const uint16_t *srcWord;
+    uint16_t *dstWord;
+
+    // Copy bytewise unless both buffers are word aligned
+    if (((uintptr_t)src | (uintptr_t)dst) & 1) {
+        while (size--) {
+            CRCDI_L = *dst++ = *src++;
+        }
+        return;
+    }
+
+    // Copy and feed words, then the remaining byte
+    srcWord = (const uint16_t *)src;
+    dstWord = (uint16_t *)dst;
+    while (size >= 2) {
+        word = *srcWord++;
+        *dstWord++ = word;
+        CRCDI = word;
+        size -= 2;
+    }
+    if (size) {
+        CRCDI_L = *(uint8_t *)dstWord = *(const uint8_t *)srcWord;
+    }
+}
+
 /*
  * Calculate a 16-bit CRC over a storage buffer in bytes.
  */
@@ -17,17 +76,13 @@ uint16_t nvs_crc(void *data, uint16_t size)
 {
     uint16_t res;
     uint16_t temp;
-    uint8_t *ptrData;
 
     // Save CRC result register and reset input
     temp = CRCINIRES;
     CRCINIRES = 0xFFFF;
 
-    // Set local pointer and calculate CRC
-    ptrData = (uint8_t *)data;
-    while (size--) {
-        CRCDI_L = *ptrData++;
-    }
+    // Calculate CRC
+    __nvs_crc_feed((const uint8_t *)data, size);
 
     // Save result and restore CRC result register
     res = CRCINIRES;
@@ -37,6 +92,56 @@ uint16_t nvs_crc(void *data, uint16_t size)
     return res;
 }
 
+/*
+ * Continue a 16-bit CRC over another part of the data.
+ */
+void nvs_crc_update(nvs_crc_context *context, const void *data, uint16_t size)
+{
+    uint16_t temp;
+
+    // Save CRC result register and resume from the context
+    temp = CRCINIRES;
+    CRCINIRES = context->crc;
+
+    // Continue CRC
+    __nvs_crc_feed((const uint8_t *)data, size);
+
+    // Save result and restore CRC result register
+    context->crc = CRCINIRES;
+    CRCINIRES = temp;
+}
+
+/*
+ * Copy data and continue a 16-bit CRC over it in the same pass.
+ */
+void nvs_crc_copy(nvs_crc_context *context, const void *src, void *dst, uint16_t size)
+{
+    uint16_t temp;
+
+    // Save CRC result register and resume from the context
+    temp = CRCINIRES;
+    CRCINIRES = context->crc;
+
+    // Copy data and continue CRC
+    __nvs_crc_copy((const uint8_t *)src, (uint8_t *)dst, size);
+
+    // Save result and restore CRC result register
+    context->crc = CRCINIRES;
+    CRCINIRES = temp;
+}
+
+/*
+ * Copy data and return the 16-bit CRC of it.
+ */
+uint16_t nvs_copy_crc(const void *src, void *dst, uint16_t size)
+{
+    nvs_crc_context context;
+
+    nvs_crc_init(&context);
+    nvs_crc_copy(&context, src, dst, size);
+    return nvs_crc_result(&context);
+}
+
 #if defined(__MSP430FR2XX_4XX_FAMILY__)
 
 #if !defined(FRWPPW)
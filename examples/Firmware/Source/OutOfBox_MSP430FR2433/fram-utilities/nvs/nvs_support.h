@@ -66,17 +66,101 @@ static inline void nvs_copy(const void *src, void *dst, uint16_t length)
     memcpy(dst, src, length);
 }
 
+//******************************************************************************
+//
+//! NVS CRC context for calculating a CRC over data in several parts.
+//
+//******************************************************************************
+typedef struct nvs_crc_context {
+    //! CRC of the data fed so far.
+    uint16_t crc;
+} nvs_crc_context;
+
 //******************************************************************************
 //
 //! \brief  Calculate a 16-bit CRC over a storage buffer in bytes
 //!
+//! Word aligned data is fed to the CRC module a word at a time. The result is
+//! the same as feeding the bytes in memory order.
+//!
 //! \param  data    Pointer to data to calculate CRC on.
 //! \param  size    Length of data array.
-//! \return         none
+//! \return         CRC of the data.
 //
 //******************************************************************************
 uint16_t nvs_crc(void *data, uint16_t size);
 
+//******************************************************************************
+//
+//! \brief  Start an incremental CRC calculation
+//!
+//! \param  context Pointer to CRC context to initialize.
+//! \return         none
+//
+//******************************************************************************
+static inline void nvs_crc_init(nvs_crc_context *context)
+{
+    context->crc = 0xFFFF;
+}
+
+//******************************************************************************
+//
+//! \brief  Continue an incremental CRC calculation over more data
+//!
+//! The CRC of several parts equals nvs_crc() over the parts joined together.
+//! The CRC result register is restored afterwards, so other contexts and
+//! nvs_crc() calls can be interleaved.
+//!
+//! \param  context Pointer to CRC context.
+//! \param  data    Pointer to data to continue the CRC on.
+//! \param  size    Length of data array.
+//! \return         none
+//
+//******************************************************************************
+void nvs_crc_update(nvs_crc_context *context, const void *data, uint16_t size);
+
+//******************************************************************************
+//
+//! \brief  Copy data and continue an incremental CRC calculation over it
+//!
+//! Same as nvs_copy() followed by nvs_crc_update(), in one pass over the data.
+//!
+//! \param  context Pointer to CRC context.
+//! \param  src     Pointer to source to copy.
+//! \param  dst     Pointer to destination to copy to.
+//! \param  size    Length of source and destination arrays.
+//! \return         none
+//
+//******************************************************************************
+void nvs_crc_copy(nvs_crc_context *context, const void *src, void *dst, uint16_t size);
+
+//******************************************************************************
+//
+//! \brief  Return the result of an incremental CRC calculation
+//!
+//! \param  context Pointer to CRC context.
+//! \return         CRC of all data fed to the context.
+//
+//******************************************************************************
+static inline uint16_t nvs_crc_result(const nvs_crc_context *context)
+{
+    return context->crc;
+}
+
+//******************************************************************************
+//
+//! \brief  Copy data and calculate a 16-bit CRC over it
+//!
+//! Same as nvs_copy() followed by nvs_crc(), in one pass over the data.
+//!
+//! \param  src     Pointer to source to copy.
+//! \param  dst     Pointer to destination to copy to.
+//! \param  size    Length of source and destination arrays.
+//! \return         CRC of the data.
+//
+//******************************************************************************
+uint16_t nvs_copy_crc(const void *src, void *dst, uint16_t size);
+
 //******************************************************************************
 //
 //! \brief  Unlock FRAM for writing
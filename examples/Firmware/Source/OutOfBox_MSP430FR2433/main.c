@@ -52,10 +52,10 @@
 // ADC data
 adc_data_t adc_data;
 
-// NVS ring handle
-nvs_ring_handle nvsHandle;
+// NVS delta handle
+nvs_delta_handle nvsHandle;
 
-// FRAM storage for ADC samples using NVS ring storage
+// FRAM storage for ADC samples using NVS delta storage
 #if defined(__TI_COMPILER_VERSION__)
 #pragma PERSISTENT(nvsStorage)
 #elif defined(__IAR_SYSTEMS_ICC__)
@@ -112,7 +112,7 @@ int main(void)
     initEusci();
 
     // Check integrity of NVS container and initialize if required;
-    nvsHandle = nvs_ring_init(nvsStorage, sizeof(adc_data_t), NVS_RING_SIZE);
+    nvsHandle = nvs_delta_init(nvsStorage, NVS_DELTA_SIZE);
 
     /* Toggle P1.0 LED to indicated device start up. */
     P1OUT ^= BIT1;
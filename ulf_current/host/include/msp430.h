@@ -0,0 +1,107 @@
+/**
+ * @file msp430.h
+ * @brief Host stand-in for the MSP430FR2433 device header
+ *
+ * Registers the sequencer touches are fields of sim_regs. The MPY32
+ * operand and result registers go through accessors so the simulator can
+ * multiply on demand (see sim/msp430_sim.c). Only the registers and bits
+ * stim_sequencer.c uses are provided; bit values match the real header.
+ */
+#ifndef HOST_MSP430_H
+#define HOST_MSP430_H
+
+#include <stdint.h>
+
+/**
+ * @brief Simulated register file
+ */
+typedef struct {
+    uint8_t p1out;
+    uint16_t ta0ctl;
+    uint16_t ta0cctl0;
+    uint16_t ta0ccr0;
+    uint16_t syscfg0;
+} sim_regs_t;
+
+extern volatile sim_regs_t sim_regs;
+
+/**
+ * @brief MPY32 registers reached through sim_mpy_reg()
+ */
+typedef enum {
+    SIM_MPY,    // 16-bit unsigned first operand
+    SIM_MPY32L, // 32-bit unsigned first operand, low word
+    SIM_MPY32H, // 32-bit unsigned first operand, high word
+    SIM_OP2L,   // 32-bit second operand, low word
+    SIM_OP2H,   // 32-bit second operand, high word
+    SIM_RES0,   // Result, least significant word first
+    SIM_RES1,
+    SIM_RES2,
+    SIM_RES3
+} sim_mpy_reg_t;
+
+volatile uint16_t *sim_mpy_reg(sim_mpy_reg_t reg);
+
+uint16_t sim_get_interrupt_state(void);
+void sim_set_interrupt_state(uint16_t state);
+void sim_bis_sr(uint16_t bits);
+void sim_bic_sr(uint16_t bits);
+void sim_bic_sr_on_exit(uint16_t bits);
+
+// Digital I/O
+#define P1OUT (sim_regs.p1out)
+
+// Timer0_A3; the count itself is virtual time in the simulator
+#define TA0CTL (sim_regs.ta0ctl)
+#define TA0CCTL0 (sim_regs.ta0cctl0)
+#define TA0CCR0 (sim_regs.ta0ccr0)
+
+#define TACLR 0x0004
+#define MC__CONTINUOUS 0x0020
+#define TASSEL__ACLK 0x0100
+#define TASSEL__SMCLK 0x0200
+#define CCIE 0x0010
+
+// MPY32
+#define MPY (*sim_mpy_reg(SIM_MPY))
+#define MPY32L (*sim_mpy_reg(SIM_MPY32L))
+#define MPY32H (*sim_mpy_reg(SIM_MPY32H))
+#define OP2L (*sim_mpy_reg(SIM_OP2L))
+#define OP2H (*sim_mpy_reg(SIM_OP2H))
+#define RES0 (*sim_mpy_reg(SIM_RES0))
+#define RES1 (*sim_mpy_reg(SIM_RES1))
+#define RES2 (*sim_mpy_reg(SIM_RES2))
+#define RES3 (*sim_mpy_reg(SIM_RES3))
+
+// FRAM write protection
+#define SYSCFG0 (sim_regs.syscfg0)
+#define PFWP 0x0001
+#define DFWP 0x0002
+#define FRWPPW 0xA500
+
+// Port bits
+#define BIT0 0x0001
+#define BIT1 0x0002
+
+// Status register
+#define GIE 0x0008
+#define CPUOFF 0x0010
+#define SCG0 0x0040
+#define SCG1 0x0080
+#define LPM0_bits (CPUOFF)
+#define LPM3_bits (SCG1 | SCG0 | CPUOFF)
+
+// Interrupt vectors; only their names matter on the host
+#define TIMER0_A0_VECTOR 0
+
+// ISRs are ordinary functions the simulator calls
+#define interrupt(vector) used
+
+// Intrinsics
+#define __get_interrupt_state() sim_get_interrupt_state()
+#define __set_interrupt_state(state) sim_set_interrupt_state(state)
+#define __disable_interrupt() sim_bic_sr(GIE)
+#define __enable_interrupt() sim_bis_sr(GIE)
+#define __bic_SR_register_on_exit(bits) sim_bic_sr_on_exit(bits)
+
+#endif /* HOST_MSP430_H */
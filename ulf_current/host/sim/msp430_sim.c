@@ -0,0 +1,124 @@
+/**
+ * @file msp430_sim.c
+ * @brief Simulated Timer0_A3 and MPY32 for host builds of the sequencer
+ *
+ * The timer counts virtual ticks from the last TACLR. CCR0 writes are only
+ * seen when the ISR returns, at which point the next match is the first
+ * count after the write time that equals CCR0. The multiplier keeps its
+ * operands and works the product out when a result word is read.
+ */
+#include "msp430_sim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+volatile sim_regs_t sim_regs;
+
+void TIMER0_A0_ISR(void);
+
+static struct {
+  uint64_t now;
+  uint64_t origin; // Time of the last TACLR
+  uint16_t latency;
+  uint16_t sr;
+  bool in_isr;
+  bool woken;
+
+  // MPY32
+  bool op1_32;
+  uint16_t mpy[SIM_RES3 + 1];
+
+  sim_stats_t stats;
+} g_sim;
+
+void sim_reset(void) {
+  memset((void *)&sim_regs, 0, sizeof(sim_regs));
+  memset(&g_sim, 0, sizeof(g_sim));
+}
+
+void sim_set_isr_latency(uint16_t ticks) { g_sim.latency = ticks; }
+
+const sim_stats_t *sim_stats(void) { return &g_sim.stats; }
+
+/**
+ * @brief Start the count over if TACLR was set; the bit reads back as 0
+ */
+static void timer_clear(void) {
+  if (sim_regs.ta0ctl & TACLR) {
+    sim_regs.ta0ctl &= ~TACLR;
+    g_sim.origin = g_sim.now;
+  }
+}
+
+bool sim_take_wakeup(void) {
+  bool woken = g_sim.woken;
+  g_sim.woken = false;
+  return woken;
+}
+
+uint64_t sim_run_edge(void) {
+  timer_clear();
+  if (!(sim_regs.ta0ctl & MC__CONTINUOUS) || !(sim_regs.ta0cctl0 & CCIE) ||
+      !(g_sim.sr & GIE)) {
+    fprintf(stderr, "sim: CCR0 interrupt not enabled\n");
+    exit(2);
+  }
+  if (g_sim.stats.isr_calls >= SIM_EDGE_LIMIT) {
+    fprintf(stderr, "sim: edge limit reached\n");
+    exit(2);
+  }
+
+  // First count after the last write that matches CCR0
+  uint64_t next = g_sim.now + 1;
+  next += (uint16_t)(sim_regs.ta0ccr0 - (uint16_t)(next - g_sim.origin));
+
+  g_sim.now = next + g_sim.latency;
+  g_sim.in_isr = true;
+  uint16_t sr = g_sim.sr;
+  g_sim.sr &= ~GIE;
+  TIMER0_A0_ISR();
+  g_sim.sr = sr;
+  g_sim.in_isr = false;
+  g_sim.stats.isr_calls++;
+  return next;
+}
+
+volatile uint16_t *sim_mpy_reg(sim_mpy_reg_t reg) {
+  if (!g_sim.in_isr && (g_sim.sr & GIE)) {
+    g_sim.stats.mpy_unguarded++;
+  }
+
+  if (reg == SIM_MPY) {
+    g_sim.op1_32 = false;
+    g_sim.mpy[SIM_MPY32H] = 0;
+  } else if (reg == SIM_MPY32L || reg == SIM_MPY32H) {
+    g_sim.op1_32 = true;
+  } else if (reg >= SIM_RES0) {
+    uint64_t op1 = g_sim.op1_32 ? ((uint32_t)g_sim.mpy[SIM_MPY32H] << 16 |
+                                   g_sim.mpy[SIM_MPY32L])
+                                : g_sim.mpy[SIM_MPY];
+    uint64_t op2 = (uint32_t)g_sim.mpy[SIM_OP2H] << 16 | g_sim.mpy[SIM_OP2L];
+    uint64_t res = op1 * op2;
+    for (uint8_t i = 0; i < 4; i++) {
+      g_sim.mpy[SIM_RES0 + i] = (uint16_t)(res >> (16 * i));
+    }
+  }
+  return &g_sim.mpy[reg];
+}
+
+uint16_t sim_get_interrupt_state(void) { return g_sim.sr & GIE; }
+
+void sim_set_interrupt_state(uint16_t state) {
+  g_sim.sr = (g_sim.sr & ~GIE) | (state & GIE);
+}
+
+void sim_bis_sr(uint16_t bits) { g_sim.sr |= bits; }
+
+void sim_bic_sr(uint16_t bits) { g_sim.sr &= ~bits; }
+
+void sim_bic_sr_on_exit(uint16_t bits) {
+  if (g_sim.in_isr && (bits & CPUOFF)) {
+    g_sim.woken = true;
+    g_sim.stats.wakeups++;
+  }
+}
@@ -0,0 +1,62 @@
+/**
+ * @file msp430_sim.h
+ * @brief Simulated Timer0_A3 and MPY32 for host builds of the sequencer
+ *
+ * Time is virtual and counted in timer ticks. Each call to sim_run_edge()
+ * jumps to the next CCR0 compare and runs TIMER0_A0_ISR() as if it had
+ * started a fixed latency after the compare, so a compare written closer
+ * to the count than that fires one 16-bit wrap late, as on the target.
+ * The CPU never sleeps; an ISR clearing LPM bits on exit is recorded as a
+ * wake-up for the test to act on as main would.
+ */
+#ifndef MSP430_SIM_H
+#define MSP430_SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <msp430.h>
+
+/**
+ * @brief Edges after which sim_run_edge() aborts, assuming a hang
+ */
+#define SIM_EDGE_LIMIT 1000000UL
+
+/**
+ * @brief Counters since the last sim_reset()
+ */
+typedef struct {
+    uint32_t isr_calls;      // TIMER0_A0_ISR() runs
+    uint32_t wakeups;        // ISRs that cleared LPM bits on exit
+    uint32_t mpy_unguarded;  // MPY32 used outside the ISR with GIE set
+} sim_stats_t;
+
+/**
+ * @brief Power-on reset of registers, time and counters
+ */
+void sim_reset(void);
+
+/**
+ * @brief Ticks from a compare to the ISR's CCR0 write (default 0)
+ */
+void sim_set_isr_latency(uint16_t ticks);
+
+/**
+ * @brief Run TIMER0_A0_ISR() at the next CCR0 compare
+ *
+ * Aborts if the interrupt is not enabled.
+ *
+ * @return uint64_t Time of the compare in ticks since sim_reset()
+ */
+uint64_t sim_run_edge(void);
+
+/**
+ * @brief Whether the last ISR woke main; clears the flag
+ */
+bool sim_take_wakeup(void);
+
+/**
+ * @brief Counters
+ */
+const sim_stats_t *sim_stats(void);
+
+#endif /* MSP430_SIM_H */
@@ -0,0 +1,457 @@
+/**
+ * @file test_stim_sequencer.c
+ * @brief Host regression tests for stim_sequencer.c
+ *
+ * Runs the sequencer against the simulated timer with the ISR answering
+ * each compare STIM_MIN_TICKS - 1 ticks late, the slowest response the
+ * minimum width allows for, and checks every output edge against the
+ * exact tick the programmed microsecond widths put it on. Whenever the ISR
+ * wakes main, stim_sequencer_service() runs before the next edge, as the
+ * main loop in ulf_current.c would.
+ */
+#include "msp430_sim.h"
+#include "stim_sequencer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int g_checks;
+static int g_failures;
+
+#define CHECK(cond)                                                            \
+  do {                                                                         \
+    g_checks++;                                                                \
+    if (!(cond)) {                                                             \
+      g_failures++;                                                            \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,         \
+              #cond);                                                          \
+    }                                                                          \
+  } while (0)
+
+#define PINS (BIT0 | BIT1)
+
+// Longest span one compare can schedule
+#define MAX_CHUNK 0xFFFFUL
+
+// STIM_CHARGE_LIMIT_NC in stim_net_charge() units
+#define CHARGE_LIMIT                                                           \
+  ((int64_t)((uint64_t)STIM_CHARGE_LIMIT_NC * STIM_CHARGE_PER_NC_NUM /         \
+             STIM_CHARGE_PER_NC_DEN))
+
+/**
+ * @brief Where a program is expected to be, in microseconds since the
+ *        first cathodic edge
+ *
+ * The sequencer carries every width's remainder, so phase n starts on
+ * tick floor(us * STIM_TICK_NUM / STIM_TICK_DEN) after the first edge.
+ */
+typedef struct {
+  const stim_program_t *program;
+  uint16_t step;
+  uint16_t pulse;
+  uint8_t phase; // 0 cathodic, 1 gap, 2 anodic, 3 rest
+  uint64_t us;   // Start of that phase
+} timeline_t;
+
+static uint8_t g_pins;     // P1OUT after the last edge
+static bool g_main_busy;  // Main ignores wake-ups, e.g. mid UART reply
+
+/**
+ * @brief Smallest width in microseconds that lasts at least ticks
+ */
+static uint32_t us_for_ticks(uint32_t ticks) {
+  return (uint32_t)(((uint64_t)ticks * STIM_TICK_DEN + STIM_TICK_NUM - 1) /
+                    STIM_TICK_NUM);
+}
+
+static uint64_t us_to_tick(uint64_t us) {
+  return us * STIM_TICK_NUM / STIM_TICK_DEN;
+}
+
+/**
+ * @brief Pins of the next phase that has a width, and when it starts
+ */
+static uint8_t timeline_next(timeline_t *tl, uint64_t *start_us) {
+  static const uint8_t pins[4] = {BIT0, 0, BIT1, 0};
+
+  for (;;) {
+    const stim_step_t *step = &tl->program->steps[tl->step];
+    uint32_t width[4] = {step->cathodic_us, step->interphase_us,
+                         step->anodic_us, step->rest_us};
+    uint8_t phase = tl->phase;
+
+    if (++tl->phase == 4) {
+      tl->phase = 0;
+      if (++tl->pulse == step->repeat) {
+        tl->pulse = 0;
+        if (++tl->step == tl->program->step_count) {
+          tl->step = 0;
+        }
+      }
+    }
+    if (width[phase]) {
+      *start_us = tl->us;
+      tl->us += width[phase];
+      return pins[phase];
+    }
+  }
+}
+
+/**
+ * @brief Run edges until the outputs change
+ *
+ * @return uint64_t Time of the edge that changed them
+ */
+static uint64_t next_transition(void) {
+  for (;;) {
+    uint64_t time = sim_run_edge();
+    if (sim_take_wakeup() && !g_main_busy) {
+      stim_sequencer_service();
+    }
+    uint8_t pins = P1OUT & PINS;
+    if (pins != g_pins) {
+      g_pins = pins;
+      return time;
+    }
+  }
+}
+
+/**
+ * @brief Compare the next count output changes against the timeline
+ *
+ * @return uint16_t Changes that came at the wrong tick or with the wrong
+ *         pins; the first one is printed
+ */
+static uint16_t count_bad_edges(timeline_t *tl, uint64_t t0, uint16_t count) {
+  uint16_t bad = 0;
+  for (uint16_t i = 0; i < count; i++) {
+    uint64_t us;
+    uint8_t pins = timeline_next(tl, &us);
+    uint64_t expected = t0 + us_to_tick(us);
+    uint64_t time = next_transition();
+    if (time != expected || g_pins != pins) {
+      if (!bad) {
+        fprintf(stderr,
+                "  edge %u: pins %u at tick %llu, expected %u at %llu\n", i,
+                g_pins, (unsigned long long)time, pins,
+                (unsigned long long)expected);
+      }
+      bad++;
+    }
+  }
+  return bad;
+}
+
+/**
+ * @brief Fresh timer, sequencer started on whatever program FRAM holds
+ *
+ * The FRAM slots and boot slot carry over from earlier tests, as they do
+ * across a reset on the target.
+ */
+static void setup(void) {
+  sim_reset();
+  sim_set_isr_latency(STIM_MIN_TICKS - 1);
+  g_pins = 0;
+  g_main_busy = false;
+  stim_sequencer_start();
+  __enable_interrupt();
+}
+
+/**
+ * @brief Load a program before the first edge so it is the one started
+ *
+ * @return uint64_t Tick of the first cathodic edge
+ */
+static uint64_t start_program(const stim_program_t *program) {
+  setup();
+  CHECK(stim_program_load(program) == STIM_SUCCESS);
+  return STIM_MIN_TICKS;
+}
+
+/**
+ * @brief Checks every test ends with
+ */
+static void teardown(void) { CHECK(sim_stats()->mpy_unguarded == 0); }
+
+static void test_default_program(void) {
+  // Runs first: nothing has been loaded into FRAM yet
+  static const stim_program_t program = {
+      .step_count = 1,
+      .steps = {{.amplitude_ua = 100,
+                 .repeat = 1,
+                 .cathodic_us = 10000000UL,
+                 .anodic_us = 10000000UL}}};
+  timeline_t tl = {.program = &program};
+
+  setup();
+  CHECK(count_bad_edges(&tl, STIM_MIN_TICKS, 6) == 0);
+  CHECK(stim_active_slot() == 0);
+  CHECK(stim_amplitude_ua() == 100);
+  teardown();
+}
+
+static void test_fractional_widths(void) {
+  // Widths that are not whole ticks, with and without gap and rest. Equal
+  // cathodic and anodic widths keep the charge balanced.
+  static const stim_program_t program = {
+      .step_count = 3,
+      .steps = {{.amplitude_ua = 100,
+                 .repeat = 3,
+                 .cathodic_us = 1000,
+                 .anodic_us = 1000,
+                 .interphase_us = 100,
+                 .rest_us = 5003},
+                {.amplitude_ua = 250,
+                 .repeat = 2,
+                 .cathodic_us = 207,
+                 .anodic_us = 207,
+                 .rest_us = 2999},
+                {.amplitude_ua = 40,
+                 .repeat = 1,
+                 .cathodic_us = 333,
+                 .anodic_us = 333,
+                 .interphase_us = 77}}};
+  timeline_t tl = {.program = &program};
+
+  uint64_t t0 = start_program(&program);
+  uint16_t corrections = stim_charge_corrections();
+  CHECK(count_bad_edges(&tl, t0, 400) == 0);
+  CHECK(stim_charge_corrections() == corrections);
+  teardown();
+}
+
+static void test_long_spans(void) {
+  // Spans just past one compare's reach must not leave a final compare
+  // shorter than the ISR takes to answer
+  static const uint32_t ticks[] = {
+      MAX_CHUNK - 1,     MAX_CHUNK,         MAX_CHUNK + 1,
+      MAX_CHUNK + 2,     MAX_CHUNK + STIM_MIN_TICKS - 1,
+      MAX_CHUNK + STIM_MIN_TICKS, 2 * MAX_CHUNK + 1,
+      2 * MAX_CHUNK + STIM_MIN_TICKS - 1, 3 * MAX_CHUNK + 1};
+
+  uint16_t bad = 0;
+  for (uint8_t i = 0; i < sizeof(ticks) / sizeof(ticks[0]); i++) {
+    uint32_t us = us_for_ticks(ticks[i]);
+    stim_program_t program = {
+        .step_count = 1,
+        .steps = {{.amplitude_ua = 100,
+                   .repeat = 1,
+                   .cathodic_us = us,
+                   .anodic_us = us,
+                   .interphase_us = us,
+                   .rest_us = us}}};
+    timeline_t tl = {.program = &program};
+    uint64_t t0 = start_program(&program);
+    bad += count_bad_edges(&tl, t0, 12);
+  }
+  CHECK(bad == 0);
+  teardown();
+}
+
+static void test_program_switch(void) {
+  static const stim_program_t first = {
+      .step_count = 1,
+      .steps = {{.amplitude_ua = 100,
+                 .repeat = 2,
+                 .cathodic_us = 500,
+                 .anodic_us = 500,
+                 .interphase_us = 170,
+                 .rest_us = 1231}}};
+  static const stim_program_t second = {
+      .step_count = 1,
+      .steps = {{.amplitude_ua = 300,
+                 .repeat = 1,
+                 .cathodic_us = 777,
+                 .anodic_us = 777,
+                 .rest_us = 10001}}};
+  timeline_t tl = {.program = &first};
+
+  uint64_t t0 = start_program(&first);
+  CHECK(count_bad_edges(&tl, t0, 6) == 0);
+  uint8_t slot = stim_active_slot();
+
+  // Mid-pulse: the running pulse and the rest after it are kept
+  CHECK(stim_program_load(&second) == STIM_SUCCESS);
+  CHECK(stim_swap_pending());
+  CHECK(count_bad_edges(&tl, t0, 2) == 0);
+  CHECK(stim_active_slot() == slot);
+
+  // The second program takes over at the period boundary; remainders keep
+  // being carried, so its edges stay on the same grid
+  tl.program = &second;
+  tl.step = 0;
+  tl.pulse = 0;
+  tl.phase = 0;
+  CHECK(count_bad_edges(&tl, t0, 1) == 0);
+  CHECK(!stim_swap_pending());
+  CHECK(stim_active_slot() != slot);
+  CHECK(stim_amplitude_ua() == 300);
+  CHECK(count_bad_edges(&tl, t0, 30) == 0);
+  teardown();
+}
+
+/**
+ * @brief Net charge seen on the outputs, for comparison with the sequencer
+ */
+typedef struct {
+  int64_t net;         // Charge of the completed phases
+  int64_t worst;       // Largest |net| after a pulse
+  uint64_t start;      // Start of the phase now on the outputs
+  uint16_t amplitude;  // Amplitude of the pulse now on the outputs
+  uint16_t pulses;     // Pulses completed
+  uint16_t mismatches; // Pulses after which stim_net_charge() disagreed
+} charge_log_t;
+
+/**
+ * @brief Run pulses, integrating amplitude x width from the output edges
+ *
+ * Programs used with this need a rest after every pulse, so the sequencer
+ * has not yet accounted the next cathodic phase when one ends.
+ */
+static void run_pulses(charge_log_t *log, uint16_t count) {
+  uint16_t end = log->pulses + count;
+  while (log->pulses != end) {
+    uint8_t pins = g_pins;
+    uint64_t time = next_transition();
+    int64_t width = (int64_t)(time - log->start);
+    if (pins == BIT0) {
+      log->net -= log->amplitude * width;
+    } else if (pins == BIT1) {
+      log->net += log->amplitude * width;
+      log->pulses++;
+      if (stim_net_charge() != log->net) {
+        log->mismatches++;
+      }
+      int64_t magnitude = log->net < 0 ? -log->net : log->net;
+      if (magnitude > log->worst) {
+        log->worst = magnitude;
+      }
+    }
+    if (g_pins == BIT0) {
+      log->amplitude = stim_amplitude_ua();
+    }
+    log->start = time;
+  }
+}
+
+static void test_charge_balance(void) {
+  // Anodic phases 30% short of the cathodic ones, amplitude changing from
+  // step to step, so each fit has to be made for the step that comes next
+  static const stim_program_t program = {
+      .step_count = 2,
+      .steps = {{.amplitude_ua = 100,
+                 .repeat = 1,
+                 .cathodic_us = 1000,
+                 .anodic_us = 700,
+                 .interphase_us = 100,
+                 .rest_us = 2000},
+                {.amplitude_ua = 250,
+                 .repeat = 3,
+                 .cathodic_us = 400,
+                 .anodic_us = 280,
+                 .rest_us = 1500}}};
+  // Anodic phases 30% long, switched to mid-run
+  static const stim_program_t reversed = {
+      .step_count = 1,
+      .steps = {{.amplitude_ua = 180,
+                 .repeat = 2,
+                 .cathodic_us = 700,
+                 .anodic_us = 1000,
+                 .rest_us = 3000}}};
+  // Each phase may carry one tick the fit did not plan for
+  int64_t bound = CHARGE_LIMIT + 2 * 250;
+  charge_log_t log = {0};
+
+  start_program(&program);
+  run_pulses(&log, 200);
+  CHECK(stim_charge_corrections() > 20);
+  CHECK(stim_charge_late() == 0);
+  CHECK(log.mismatches == 0);
+  CHECK(log.worst <= bound);
+
+  CHECK(stim_program_load(&reversed) == STIM_SUCCESS);
+  stim_sequencer_service(); // As main does after every command
+  log.worst = 0;
+  run_pulses(&log, 200);
+  CHECK(stim_active_slot() != 0xFF && !stim_swap_pending());
+  CHECK(log.mismatches == 0);
+  CHECK(log.worst <= bound);
+
+  // The edges only ever add a pulse's charge up
+  CHECK(sim_stats()->wakeups == log.pulses);
+  teardown();
+}
+
+static void test_charge_catch_up(void) {
+  static const stim_program_t program = {
+      .step_count = 1,
+      .steps = {{.amplitude_ua = 100,
+                 .repeat = 1,
+                 .cathodic_us = 1000,
+                 .anodic_us = 700,
+                 .rest_us = 2000}}};
+  int64_t deficit = 100 * (int64_t)(us_to_tick(1000) - us_to_tick(700));
+  charge_log_t log = {0};
+
+  // While main is busy nothing is corrected and the deficit builds up
+  start_program(&program);
+  g_main_busy = true;
+  run_pulses(&log, 20);
+  CHECK(stim_charge_corrections() == 0);
+  CHECK(log.mismatches == 0);
+  CHECK(log.net < -18 * deficit);
+
+  // Once it services the pulses again, doubled anodic phases repay it
+  g_main_busy = false;
+  run_pulses(&log, 40);
+  CHECK(stim_charge_corrections() > 0);
+  CHECK(log.mismatches == 0);
+  log.worst = 0;
+  run_pulses(&log, 40);
+  CHECK(log.worst <= CHARGE_LIMIT + 2 * 100);
+  teardown();
+}
+
+static void test_validate(void) {
+  stim_program_t program = {
+      .step_count = 1,
+      .steps = {{.amplitude_ua = 100,
+                 .repeat = 1,
+                 .cathodic_us = us_for_ticks(STIM_MIN_TICKS),
+                 .anodic_us = us_for_ticks(STIM_MIN_TICKS)}}};
+  CHECK(stim_program_validate(&program) == STIM_SUCCESS);
+
+  program.steps[0].interphase_us = us_for_ticks(STIM_MIN_TICKS) - 1;
+  CHECK(stim_program_validate(&program) == STIM_ERROR_PARAM);
+  program.steps[0].interphase_us = 0;
+  program.steps[0].anodic_us = us_for_ticks(STIM_MIN_TICKS) - 1;
+  CHECK(stim_program_validate(&program) == STIM_ERROR_PARAM);
+#ifdef STIM_CLOCK_SMCLK
+  // Only SMCLK ticks fast enough for a width to overflow 31 bits
+  program.steps[0].anodic_us = UINT32_MAX;
+  CHECK(stim_program_validate(&program) == STIM_ERROR_PARAM);
+#endif
+  program.steps[0].anodic_us = us_for_ticks(STIM_MIN_TICKS);
+  program.steps[0].repeat = 0;
+  CHECK(stim_program_validate(&program) == STIM_ERROR_PARAM);
+  program.steps[0].repeat = 1;
+  program.step_count = 0;
+  CHECK(stim_program_validate(&program) == STIM_ERROR_PARAM);
+  program.step_count = STIM_MAX_STEPS + 1;
+  CHECK(stim_program_validate(&program) == STIM_ERROR_PARAM);
+  CHECK(stim_program_validate(NULL) == STIM_ERROR_PARAM);
+  CHECK(stim_program_load(&program) == STIM_ERROR_PARAM);
+}
+
+int main(void) {
+  test_default_program();
+  test_fractional_widths();
+  test_long_spans();
+  test_program_switch();
+  test_charge_balance();
+  test_charge_catch_up();
+  test_validate();
+
+  printf("%d checks, %d failed\n", g_checks, g_failures);
+  return g_failures ? 1 : 0;
+}
@@ -0,0 +1,592 @@
+/**
+ * @file stim_sequencer.c
+ * @brief Table-driven biphasic pulse sequencer with FRAM-resident programs
+ */
+#include "stim_sequencer.h"
+#include <msp430.h>
+#include <stddef.h> /* For NULL definition */
+
+#define CATHODIC_PIN BIT0 // P1.0, red LED
+#define ANODIC_PIN BIT1   // P1.1, green LED
+
+// Longest span one CCR0 compare can schedule
+#define MAX_CHUNK 0xFFFFUL
+
+// Net charge beyond which the next anodic phase is resized (uA ticks)
+#define CHARGE_LIMIT                                                           \
+  ((int64_t)((uint64_t)STIM_CHARGE_LIMIT_NC * STIM_CHARGE_PER_NC_NUM /         \
+             STIM_CHARGE_PER_NC_DEN))
+
+// Marks "no program running yet" so the first boundary loads one
+#define NO_SLOT 0xFF
+
+// Built-in program: the former fixed 10 s cathodic / 10 s anodic cycle
+#define DEFAULT_AMPLITUDE_UA 100
+#define DEFAULT_CATHODIC_US 10000000UL
+#define DEFAULT_ANODIC_US 10000000UL
+
+/**
+ * @brief Phase the current edge ends; indexes slot_step_t.span
+ */
+typedef enum {
+  PHASE_CATHODIC,
+  PHASE_INTERPHASE,
+  PHASE_ANODIC,
+  PHASE_REST,
+  PHASE_COUNT
+} stim_phase_t;
+
+/**
+ * @brief A width as whole ticks plus frac / STIM_TICK_DEN of a tick
+ */
+typedef struct {
+  uint32_t ticks;
+  uint16_t frac;
+} span_t;
+
+// Compile-time version of us_to_span(), for the built-in program
+#define SPAN(us)                                                               \
+  {                                                                            \
+    .ticks = (us) / STIM_TICK_DEN * STIM_TICK_NUM +                            \
+             (us) % STIM_TICK_DEN * STIM_TICK_NUM / STIM_TICK_DEN,             \
+    .frac = (us) % STIM_TICK_DEN * STIM_TICK_NUM % STIM_TICK_DEN               \
+  }
+
+// 2^32 / amplitude, rounded down, so the ISR can divide by multiplying
+#define AMPLITUDE_RECIP(ua) ((ua) ? 0xFFFFFFFFUL / (ua) : 0)
+
+/**
+ * @brief A step as stored in a slot, converted for the ISR
+ */
+typedef struct {
+  uint16_t amplitude_ua;
+  uint16_t repeat;
+  uint32_t amplitude_recip; // AMPLITUDE_RECIP(amplitude_ua)
+  span_t span[PHASE_COUNT];
+} slot_step_t;
+
+typedef struct {
+  uint16_t step_count;
+  slot_step_t steps[STIM_MAX_STEPS];
+} slot_program_t;
+
+// Program slots in FRAM, kept across reset. Slot 0 starts with the default.
+#if defined(__TI_COMPILER_VERSION__)
+#pragma PERSISTENT(g_programs)
+#elif defined(__IAR_SYSTEMS_ICC__)
+__persistent
+#elif defined(__GNUC__)
+__attribute__((persistent))
+#endif
+static slot_program_t g_programs[2] = {
+    {.step_count = 1,
+     .steps = {{.amplitude_ua = DEFAULT_AMPLITUDE_UA,
+                .repeat = 1,
+                .amplitude_recip = AMPLITUDE_RECIP(DEFAULT_AMPLITUDE_UA),
+                .span = {[PHASE_CATHODIC] = SPAN(DEFAULT_CATHODIC_US),
+                         [PHASE_ANODIC] = SPAN(DEFAULT_ANODIC_US)}}}}};
+
+// Slot started after reset; written after the slot's contents
+#if defined(__TI_COMPILER_VERSION__)
+#pragma PERSISTENT(g_boot_slot)
+#elif defined(__IAR_SYSTEMS_ICC__)
+__persistent
+#elif defined(__GNUC__)
+__attribute__((persistent))
+#endif
+static uint8_t g_boot_slot = 0;
+
+// Sequencer state, owned by the Timer0_A3 CCR0 ISR
+static volatile uint8_t g_active = NO_SLOT;
+static volatile uint8_t g_pending = NO_SLOT;
+static const slot_step_t *volatile g_step;
+static uint16_t g_step_index;
+static uint16_t g_repeat_left;
+static uint32_t g_remaining; // Ticks of the current span not yet scheduled
+static uint16_t g_carry;     // Sum of span remainders, < STIM_TICK_DEN
+static stim_phase_t g_phase;
+static int64_t g_net_charge; // uA ticks, anodic positive
+static uint16_t g_corrections;
+static volatile uint16_t g_pulse;       // Anodic phases started
+static volatile bool g_fit_due;         // Main has a pulse to fit
+// Anodic width stim_sequencer_service() fitted for pulse g_fit_pulse,
+// valid while g_fit_step is not NULL
+static const slot_step_t *volatile g_fit_step;
+static uint16_t g_fit_pulse;
+static uint32_t g_fit_ticks;
+static uint16_t g_late_fits;
+
+#ifdef STIM_INSTRUMENT
+// Interrupt entry and RETI, which the timestamps inside the ISR miss
+#define ISR_OVERHEAD_CYCLES 11
+
+static uint16_t g_isr_max_cycles;
+static uint16_t g_service_max_cycles;
+#endif
+
+/**
+ * @brief Convert microseconds to ticks with the remainder kept, no rounding
+ *
+ * @return bool false if the tick count does not fit 31 bits, which leaves
+ *         room for the charge correction to double a phase
+ */
+static bool us_to_span(uint32_t us, span_t *span) {
+  // us * NUM / DEN, split so neither product overflows 32 bits
+  uint32_t whole = us / STIM_TICK_DEN;
+  uint32_t part = us % STIM_TICK_DEN * STIM_TICK_NUM;
+  if (whole > (INT32_MAX - STIM_TICK_NUM) / STIM_TICK_NUM) {
+    return false;
+  }
+  span->ticks = whole * STIM_TICK_NUM + part / STIM_TICK_DEN;
+  span->frac = (uint16_t)(part % STIM_TICK_DEN);
+  return true;
+}
+
+/**
+ * @brief Check one width; zero passes only where the phase is optional
+ */
+static bool width_valid(uint32_t us, bool optional) {
+  span_t span;
+  if (!us_to_span(us, &span)) {
+    return false;
+  }
+  return (optional && us == 0) || span.ticks >= STIM_MIN_TICKS;
+}
+
+stim_status_t stim_program_validate(const stim_program_t *program) {
+  if (!program || program->step_count == 0 ||
+      program->step_count > STIM_MAX_STEPS) {
+    return STIM_ERROR_PARAM;
+  }
+
+  for (uint16_t i = 0; i < program->step_count; i++) {
+    const stim_step_t *step = &program->steps[i];
+    if (step->repeat == 0 || !width_valid(step->cathodic_us, false) ||
+        !width_valid(step->interphase_us, true) ||
+        !width_valid(step->anodic_us, false) ||
+        !width_valid(step->rest_us, true)) {
+      return STIM_ERROR_PARAM;
+    }
+  }
+
+  return STIM_SUCCESS;
+}
+
+/**
+ * @brief Check a stored slot against the rules stim_program_validate()
+ *        applied to its source, in case the FRAM contents are damaged
+ */
+static bool slot_valid(const slot_program_t *program) {
+  if (program->step_count == 0 || program->step_count > STIM_MAX_STEPS) {
+    return false;
+  }
+
+  for (uint16_t i = 0; i < program->step_count; i++) {
+    const slot_step_t *step = &program->steps[i];
+    if (step->repeat == 0 ||
+        step->amplitude_recip != AMPLITUDE_RECIP(step->amplitude_ua)) {
+      return false;
+    }
+    for (uint8_t phase = 0; phase < PHASE_COUNT; phase++) {
+      const span_t *span = &step->span[phase];
+      bool optional = phase == PHASE_INTERPHASE || phase == PHASE_REST;
+      if (span->frac >= STIM_TICK_DEN || span->ticks > INT32_MAX ||
+          !((optional && span->ticks == 0 && span->frac == 0) ||
+            span->ticks >= STIM_MIN_TICKS)) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+/**
+ * @brief Program the next CCR0 compare, at most MAX_CHUNK ticks ahead
+ *
+ * Every chunk lasts at least STIM_MIN_TICKS, so the ISR that schedules
+ * the next one always gets there before the timer passes it: a span just
+ * over MAX_CHUNK is split so the last chunk is STIM_MIN_TICKS long.
+ */
+static inline void schedule_chunk(void) {
+  uint16_t chunk;
+  if (g_remaining <= MAX_CHUNK) {
+    chunk = (uint16_t)g_remaining;
+  } else if (g_remaining - MAX_CHUNK < STIM_MIN_TICKS) {
+    chunk = (uint16_t)(g_remaining - STIM_MIN_TICKS);
+  } else {
+    chunk = (uint16_t)MAX_CHUNK;
+  }
+  g_remaining -= chunk;
+  TA0CCR0 += chunk;
+}
+
+// The charge arithmetic below drives MPY32 directly. The ISR only uses
+// phase_charge(); the compiler's own multiply helpers run with interrupts
+// disabled, so it cannot catch the multiplier half way through one of
+// their operations. stim_sequencer_service() runs in main and holds
+// interrupts off around each of its own multiplications instead.
+
+/**
+ * @brief Charge of one phase: amplitude x ticks, 16 x 32 bits on MPY32
+ */
+static inline int64_t phase_charge(uint16_t amplitude_ua, uint32_t ticks) {
+  union {
+    int64_t value;
+    uint16_t word[4];
+  } charge;
+
+  MPY = amplitude_ua;
+  OP2L = (uint16_t)ticks;
+  OP2H = (uint16_t)(ticks >> 16); // Starts the multiplication
+  charge.word[0] = RES0;
+  charge.word[1] = RES1;
+  charge.word[2] = RES2;
+  charge.word[3] = 0;
+  return charge.value;
+}
+
+/**
+ * @brief Ticks that carry a given charge at a step's amplitude
+ *
+ * Multiplies by the stored reciprocal instead of dividing: charge x
+ * (2^32 / amplitude) / 2^32, 32 x 32 bits on MPY32. Saturates once the
+ * charge no longer fits 32 bits; the caller clamps the result anyway.
+ */
+static uint32_t charge_ticks(const slot_step_t *step, uint64_t charge) {
+  if (charge > UINT32_MAX) {
+    return UINT32_MAX;
+  }
+
+  uint16_t gie = __get_interrupt_state();
+  __disable_interrupt();
+  MPY32L = (uint16_t)charge;
+  MPY32H = (uint16_t)(charge >> 16);
+  OP2L = (uint16_t)step->amplitude_recip;
+  OP2H = (uint16_t)(step->amplitude_recip >> 16); // Starts it
+  uint32_t ticks = ((uint32_t)RES3 << 16) | RES2;
+  __set_interrupt_state(gie);
+  return ticks;
+}
+
+/**
+ * @brief Fit the anodic phase of a pulse to the charge it leaves
+ *
+ * Keeps the programmed width while the net charge after the pulse stays
+ * within CHARGE_LIMIT. Otherwise the width is chosen to bring the net
+ * charge back to zero, clamped to [STIM_MIN_TICKS, 2 x programmed width].
+ * The pulse's carry ticks are left out; they stay within one tick a phase.
+ *
+ * @param step Step the pulse belongs to
+ * @param net Net charge so far
+ * @param started true if net already includes the pulse's cathodic phase
+ * @param fit Width to schedule, before the carry tick
+ * @return bool false if the programmed width is kept
+ */
+static bool fit_anodic(const slot_step_t *step, int64_t net, bool started,
+                       uint32_t *fit) {
+  uint32_t ticks = step->span[PHASE_ANODIC].ticks;
+  uint16_t amplitude = step->amplitude_ua;
+
+  uint16_t gie = __get_interrupt_state();
+  __disable_interrupt();
+  int64_t after = net + phase_charge(amplitude, ticks);
+  __set_interrupt_state(gie);
+  if (!started) {
+    __disable_interrupt();
+    after -= phase_charge(amplitude, step->span[PHASE_CATHODIC].ticks);
+    __set_interrupt_state(gie);
+  }
+
+  if ((after <= CHARGE_LIMIT && after >= -CHARGE_LIMIT) || !amplitude) {
+    return false;
+  }
+  if (after > 0) {
+    uint32_t excess = charge_ticks(step, (uint64_t)after);
+    ticks = (excess < ticks - STIM_MIN_TICKS) ? ticks - excess
+                                               : STIM_MIN_TICKS;
+  } else {
+    uint32_t shortfall = charge_ticks(step, (uint64_t)-after);
+    ticks += (shortfall < ticks) ? shortfall : ticks;
+  }
+  *fit = ticks;
+  return true;
+}
+
+/**
+ * @brief Step the next period will run, as start_period() will pick it
+ *
+ * Call with interrupts disabled.
+ */
+static const slot_step_t *next_step(void) {
+  if (g_pending != g_active) {
+    return &g_programs[g_pending].steps[0];
+  }
+  if (g_repeat_left > 1) {
+    return g_step;
+  }
+  uint16_t index = g_step_index + 1;
+  if (index >= g_programs[g_active].step_count) {
+    index = 0;
+  }
+  return &g_programs[g_active].steps[index];
+}
+
+/**
+ * @brief Record the phase now on the outputs and schedule its end
+ *
+ * The span's remainder is added to the carry; each time the carry reaches
+ * a whole tick, this span is lengthened by one. An anodic phase takes the
+ * width fitted for it, if stim_sequencer_service() got there in time. The
+ * compare is written before the phase is added to the net charge, so a
+ * phase as short as STIM_MIN_TICKS never has its edge scheduled late.
+ */
+static inline void enter_phase(stim_phase_t phase) {
+  const span_t *span = &g_step->span[phase];
+  uint32_t ticks = span->ticks;
+  if (phase == PHASE_ANODIC) {
+    g_pulse++;
+    if (g_fit_step == g_step && g_fit_pulse == g_pulse) {
+      ticks = g_fit_ticks;
+      g_corrections++;
+    }
+    g_fit_step = NULL;
+  }
+  g_carry += span->frac;
+  if (g_carry >= STIM_TICK_DEN) {
+    g_carry -= STIM_TICK_DEN;
+    ticks++;
+  }
+
+  g_phase = phase;
+  g_remaining = ticks;
+  schedule_chunk();
+
+  if (phase == PHASE_CATHODIC) {
+    g_net_charge -= phase_charge(g_step->amplitude_ua, ticks);
+  } else if (phase == PHASE_ANODIC) {
+    g_net_charge += phase_charge(g_step->amplitude_ua, ticks);
+    g_fit_due = true;
+  }
+}
+
+/**
+ * @brief Period boundary: pick the next step and start its cathodic phase
+ *
+ * The only place a pending program is switched in.
+ */
+static inline void start_period(void) {
+  if (g_pending != g_active) {
+    g_active = g_pending;
+    g_step_index = 0;
+    g_step = &g_programs[g_active].steps[0];
+    g_repeat_left = g_step->repeat;
+  } else if (--g_repeat_left == 0) {
+    if (++g_step_index >= g_programs[g_active].step_count) {
+      g_step_index = 0;
+    }
+    g_step = &g_programs[g_active].steps[g_step_index];
+    g_repeat_left = g_step->repeat;
+  }
+
+  P1OUT |= CATHODIC_PIN;
+  enter_phase(PHASE_CATHODIC);
+}
+
+void stim_sequencer_start(void) {
+  uint8_t slot = g_boot_slot;
+  if (slot > 1 || !slot_valid(&g_programs[slot])) {
+    slot = 0;
+    if (!slot_valid(&g_programs[0])) {
+      return; // Both slots corrupt; stay idle rather than emit garbage
+    }
+  }
+
+  P1OUT &= ~(CATHODIC_PIN | ANODIC_PIN);
+  g_active = NO_SLOT;
+  g_pending = slot;
+
+  // First compare ends a short rest, so the first edge runs the
+  // period-boundary path and loads the program
+  g_phase = PHASE_REST;
+  g_remaining = 0;
+  g_carry = 0;
+  g_net_charge = 0;
+  g_corrections = 0;
+  g_late_fits = 0;
+  g_fit_due = false;
+  g_fit_step = NULL;
+#ifdef STIM_INSTRUMENT
+  TA1CTL = TASSEL__SMCLK | MC__CONTINUOUS | TACLR; // Cycle counter, = MCLK
+#endif
+  TA0CCR0 = STIM_MIN_TICKS;
+  TA0CCTL0 = CCIE;
+  TA0CTL = STIM_TASSEL | MC__CONTINUOUS | TACLR; // Continuous mode
+}
+
+stim_status_t stim_program_load(const stim_program_t *program) {
+  if (stim_program_validate(program) != STIM_SUCCESS) {
+    return STIM_ERROR_PARAM;
+  }
+
+  // Withdraw any pending switch so the ISR cannot move onto the slot while
+  // it is being written, then take the slot that is not running. Before the
+  // first edge the slot about to start counts as running.
+  uint16_t gie = __get_interrupt_state();
+  __disable_interrupt();
+  uint8_t running = (g_active == NO_SLOT) ? g_pending : g_active;
+  g_pending = running;
+  g_fit_step = NULL; // May point into the slot about to be rewritten
+  uint8_t slot = (running == 0) ? 1 : 0;
+  __set_interrupt_state(gie);
+
+  // Lift FRAM write protection for the persistent slots
+  uint16_t fram_state = SYSCFG0 & (PFWP | DFWP);
+  SYSCFG0 = FRWPPW;
+  slot_program_t *dest = &g_programs[slot];
+  dest->step_count = program->step_count;
+  for (uint16_t i = 0; i < program->step_count; i++) {
+    const stim_step_t *src = &program->steps[i];
+    slot_step_t *step = &dest->steps[i];
+    step->amplitude_ua = src->amplitude_ua;
+    step->repeat = src->repeat;
+    step->amplitude_recip = AMPLITUDE_RECIP(src->amplitude_ua);
+    // Cannot fail: the widths were validated above
+    us_to_span(src->cathodic_us, &step->span[PHASE_CATHODIC]);
+    us_to_span(src->interphase_us, &step->span[PHASE_INTERPHASE]);
+    us_to_span(src->anodic_us, &step->span[PHASE_ANODIC]);
+    us_to_span(src->rest_us, &step->span[PHASE_REST]);
+  }
+  g_boot_slot = slot;
+  SYSCFG0 = FRWPPW | fram_state;
+
+  g_pending = slot;
+  g_fit_due = g_active != NO_SLOT; // Fit again, the next pulse may be ours
+  return STIM_SUCCESS;
+}
+
+uint8_t stim_active_slot(void) { return g_active; }
+
+bool stim_swap_pending(void) { return g_pending != g_active; }
+
+uint16_t stim_amplitude_ua(void) {
+  const slot_step_t *step = g_step;
+  return step ? step->amplitude_ua : 0;
+}
+
+int64_t stim_net_charge(void) {
+  uint16_t gie = __get_interrupt_state();
+  __disable_interrupt();
+  int64_t charge = g_net_charge;
+  __set_interrupt_state(gie);
+  return charge;
+}
+
+uint16_t stim_charge_corrections(void) { return g_corrections; }
+
+uint16_t stim_charge_late(void) { return g_late_fits; }
+
+bool stim_service_pending(void) { return g_fit_due; }
+
+void stim_sequencer_service(void) {
+  if (!g_fit_due) {
+    return;
+  }
+
+#ifdef STIM_INSTRUMENT
+  uint16_t start = TA1R;
+#endif
+
+  // Fit the pulse whose anodic edge comes next: the one on the outputs
+  // until that edge, the next period's after it. Phases are accounted as
+  // soon as their edges are scheduled.
+  uint16_t gie = __get_interrupt_state();
+  __disable_interrupt();
+  g_fit_due = false;
+  uint16_t pulse = g_pulse + 1;
+  bool started = g_phase == PHASE_CATHODIC || g_phase == PHASE_INTERPHASE;
+  const slot_step_t *step = started ? g_step : next_step();
+  int64_t net = g_net_charge;
+  __set_interrupt_state(gie);
+
+  uint32_t ticks;
+  if (fit_anodic(step, net, started, &ticks)) {
+    __disable_interrupt();
+    if (g_pulse + 1 == pulse) {
+      g_fit_pulse = pulse;
+      g_fit_ticks = ticks;
+      g_fit_step = step;
+    } else {
+      g_late_fits++; // Its anodic phase has already started
+    }
+    __set_interrupt_state(gie);
+  }
+
+#ifdef STIM_INSTRUMENT
+  // Includes any edge ISR that ran meanwhile
+  uint16_t cycles = (uint16_t)(TA1R - start);
+  if (cycles > g_service_max_cycles) {
+    g_service_max_cycles = cycles;
+  }
+#endif
+}
+
+#ifdef STIM_INSTRUMENT
+uint16_t stim_isr_max_cycles(void) { return g_isr_max_cycles; }
+
+uint16_t stim_service_max_cycles(void) { return g_service_max_cycles; }
+#endif
+
+// Timer0_A3 CCR0: one call per edge, or per MAX_CHUNK ticks of a long span
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector = TIMER0_A0_VECTOR
+__interrupt void TIMER0_A0_ISR(void)
+#elif defined(__GNUC__)
+void __attribute__((interrupt(TIMER0_A0_VECTOR))) TIMER0_A0_ISR(void)
+#else
+#error Compiler not supported!
+#endif
+{
+#ifdef STIM_INSTRUMENT
+  uint16_t start = TA1R;
+#endif
+
+  if (g_remaining) {
+    schedule_chunk();
+  } else {
+    switch (g_phase) {
+    case PHASE_CATHODIC:
+      P1OUT &= ~CATHODIC_PIN;
+      if (g_step->span[PHASE_INTERPHASE].ticks) {
+        enter_phase(PHASE_INTERPHASE);
+        break;
+      }
+      // Fall through - no gap, straight into the anodic phase
+    case PHASE_INTERPHASE:
+      P1OUT |= ANODIC_PIN;
+      enter_phase(PHASE_ANODIC);
+      __bic_SR_register_on_exit(STIM_LPM_BITS); // Main fits the next pulse
+      break;
+    case PHASE_ANODIC:
+      P1OUT &= ~ANODIC_PIN;
+      if (g_step->span[PHASE_REST].ticks) {
+        enter_phase(PHASE_REST);
+        break;
+      }
+      start_period();
+      break;
+    case PHASE_REST:
+      start_period();
+      break;
+    default:
+      break;
+    }
+  }
+
+#ifdef STIM_INSTRUMENT
+  uint16_t cycles = (uint16_t)(TA1R - start) + ISR_OVERHEAD_CYCLES;
+  if (cycles > g_isr_max_cycles) {
+    g_isr_max_cycles = cycles;
+  }
+#endif
+}
@@ -0,0 +1,215 @@
+/**
+ * @file stim_sequencer.h
+ * @brief Table-driven biphasic pulse sequencer with FRAM-resident programs
+ *
+ * A program is a list of steps. Each step emits `repeat` biphasic pulses:
+ * cathodic phase (P1.0), interphase gap, anodic phase (P1.1), rest. After
+ * the last step the program starts over. Every edge is one Timer0_A3 CCR0
+ * compare (continuous mode), and the ISR does constant work per edge.
+ *
+ * The timer clock is chosen at build time. ACLK (default) ticks at 32768Hz,
+ * about 30.5us, and lets the CPU sleep in LPM3 between edges. Defining
+ * STIM_CLOCK_SMCLK runs the timer from SMCLK (4MHz, 0.25us) for kHz-rate
+ * protocols; SMCLK stops in LPM3, so the CPU then sleeps in LPM0.
+ *
+ * Widths are given in microseconds. They are converted to whole ticks plus
+ * a remainder, and the remainders are carried from edge to edge, so edges
+ * never drift from the requested times by more than one tick.
+ *
+ * Delivered charge is integrated at every phase edge (amplitude x width,
+ * cathodic negative), after the edge's compare is written. If a pulse
+ * would leave the net charge beyond STIM_CHARGE_LIMIT_NC, its anodic phase
+ * is lengthened or shortened to bring it back to zero, within
+ * [STIM_MIN_TICKS, twice its programmed width]. That width is worked out
+ * by stim_sequencer_service() in main, woken at each anodic edge to fit
+ * the pulse after it (and after stim_program_load(), in case that pulse
+ * now comes from the new program), so the edge ISR only ever does one
+ * multiplication.
+ * A fit that is not ready by its anodic edge is dropped and the next
+ * pulse corrects instead (stim_charge_late()).
+ *
+ * Building with STIM_INSTRUMENT times the edge ISR and the service on
+ * Timer1_A3 (SMCLK = MCLK) and keeps the worst case of each.
+ *
+ * Two program slots live in FRAM and survive reset. stim_program_load()
+ * writes the inactive slot and the sequencer switches over at the next
+ * period boundary (the end of a rest), so a pulse is never cut short.
+ */
+#ifndef STIM_SEQUENCER_H
+#define STIM_SEQUENCER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined(STIM_CLOCK_SMCLK)
+/**
+ * @brief Timer clock: SMCLK = DCODIV = 4MHz, undivided (ulf_current.c)
+ */
+#define STIM_TICK_HZ 4000000UL
+#define STIM_TICK_NUM 4UL // Ticks per STIM_TICK_DEN microseconds
+#define STIM_TICK_DEN 1UL
+#define STIM_TASSEL TASSEL__SMCLK
+#define STIM_MIN_TICKS 200 // Covers ISR latency at MCLK = 4MHz
+#define STIM_LPM_BITS LPM0_bits
+#else
+/**
+ * @brief Timer clock: ACLK = REFO
+ */
+#define STIM_TICK_HZ 32768UL
+#define STIM_TICK_NUM 512UL // 32768 / 1e6, reduced
+#define STIM_TICK_DEN 15625UL
+#define STIM_TASSEL TASSEL__ACLK
+#define STIM_MIN_TICKS 2
+#define STIM_LPM_BITS LPM3_bits
+#endif
+
+/**
+ * @brief Steps per program
+ */
+#define STIM_MAX_STEPS 16
+
+/**
+ * @brief Net charge the sequencer tolerates before correcting (nC)
+ */
+#ifndef STIM_CHARGE_LIMIT_NC
+#define STIM_CHARGE_LIMIT_NC 50
+#endif
+
+/**
+ * @brief stim_net_charge() units (1 uA for one timer tick) per nC, as
+ *        NUM / DEN so ACLK's 32.768 is not truncated
+ */
+#define STIM_CHARGE_PER_NC_NUM STIM_TICK_HZ
+#define STIM_CHARGE_PER_NC_DEN 1000UL
+
+/**
+ * @brief Sequencer status codes
+ */
+typedef enum {
+    STIM_SUCCESS = 0,
+    STIM_ERROR_PARAM = -1
+} stim_status_t;
+
+/**
+ * @brief One program step
+ *
+ * Durations are in microseconds. The interphase gap and rest may be zero;
+ * every other width must last at least STIM_MIN_TICKS timer ticks.
+ */
+typedef struct {
+    uint16_t amplitude_ua;  // Phase amplitude for the current driver (µA)
+    uint16_t repeat;        // Biphasic pulses before the next step, >= 1
+    uint32_t cathodic_us;   // Cathodic phase width
+    uint32_t anodic_us;     // Anodic phase width
+    uint32_t interphase_us; // Both outputs off between the phases
+    uint32_t rest_us;       // Both outputs off after the anodic phase
+} stim_step_t;
+
+/**
+ * @brief A pulse program
+ */
+typedef struct {
+    uint16_t step_count;    // Steps in use, 1..STIM_MAX_STEPS
+    stim_step_t steps[STIM_MAX_STEPS];
+} stim_program_t;
+
+/**
+ * @brief Check a program before it is loaded
+ *
+ * @return stim_status_t STIM_ERROR_PARAM if the step count or a repeat
+ *         count is zero, the step count is too large, or a width is shorter
+ *         than STIM_MIN_TICKS or does not fit the timer range
+ */
+stim_status_t stim_program_validate(const stim_program_t *program);
+
+/**
+ * @brief Start Timer0_A3 on the program that was active before reset
+ *
+ * Falls back to the built-in default program if the stored one is invalid.
+ * P1.0 and P1.1 must already be outputs. Needs GIE, and the CPU must not
+ * sleep deeper than STIM_LPM_BITS.
+ */
+void stim_sequencer_start(void);
+
+/**
+ * @brief Store a program in the inactive FRAM slot and switch to it
+ *
+ * The switch happens at the next period boundary. The new program is also
+ * the one started after a reset. Loading again before the switch replaces
+ * the pending program. Must not be called from interrupt context.
+ *
+ * @param program Program to copy
+ * @return stim_status_t STIM_ERROR_PARAM if the program is invalid
+ */
+stim_status_t stim_program_load(const stim_program_t *program);
+
+/**
+ * @brief FRAM slot the sequencer is running (0 or 1, 0xFF before the
+ *        first edge)
+ */
+uint8_t stim_active_slot(void);
+
+/**
+ * @brief True while a loaded program waits for the period boundary
+ */
+bool stim_swap_pending(void);
+
+/**
+ * @brief Amplitude of the step being emitted (µA)
+ *
+ * The LED outputs on this board only show the phase; a current driver
+ * reads the amplitude from here.
+ */
+uint16_t stim_amplitude_ua(void);
+
+/**
+ * @brief Net charge delivered since stim_sequencer_start(), anodic positive
+ *
+ * @return int64_t Charge in uA ticks; multiply by STIM_CHARGE_PER_NC_DEN
+ *         and divide by STIM_CHARGE_PER_NC_NUM for nC
+ */
+int64_t stim_net_charge(void);
+
+/**
+ * @brief Anodic phases resized since stim_sequencer_start() to restore
+ *        charge balance
+ */
+uint16_t stim_charge_corrections(void);
+
+/**
+ * @brief Corrections dropped since stim_sequencer_start() because
+ *        stim_sequencer_service() finished after their anodic edge
+ */
+uint16_t stim_charge_late(void);
+
+/**
+ * @brief Fit the next pulse's anodic phase to the net charge
+ *
+ * Call from main whenever the CPU wakes and after stim_program_load().
+ * The edge ISR wakes it once per pulse; the fit must be done before the
+ * next pulse's anodic edge. Does nothing unless stim_service_pending().
+ * Must not be called from interrupt context.
+ */
+void stim_sequencer_service(void);
+
+/**
+ * @brief True while a pulse waits for stim_sequencer_service()
+ *
+ * Check with interrupts disabled before going to sleep.
+ */
+bool stim_service_pending(void);
+
+#ifdef STIM_INSTRUMENT
+/**
+ * @brief Longest edge ISR so far in MCLK cycles, entry and RETI included
+ */
+uint16_t stim_isr_max_cycles(void);
+
+/**
+ * @brief Longest stim_sequencer_service() call so far in MCLK cycles,
+ *        including edge ISRs that ran during it
+ */
+uint16_t stim_service_max_cycles(void);
+#endif
+
+#endif
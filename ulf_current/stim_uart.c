@@ -0,0 +1,82 @@
+/**
+ * @file stim_uart.c
+ * @brief Line-oriented backchannel UART (eUSCI_A0, P1.4 TXD / P1.5 RXD)
+ */
+#include "stim_uart.h"
+#include <msp430.h>
+#include <stddef.h> /* For NULL definition */
+#include <stdint.h>
+
+static char g_line[STIM_UART_LINE_SIZE + 1];
+static uint8_t g_length;
+static volatile bool g_ready;
+static bool g_overflow;
+
+void stim_uart_init(void) {
+  // Configure UCA0TXD and UCA0RXD
+  P1SEL0 |= BIT4 | BIT5;
+  P1SEL1 &= ~(BIT4 | BIT5);
+
+  // 9600 baud from ACLK = 32768Hz: UCBR = 3, UCBRS = 0x92, no oversampling
+  // http://software-dl.ti.com/msp430/msp430_public_sw/mcu/msp430/MSP430BaudRateConverter/index.html
+  UCA0CTLW0 = UCSWRST | UCSSEL__ACLK;
+  UCA0BRW = 3;
+  UCA0MCTLW = 0x9200;
+  UCA0CTLW0 &= ~UCSWRST;
+
+  UCA0IE |= UCRXIE;
+}
+
+const char *stim_uart_line(void) { return g_ready ? g_line : NULL; }
+
+void stim_uart_release(void) {
+  g_length = 0;
+  g_overflow = false;
+  g_ready = false;
+}
+
+void stim_uart_puts(const char *s) {
+  while (*s) {
+    while (!(UCA0IFG & UCTXIFG))
+      ;
+    UCA0TXBUF = *s++;
+  }
+}
+
+// USCI_A0 interrupt handler: collects characters until end of line
+#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
+#pragma vector = USCI_A0_VECTOR
+__interrupt void USCI_A0_ISR(void)
+#elif defined(__GNUC__)
+void __attribute__((interrupt(USCI_A0_VECTOR))) USCI_A0_ISR(void)
+#else
+#error Compiler not supported!
+#endif
+{
+  switch (__even_in_range(UCA0IV, USCI_UART_UCTXCPTIFG)) {
+  case USCI_NONE:
+    break;
+  case USCI_UART_UCRXIFG: {
+    char c = UCA0RXBUF; // Reading RXBUF clears UCRXIFG
+    if (g_ready) {
+      break; // Previous line not handled yet; drop
+    }
+    if (c == '\r' || c == '\n') {
+      if (g_length == 0) {
+        break; // Blank line, or the second half of CR LF
+      }
+      // An over-long line is passed on empty so it is rejected
+      g_line[g_overflow ? 0 : g_length] = '\0';
+      g_ready = true;
+      __bic_SR_register_on_exit(LPM3_bits); // Wake main to handle it
+    } else if (g_length < STIM_UART_LINE_SIZE) {
+      g_line[g_length++] = c;
+    } else {
+      g_overflow = true;
+    }
+    break;
+  }
+  default:
+    break;
+  }
+}
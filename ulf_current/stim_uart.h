@@ -0,0 +1,41 @@
+/**
+ * @file stim_uart.h
+ * @brief Line-oriented backchannel UART (eUSCI_A0, P1.4 TXD / P1.5 RXD)
+ *
+ * 9600 baud, 8N1, clocked from ACLK so characters are received while the
+ * CPU sleeps in LPM3. The RX interrupt collects one line at a time and
+ * wakes the CPU when it is complete.
+ */
+#ifndef STIM_UART_H
+#define STIM_UART_H
+
+#include <stdbool.h>
+
+/**
+ * @brief Longest command line, excluding the terminator
+ */
+#define STIM_UART_LINE_SIZE 80
+
+/**
+ * @brief Configure the pins and eUSCI_A0; enables the RX interrupt
+ */
+void stim_uart_init(void);
+
+/**
+ * @brief Line received and not yet released, NUL-terminated
+ *
+ * @return const char* NULL while no complete line is waiting
+ */
+const char *stim_uart_line(void);
+
+/**
+ * @brief Hand the line buffer back to the RX interrupt
+ */
+void stim_uart_release(void);
+
+/**
+ * @brief Send a string, busy-waiting per character
+ */
+void stim_uart_puts(const char *s);
+
+#endif
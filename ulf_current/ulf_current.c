@@ -1,10 +1,28 @@
 //******************************************************************************
-//  MSP430FR24xx Timer-based Waveform Generator with Adjustable On-Times
+//  MSP430FR24xx Timer-based Waveform Generator with Programmable Pulse Trains
 //
 //  Description: Generate complementary waveforms on P1.0 (red LED, cathodic)
-//  and P1.1 (green LED, anodic) with adjustable on-times for each phase.
+//  and P1.1 (green LED, anodic). The pulse train is a program held in FRAM
+//  (see stim_sequencer.h): each step sets the amplitude, cathodic and anodic
+//  widths, interphase gap, repetition count and rest period. A new program
+//  can be sent over the backchannel UART (9600 8N1) at any time; it takes
+//  over at the next period boundary and survives reset.
 //
-//  ACLK = TACLK = 32768Hz, MCLK = SMCLK = 8MHz/2
+//  UART commands, one per line, answered with OK or ERR:
+//    C                              clear the program being assembled
+//    S <ua> <cath> <anod> <gap> <n> <rest>
+//                                   append a step; widths in microseconds
+//    G                              load the assembled program
+//    ?                              report running slot, steps staged,
+//                                   charge-balance corrections made and
+//                                   dropped, and whether a switch is
+//                                   pending; STIM_INSTRUMENT builds add
+//                                   the worst edge ISR and fit in cycles
+//
+//  Edges are timed from ACLK = 32768Hz by default; build with
+//  STIM_CLOCK=smclk to time them from SMCLK for kHz-rate pulse trains.
+//
+//  ACLK = 32768Hz, MCLK = SMCLK = 8MHz/2
 //
 //                MSP430FR2433
 //             -----------------
@@ -14,25 +32,117 @@
 //            |                 |
 //            |             P1.0|--> RED LED (Cathodic)
 //            |             P1.1|--> GREEN LED (Anodic)
+//            |             P1.4|--> UCA0TXD (backchannel)
+//            |             P1.5|<-- UCA0RXD (backchannel)
 //
 //  Mohamed Elazab
 //  MetroHealth Research Institute
 //  Apr 2025
 //******************************************************************************/
+#include "stim_sequencer.h"
+#include "stim_uart.h"
 #include <msp430.h>
+#include <stddef.h> /* For NULL definition */
 
-// Define timing constants (adjust these values as needed)
+// Program assembled from UART commands until 'G'
+static stim_program_t g_staging;
 
-#define CATHODIC_PW 10
-#define ANODIC_PW 10
+/**
+ * @brief Parse a space-separated unsigned decimal number
+ *
+ * @return const char* Position after the number, NULL if there is none
+ */
+static const char *parse_u32(const char *s, uint32_t *value) {
+  while (*s == ' ') {
+    s++;
+  }
+  if (*s < '0' || *s > '9') {
+    return NULL;
+  }
 
-#define SCALING_FACTOR 0.5
-#define CATHODIC_ON_TIME ((CATHODIC_PW) * (SCALING_FACTOR))
-#define ANODIC_ON_TIME ((ANODIC_PW) * (SCALING_FACTOR))
+  uint32_t v = 0;
+  while (*s >= '0' && *s <= '9') {
+    uint32_t next = v * 10 + (uint32_t)(*s - '0');
+    if (next / 10 != v) {
+      return NULL; // Overflow
+    }
+    v = next;
+    s++;
+  }
+  *value = v;
+  return s;
+}
 
-// Global variables
-volatile unsigned int counter = 0;
-volatile unsigned char currentPhase = 0;
+/**
+ * @brief Parse "S <ua> <cath> <anod> <gap> <n> <rest>" into a step
+ */
+static bool parse_step(const char *s, stim_step_t *step) {
+  uint32_t field[6];
+  for (uint8_t i = 0; i < 6; i++) {
+    s = parse_u32(s, &field[i]);
+    if (!s) {
+      return false;
+    }
+  }
+  if (*s != '\0' || field[0] > 0xFFFF || field[4] > 0xFFFF) {
+    return false;
+  }
+
+  step->amplitude_ua = (uint16_t)field[0];
+  step->cathodic_us = field[1];
+  step->anodic_us = field[2];
+  step->interphase_us = field[3];
+  step->repeat = (uint16_t)field[4];
+  step->rest_us = field[5];
+  return true;
+}
+
+static void put_u16(uint16_t value) {
+  char digits[6];
+  uint8_t n = sizeof(digits) - 1;
+  digits[n] = '\0';
+  do {
+    digits[--n] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value);
+  stim_uart_puts(&digits[n]);
+}
+
+static bool handle_command(const char *line) {
+  switch (line[0]) {
+  case 'C':
+    g_staging.step_count = 0;
+    return line[1] == '\0';
+  case 'S':
+    if (g_staging.step_count >= STIM_MAX_STEPS ||
+        !parse_step(&line[1], &g_staging.steps[g_staging.step_count])) {
+      return false;
+    }
+    g_staging.step_count++;
+    return true;
+  case 'G':
+    return line[1] == '\0' && stim_program_load(&g_staging) == STIM_SUCCESS;
+  case '?':
+    stim_uart_puts("slot ");
+    put_u16(stim_active_slot());
+    stim_uart_puts(" steps ");
+    put_u16(g_staging.step_count);
+    stim_uart_puts(" corrections ");
+    put_u16(stim_charge_corrections());
+    stim_uart_puts(" late ");
+    put_u16(stim_charge_late());
+#ifdef STIM_INSTRUMENT
+    stim_uart_puts(" isr ");
+    put_u16(stim_isr_max_cycles());
+    stim_uart_puts(" fit ");
+    put_u16(stim_service_max_cycles());
+#endif
+    stim_uart_puts(stim_swap_pending() ? " pending\r\n" : "\r\n");
+    return true;
+  default:
+    return false;
+  }
+}
 
 int main(void) {
   WDTCTL = WDTPW | WDTHOLD; // Stop WDT
@@ -51,64 +161,38 @@ int main(void) {
 
   CSCTL4 = SELMS__DCOCLKDIV | SELA__REFOCLK; // set ACLK = REFOCLK = 32768Hz,
                                              // DCOCLK as MCLK and SMCLK source
-  CSCTL5 |= DIVM0 | DIVS0;                   // SMCLK = MCLK = DCODIV = 4MHz
+  CSCTL5 &= ~(DIVM_7 | DIVS_3);              // SMCLK = MCLK = DCODIV = 4MHz
 
   // Configure GPIO
-  P1DIR |= BIT0 | BIT1; // Set P1.0 and P1.1 as outputs
-  P1OUT |= BIT0;        // Turn RED LED on initially (Cathodic phase)
-  P1OUT &= ~BIT1;       // Turn GREEN LED off initially
+  P1DIR |= BIT0 | BIT1;    // Set P1.0 and P1.1 as outputs
+  P1OUT &= ~(BIT0 | BIT1); // Both LEDs off until the first edge
+  stim_uart_init();
 
   // Disable the GPIO power-on default high-impedance mode to activate
   // previously configured port settings
   PM5CTL0 &= ~LOCKLPM5;
 
-  // Configure Timer_A
-  TA0CTL = TASSEL_1 | MC_2 | TACLR |
-           TAIE; // ACLK, continuous mode, clear TAR, enable interrupt
+  stim_sequencer_start();
 
-  __bis_SR_register(LPM3_bits | GIE); // Enter LPM3, enable interrupts
-  __no_operation();                   // For debugger
-}
+  while (1) {
+    stim_sequencer_service(); // Charge balance for the next pulse
 
-// Timer0_A3 Interrupt Vector (TAIV) handler
-#if defined(__TI_COMPILER_VERSION__) || defined(__IAR_SYSTEMS_ICC__)
-#pragma vector = TIMER0_A1_VECTOR
-__interrupt void TIMER0_A1_ISR(void)
-#elif defined(__GNUC__)
-void __attribute__((interrupt(TIMER0_A1_VECTOR))) TIMER0_A1_ISR(void)
-#else
-#error Compiler not supported!
-#endif
-{
-  switch (__even_in_range(TA0IV, TA0IV_TAIFG)) {
-  case TA0IV_NONE:
-    break; // No interrupt
-  case TA0IV_TACCR1:
-    break; // CCR1 not used
-  case TA0IV_TACCR2:
-    break; // CCR2 not used
-  case TA0IV_TAIFG:
-    counter++; // Increment counter
-
-    if (currentPhase == 0) { // Currently in Cathodic phase (Red LED)
-      if (counter >= CATHODIC_ON_TIME) {
-        // Switch to Anodic phase
-        P1OUT &= ~BIT0;   // Turn off RED LED
-        P1OUT |= BIT1;    // Turn on GREEN LED
-        counter = 0;      // Reset counter
-        currentPhase = 1; // Switch to Anodic phase
-      }
-    } else { // Currently in Anodic phase (Green LED)
-      if (counter >= ANODIC_ON_TIME) {
-        // Switch to Cathodic phase
-        P1OUT |= BIT0;    // Turn on RED LED
-        P1OUT &= ~BIT1;   // Turn off GREEN LED
-        counter = 0;      // Reset counter
-        currentPhase = 0; // Switch to Cathodic phase
+    // Sleep until a command line or a pulse arrives; check with GIE off so
+    // one that came just before sleeping still wakes us
+    __disable_interrupt();
+    const char *line = stim_uart_line();
+    if (!line) {
+      if (stim_service_pending()) {
+        __enable_interrupt();
+      } else {
+        __bis_SR_register(STIM_LPM_BITS | GIE); // Sleep, enable interrupts
+        __no_operation();                       // For debugger
       }
+      continue;
     }
-    break;
-  default:
-    break;
+    __enable_interrupt();
+
+    stim_uart_puts(handle_command(line) ? "OK\r\n" : "ERR\r\n");
+    stim_uart_release();
   }
 }